@@ -0,0 +1,282 @@
+#include "BarEngine.h"
+#include "Logger.h"
+#include <algorithm>
+#include <climits>
+
+namespace {
+const int64_t kSecondNs = 1000000000LL;
+}
+
+BarEngine::BarEngine(size_t capacity, const std::vector<int>& intervalsSeconds, Publish publish)
+    : publish(std::move(publish))
+    , published(0) {
+    for (int seconds : intervalsSeconds) {
+        if (seconds <= 0) {
+            LOG_WARN("Ignoring bar interval of {} seconds", seconds);
+            continue;
+        }
+        intervalSeconds.push_back(seconds);
+    }
+    std::sort(intervalSeconds.begin(), intervalSeconds.end());
+    intervalSeconds.erase(std::unique(intervalSeconds.begin(), intervalSeconds.end()), intervalSeconds.end());
+    if (intervalSeconds.empty()) {
+        return;
+    }
+
+    sources.assign(capacity, BarSource::Ticks);
+    requested.reset(new std::atomic<BarSource>[capacity]);
+    for (size_t i = 0; i < capacity; ++i) {
+        requested[i].store(BarSource::Ticks, std::memory_order_relaxed);
+    }
+    lastPrice.assign(capacity, 0.0);
+    series.resize(intervalSeconds.size());
+    for (size_t i = 0; i < series.size(); ++i) {
+        Series& s = series[i];
+        s.seconds = intervalSeconds[i];
+        s.lengthNs = s.seconds * kSecondNs;
+        s.takesRealTimeBars = s.seconds % kRealTimeBarSeconds == 0;
+        s.nextBucket = -1;
+        s.openCount = 0;
+        s.bucket.assign(capacity, -1);
+        s.open.assign(capacity, 0.0);
+        s.high.assign(capacity, 0.0);
+        s.low.assign(capacity, 0.0);
+        s.close.assign(capacity, 0.0);
+        s.volume.assign(capacity, 0.0);
+        s.notional.assign(capacity, 0.0);
+        s.trades.assign(capacity, 0);
+        s.wheel.resize(kWheelSlots);
+    }
+}
+
+void BarEngine::setSource(long tickerId, BarSource source) {
+    if (enabled() && inRange(tickerId)) {
+        requested[tickerId].store(source, std::memory_order_relaxed);
+    }
+}
+
+bool BarEngine::fedBy(int tickerId, BarSource source) {
+    BarSource wanted = requested[tickerId].load(std::memory_order_relaxed);
+    if (wanted != sources[tickerId]) {
+        // A bar half built from the other source is dropped rather than published
+        for (Series& s : series) {
+            if (s.bucket[tickerId] >= 0) {
+                s.bucket[tickerId] = -1;
+                --s.openCount;
+            }
+        }
+        sources[tickerId] = wanted;
+    }
+    return wanted == source;
+}
+
+void BarEngine::openBar(Series& s, int tickerId, int64_t bucket, double price) {
+    s.bucket[tickerId] = bucket;
+    s.open[tickerId] = price;
+    s.high[tickerId] = price;
+    s.low[tickerId] = price;
+    s.close[tickerId] = price;
+    s.volume[tickerId] = 0.0;
+    s.notional[tickerId] = 0.0;
+    s.trades[tickerId] = 0;
+    ++s.openCount;
+
+    // Bars fed by real-time bars are closed by their last 5 second bar instead
+    if (sources[tickerId] == BarSource::Ticks) {
+        s.wheel[static_cast<size_t>(bucket) % kWheelSlots].push_back(tickerId);
+        if (s.nextBucket < 0 || bucket < s.nextBucket) {
+            s.nextBucket = bucket;
+        }
+    }
+}
+
+void BarEngine::closeBar(Series& s, int tickerId) {
+    BarEvent bar;
+    bar.tickerId = tickerId;
+    bar.intervalSeconds = s.seconds;
+    bar.startNs = s.bucket[tickerId] * s.lengthNs;
+    bar.open = s.open[tickerId];
+    bar.high = s.high[tickerId];
+    bar.low = s.low[tickerId];
+    bar.close = s.close[tickerId];
+    bar.volume = s.volume[tickerId];
+    bar.vwap = bar.volume > 0.0 ? s.notional[tickerId] / bar.volume : bar.close;
+    bar.trades = s.trades[tickerId];
+
+    s.bucket[tickerId] = -1;
+    --s.openCount;
+    ++published;
+    if (publish) {
+        publish(bar);
+    }
+}
+
+void BarEngine::onTradePrice(long tickerId, double price, int64_t nowNs) {
+    if (!enabled() || !inRange(tickerId) || !(price > 0.0)) {
+        return;
+    }
+    int id = static_cast<int>(tickerId);
+    if (!fedBy(id, BarSource::Ticks)) {
+        return;
+    }
+    lastPrice[id] = price;
+
+    for (Series& s : series) {
+        int64_t bucket = nowNs / s.lengthNs;
+        int64_t current = s.bucket[id];
+        if (current >= 0 && current < bucket) {
+            // The wheel has not got to it yet
+            closeBar(s, id);
+            current = -1;
+        }
+        if (current < 0) {
+            openBar(s, id, bucket, price);
+            continue;
+        }
+        // Same bar (or the clock stepped back): fold it in
+        s.high[id] = std::max(s.high[id], price);
+        s.low[id] = std::min(s.low[id], price);
+        s.close[id] = price;
+    }
+}
+
+void BarEngine::onTradeSize(long tickerId, double size, int64_t nowNs) {
+    if (!enabled() || !inRange(tickerId) || !(size > 0.0)) {
+        return;
+    }
+    int id = static_cast<int>(tickerId);
+    if (!fedBy(id, BarSource::Ticks)) {
+        return;
+    }
+    double price = lastPrice[id];
+    if (!(price > 0.0)) {
+        return;
+    }
+
+    for (Series& s : series) {
+        int64_t bucket = nowNs / s.lengthNs;
+        int64_t current = s.bucket[id];
+        if (current >= 0 && current < bucket) {
+            closeBar(s, id);
+            current = -1;
+        }
+        if (current < 0) {
+            // A size on its own is another trade at the last price
+            openBar(s, id, bucket, price);
+        }
+        s.volume[id] += size;
+        s.notional[id] += size * price;
+        ++s.trades[id];
+    }
+}
+
+void BarEngine::onRealTimeBar(long tickerId, int64_t startNs, double open, double high, double low,
+                              double close, double volume, double wap, int count) {
+    if (!enabled() || !inRange(tickerId) || !(open > 0.0)) {
+        return;
+    }
+    int id = static_cast<int>(tickerId);
+    if (!fedBy(id, BarSource::RealTimeBars)) {
+        return;
+    }
+    const int64_t endNs = startNs + kRealTimeBarSeconds * kSecondNs;
+
+    for (Series& s : series) {
+        if (!s.takesRealTimeBars) {
+            continue;
+        }
+        int64_t bucket = startNs / s.lengthNs;
+        int64_t current = s.bucket[id];
+        if (current > bucket) {
+            continue;   // older than the bar being built
+        }
+        if (current >= 0 && current < bucket) {
+            // The last 5 second bar of that interval never arrived
+            closeBar(s, id);
+            current = -1;
+        }
+        if (current < 0) {
+            openBar(s, id, bucket, open);
+        }
+        s.high[id] = std::max(s.high[id], high);
+        s.low[id] = std::min(s.low[id], low);
+        s.close[id] = close;
+        s.volume[id] += volume;
+        s.notional[id] += volume * (wap > 0.0 ? wap : close);
+        s.trades[id] += count > 0 ? static_cast<uint32_t>(count) : 0;
+
+        if (endNs >= (bucket + 1) * s.lengthNs) {
+            closeBar(s, id);
+        }
+    }
+}
+
+void BarEngine::fireSlot(Series& s, int64_t slotBucket, int64_t currentBucket) {
+    std::vector<int>& slot = s.wheel[static_cast<size_t>(slotBucket) % kWheelSlots];
+    size_t kept = 0;
+    for (int id : slot) {
+        int64_t bucket = s.bucket[id];
+        if (bucket < 0 || sources[id] != BarSource::Ticks) {
+            continue;   // closed early by a later trade, or no longer tick-fed
+        }
+        if (bucket < currentBucket) {
+            closeBar(s, id);
+            continue;
+        }
+        // A later bar filed under the same slot
+        slot[kept++] = id;
+    }
+    slot.resize(kept);
+}
+
+size_t BarEngine::advance(int64_t nowNs) {
+    uint64_t before = published;
+    for (Series& s : series) {
+        if (s.nextBucket < 0) {
+            continue;
+        }
+        int64_t currentBucket = nowNs / s.lengthNs;
+        if (s.openCount == 0) {
+            s.nextBucket = std::max(s.nextBucket, currentBucket);
+            continue;
+        }
+        if (currentBucket - s.nextBucket >= static_cast<int64_t>(kWheelSlots)) {
+            // Behind by a whole turn of the wheel: every slot is due
+            for (size_t slot = 0; slot < kWheelSlots; ++slot) {
+                fireSlot(s, static_cast<int64_t>(slot), currentBucket);
+            }
+            s.nextBucket = currentBucket;
+            continue;
+        }
+        for (; s.nextBucket < currentBucket; ++s.nextBucket) {
+            fireSlot(s, s.nextBucket, currentBucket);
+        }
+    }
+    return static_cast<size_t>(published - before);
+}
+
+int64_t BarEngine::nextCloseNs() const {
+    int64_t next = INT64_MAX;
+    for (const Series& s : series) {
+        if (s.openCount > 0 && s.nextBucket >= 0) {
+            next = std::min(next, (s.nextBucket + 1) * s.lengthNs);
+        }
+    }
+    return next;
+}
+
+void BarEngine::clear() {
+    for (Series& s : series) {
+        std::fill(s.bucket.begin(), s.bucket.end(), -1);
+        for (std::vector<int>& slot : s.wheel) {
+            slot.clear();
+        }
+        s.nextBucket = -1;
+        s.openCount = 0;
+    }
+    std::fill(sources.begin(), sources.end(), BarSource::Ticks);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        requested[i].store(BarSource::Ticks, std::memory_order_relaxed);
+    }
+    std::fill(lastPrice.begin(), lastPrice.end(), 0.0);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "EventRing.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Where a ticker's bars come from.
+enum class BarSource : uint8_t {
+    Ticks,              // LAST / LAST_SIZE ticks of the market data subscription
+    RealTimeBars        // 5 second bars from reqRealTimeBars
+};
+
+// Incremental OHLCV bars for every ticker id and each configured interval.
+//
+// Each interval is a series of parallel arrays indexed by ticker id (open,
+// high, low, close, volume, notional, trades and the bucket of the open bar),
+// so folding a trade into all intervals is a few stores per interval. Bars are
+// closed by one timer wheel per interval rather than per-ticker timers: the
+// first trade of a bar files the ticker under its closing boundary, and
+// advance() closes everything filed under the boundaries that have passed.
+// A trade for a later bucket closes the ticker's open bar on the spot.
+// Tickers fed by real-time bars fold the 5 second bars into intervals that are
+// a multiple of 5 seconds and close a bar when its last 5 second bar arrives.
+// Completed bars are handed to the publish callback. Apart from setSource()
+// it is not thread-safe; the connector calls it from the message processing
+// thread only.
+class BarEngine {
+public:
+    static constexpr int kRealTimeBarSeconds = 5;
+
+    using Publish = std::function<void(const BarEvent& bar)>;
+
+    // Ticker ids 0..capacity-1; an empty interval list disables the engine.
+    BarEngine(size_t capacity, const std::vector<int>& intervalsSeconds, Publish publish);
+
+    bool enabled() const { return !series.empty(); }
+    bool inRange(long tickerId) const { return tickerId >= 0 && static_cast<size_t>(tickerId) < sources.size(); }
+    const std::vector<int>& intervals() const { return intervalSeconds; }
+
+    // Safe from any thread; applied with the ticker's next update, dropping a
+    // bar half built from the old source. Ticks of tickers using real-time
+    // bars are ignored, and the other way round.
+    void setSource(long tickerId, BarSource source);
+
+    // LAST price, then the LAST_SIZE that follows it; nowNs is the receive time.
+    void onTradePrice(long tickerId, double price, int64_t nowNs);
+    void onTradeSize(long tickerId, double size, int64_t nowNs);
+    // A 5 second bar starting at startNs.
+    void onRealTimeBar(long tickerId, int64_t startNs, double open, double high, double low, double close,
+                       double volume, double wap, int count);
+
+    // Closes tick-fed bars whose interval ended at or before nowNs. Returns the
+    // number of bars published.
+    size_t advance(int64_t nowNs);
+    // Earliest boundary at which advance() has a bar to close, INT64_MAX if none.
+    int64_t nextCloseNs() const;
+
+    // Drops open bars without publishing them.
+    void clear();
+    uint64_t barsPublished() const { return published; }
+
+private:
+    static constexpr size_t kWheelSlots = 16;
+
+    struct Series {
+        int seconds;
+        int64_t lengthNs;
+        bool takesRealTimeBars;                 // a multiple of kRealTimeBarSeconds
+        int64_t nextBucket;                     // first bucket the wheel has not closed yet
+        size_t openCount;                       // tick-fed bars on the wheel
+
+        // One entry per ticker id; bucket is -1 when no bar is open
+        std::vector<int64_t> bucket;
+        std::vector<double> open;
+        std::vector<double> high;
+        std::vector<double> low;
+        std::vector<double> close;
+        std::vector<double> volume;
+        std::vector<double> notional;           // sum of price * size, for the VWAP
+        std::vector<uint32_t> trades;
+
+        // Tickers whose bar closes at the end of bucket b are filed under b % kWheelSlots
+        std::vector<std::vector<int>> wheel;
+    };
+
+    std::vector<int> intervalSeconds;
+    std::vector<Series> series;
+    std::vector<BarSource> sources;             // as applied on the processing thread
+    std::unique_ptr<std::atomic<BarSource>[]> requested;    // set by setSource()
+    std::vector<double> lastPrice;              // last trade price, for the size tick that follows
+    Publish publish;
+    uint64_t published;
+
+    bool fedBy(int tickerId, BarSource source);
+    void openBar(Series& s, int tickerId, int64_t bucket, double price);
+    void closeBar(Series& s, int tickerId);
+    void fireSlot(Series& s, int64_t slotBucket, int64_t currentBucket);
+};
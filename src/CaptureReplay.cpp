@@ -0,0 +1,73 @@
+#include "CaptureReplay.h"
+#include "Clock.h"
+#include "Logger.h"
+#include "ThreadTuning.h"
+#include "EDecoder.h"
+#include <chrono>
+#include <thread>
+
+namespace {
+// Sleep only when the next frame is further out than this; spin for shorter gaps
+const int64_t kSleepThresholdNs = 200000;
+
+// Handshake-only callbacks; a capture starts after the handshake so they never fire
+class NullMsgSink : public EClientMsgSink {
+public:
+    void serverVersion(int, const char*) override {}
+    void redirect(const char*, int) override {}
+};
+}
+
+bool CaptureReplay::open(const std::string& path) {
+    if (!reader.open(path)) {
+        return false;
+    }
+    LOG_INFO("Opened capture {}: {} frames, server version {}", path, reader.header().recordCount,
+             reader.header().serverVersion);
+    return true;
+}
+
+ReplayResult CaptureReplay::run(EWrapper& wrapper, double speed, const std::atomic<bool>* stop) {
+    ReplayResult result;
+    const FrameHeader* record = reader.first();
+    if (!record) {
+        return result;
+    }
+
+    NullMsgSink sink;
+    EDecoder decoder(reader.header().serverVersion, &wrapper, &sink);
+
+    const int64_t firstReceiveNs = record->receiveNs;
+    int64_t lastReceiveNs = firstReceiveNs;
+    const int64_t startNs = monotonicNanos();
+
+    for (; record; record = reader.next(record)) {
+        if (stop && stop->load(std::memory_order_relaxed)) {
+            break;
+        }
+
+        if (speed > 0.0) {
+            int64_t dueNs = startNs + static_cast<int64_t>((record->receiveNs - firstReceiveNs) / speed);
+            int64_t nowNs = monotonicNanos();
+            if (dueNs - nowNs > kSleepThresholdNs) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(dueNs - nowNs - kSleepThresholdNs / 2));
+            }
+            while ((nowNs = monotonicNanos()) < dueNs) {
+                cpuRelax();
+            }
+            if (nowNs - dueNs > result.maxLagNs) {
+                result.maxLagNs = nowNs - dueNs;
+            }
+        }
+
+        const char* begin = record->payload();
+        decoder.parseAndProcessMsg(begin, record->payload() + record->length);
+        result.messages += 1;
+        result.bytes += record->length;
+        lastReceiveNs = record->receiveNs;
+    }
+
+    result.elapsedSeconds = (monotonicNanos() - startNs) / 1e9;
+    result.recordedSeconds = (lastReceiveNs - firstReceiveNs) / 1e9;
+    return result;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "FrameCapture.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+class EWrapper;
+
+struct ReplayResult {
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    double elapsedSeconds = 0.0;
+    double recordedSeconds = 0.0;   // span between the first and last captured frame
+    int64_t maxLagNs = 0;           // worst delay behind the paced schedule
+};
+
+// Feeds a capture file back through EDecoder into an EWrapper, so a recorded
+// session reaches the same callbacks it did live.
+//
+// speed 1.0 reproduces the recorded inter-arrival times, 2.0 plays twice as fast
+// and 0 dispatches back to back to measure decoder and callback throughput.
+class CaptureReplay {
+public:
+    bool open(const std::string& path);
+
+    int serverVersion() const { return reader.header().serverVersion; }
+    uint64_t recordCount() const { return reader.header().recordCount; }
+
+    // Runs on the calling thread. Returns early if stop becomes true.
+    ReplayResult run(EWrapper& wrapper, double speed, const std::atomic<bool>* stop = nullptr);
+
+private:
+    CaptureReader reader;
+};
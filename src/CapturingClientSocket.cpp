@@ -0,0 +1,27 @@
+#include "CapturingClientSocket.h"
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+thread_local std::string* captureTarget = nullptr;
+}
+
+std::string* CapturingClientSocket::redirect(std::string* target) {
+    std::string* previous = captureTarget;
+    captureTarget = target;
+    return previous;
+}
+
+bool CapturingClientSocket::closeAndSend(std::string msg, unsigned offset) {
+    if (!captureTarget) {
+        return EClientSocket::closeAndSend(std::move(msg), offset);
+    }
+
+    // API v100+ framing: prepareBuffer reserved 4 bytes at offset for the
+    // big-endian length of what follows
+    uint32_t header = htonl(static_cast<uint32_t>(msg.size() - offset - sizeof(uint32_t)));
+    std::memcpy(&msg[offset], &header, sizeof(header));
+    captureTarget->append(msg);
+    return true;
+}
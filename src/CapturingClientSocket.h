@@ -0,0 +1,31 @@
+#pragma once
+
+#include "EClientSocket.h"
+#include <string>
+
+// EClientSocket whose requests can be encoded without being sent.
+//
+// capture() runs EClient calls on the calling thread and appends their framed
+// wire bytes to a buffer instead of writing them to the socket, so a request
+// is encoded by the thread that makes it and written by the sender thread.
+// Encoding only reads the negotiated server version, so any number of threads
+// may capture at once. Outside capture() requests are sent as usual, which is
+// what the handshake in eConnect() relies on.
+class CapturingClientSocket : public EClientSocket {
+public:
+    using EClientSocket::EClientSocket;
+
+    template <typename Request>
+    void capture(std::string& out, Request&& request) {
+        std::string* previous = redirect(&out);
+        request();
+        redirect(previous);
+    }
+
+protected:
+    bool closeAndSend(std::string msg, unsigned offset = 0) override;
+
+private:
+    // Sets the calling thread's capture buffer (nullptr: send); returns the previous one
+    static std::string* redirect(std::string* target);
+};
@@ -0,0 +1,180 @@
+#include "ConnectionPool.h"
+#include "Logger.h"
+
+namespace {
+uint64_t symbolHash(const std::string& symbol) {
+    // FNV-1a, so a symbol lands on the same shard in every session
+    uint64_t hash = 1469598103934665603ULL;
+    for (char c : symbol) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    }
+    return hash;
+}
+}
+
+ConnectionPool::ConnectionPool(const ConnectorSettings& settings)
+    : settings(settings)
+    , quotes(std::make_shared<QuoteStore>()) {
+    int shards = settings.pool.marketDataConnections > 0 ? settings.pool.marketDataConnections : 0;
+
+    ConnectorSettings orderSettings = settings;
+    if (shards > 0) {
+        orderSettings.tickHistoryDirectory.clear();     // no market data on this connection
+    }
+    orderConnection = std::make_shared<IBConnector>(orderSettings, ConnectionRole::Orders, quotes);
+
+    // Market data connections only subscribe; pinning applies to the order connection
+    ConnectorSettings feedSettings = settings;
+    feedSettings.contractIndexFile.clear();
+    feedSettings.readerThread.cpu = -1;
+    feedSettings.processingThread.cpu = -1;
+    feedSettings.outbound.senderThread.cpu = -1;
+    for (int i = 0; i < shards; ++i) {
+        auto feed = std::make_shared<IBConnector>(feedSettings, ConnectionRole::MarketData, quotes);
+        feed->setPositionOwner(orderConnection.get());
+        feeds.push_back(std::move(feed));
+    }
+    if (feeds.empty()) {
+        feeds.push_back(orderConnection);
+    }
+}
+
+ConnectionPool::~ConnectionPool() {
+    disconnect();
+}
+
+bool ConnectionPool::connect(const std::string& host, int port, int clientId) {
+    if (!orderConnection->connect(host, port, clientId)) {
+        return false;
+    }
+    if (feeds.front() == orderConnection) {
+        return true;
+    }
+
+    int firstClientId = settings.pool.firstMarketDataClientId > 0 ? settings.pool.firstMarketDataClientId : clientId + 1;
+    size_t connectedFeeds = 0;
+    for (size_t i = 0; i < feeds.size(); ++i) {
+        if (feeds[i]->connect(host, port, firstClientId + static_cast<int>(i))) {
+            ++connectedFeeds;
+        } else {
+            LOG_WARN("Market data connection {} (client ID {}) failed - routing around it", i,
+                     firstClientId + static_cast<int>(i));
+        }
+    }
+    LOG_INFO("Connection pool up: order connection plus {}/{} market data connections", connectedFeeds, feeds.size());
+    return true;
+}
+
+void ConnectionPool::disconnect() {
+    // Writers to the shared quote store stop before it is cleared
+    for (auto& feed : feeds) {
+        if (feed != orderConnection) {
+            feed->disconnect();
+        }
+    }
+    orderConnection->disconnect();
+    quotes->clear();
+
+    std::lock_guard<std::mutex> lock(routeMutex);
+    quoteRoutes.clear();
+    depthRoutes.clear();
+}
+
+int ConnectionPool::pickShard(const Contract& contract, int shard) const {
+    int count = static_cast<int>(feeds.size());
+    int first = shard >= 0 ? shard % count : static_cast<int>(symbolHash(contract.symbol) % count);
+    // Next connected shard if the preferred one is down
+    for (int i = 0; i < count; ++i) {
+        int candidate = (first + i) % count;
+        if (feeds[candidate]->isConnected()) {
+            return candidate;
+        }
+    }
+    return -1;
+}
+
+int ConnectionPool::requestMarketData(int tickerId, const Contract& contract, int shard) {
+    std::lock_guard<std::mutex> lock(routeMutex);
+    // A ticker id must only ever have one writer in the shared store
+    auto existing = quoteRoutes.find(tickerId);
+    if (existing != quoteRoutes.end()) {
+        feeds[existing->second]->cancelMarketData(tickerId);
+        quoteRoutes.erase(existing);
+    }
+
+    int chosen = pickShard(contract, shard);
+    if (chosen < 0) {
+        LOG_WARN("No market data connection up - cannot subscribe {} (ID: {})", contract.symbol, tickerId);
+        return -1;
+    }
+    feeds[chosen]->requestMarketData(tickerId, contract);
+    quoteRoutes[tickerId] = chosen;
+    return chosen;
+}
+
+void ConnectionPool::cancelMarketData(int tickerId) {
+    std::lock_guard<std::mutex> lock(routeMutex);
+    auto it = quoteRoutes.find(tickerId);
+    if (it != quoteRoutes.end()) {
+        feeds[it->second]->cancelMarketData(tickerId);
+        quoteRoutes.erase(it);
+    }
+}
+
+int ConnectionPool::requestMarketDepth(int tickerId, const Contract& contract, int numRows, bool smartDepth,
+                                       int shard) {
+    std::lock_guard<std::mutex> lock(routeMutex);
+    auto existing = depthRoutes.find(tickerId);
+    if (existing != depthRoutes.end()) {
+        feeds[existing->second]->cancelMarketDepth(tickerId);
+        depthRoutes.erase(existing);
+    }
+
+    int chosen = pickShard(contract, shard);
+    if (chosen < 0) {
+        LOG_WARN("No market data connection up - cannot request depth for {} (ID: {})", contract.symbol, tickerId);
+        return -1;
+    }
+    feeds[chosen]->requestMarketDepth(tickerId, contract, numRows, smartDepth);
+    depthRoutes[tickerId] = chosen;
+    return chosen;
+}
+
+void ConnectionPool::cancelMarketDepth(int tickerId) {
+    std::lock_guard<std::mutex> lock(routeMutex);
+    auto it = depthRoutes.find(tickerId);
+    if (it != depthRoutes.end()) {
+        feeds[it->second]->cancelMarketDepth(tickerId);
+        depthRoutes.erase(it);
+    }
+}
+
+int ConnectionPool::quoteShard(int tickerId) const {
+    std::lock_guard<std::mutex> lock(routeMutex);
+    auto it = quoteRoutes.find(tickerId);
+    return it == quoteRoutes.end() ? -1 : it->second;
+}
+
+bool ConnectionPool::getOrderBook(TickerId tickerId, BookSnapshot& out, int maxLevels) const {
+    int shard;
+    {
+        std::lock_guard<std::mutex> lock(routeMutex);
+        auto it = depthRoutes.find(static_cast<int>(tickerId));
+        if (it == depthRoutes.end()) {
+            return false;
+        }
+        shard = it->second;
+    }
+    return feeds[shard]->getOrderBook(tickerId, out, maxLevels);
+}
+
+std::vector<ConnectorStats> ConnectionPool::stats() const {
+    std::vector<ConnectorStats> all;
+    all.push_back(orderConnection->stats());
+    for (const auto& feed : feeds) {
+        if (feed != orderConnection) {
+            all.push_back(feed->stats());
+        }
+    }
+    return all;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "IBConnector.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Several API connections to one gateway behind a single quote view.
+//
+// Orders, accounts and positions go over a dedicated order connection (the
+// configured clientId), so order traffic never queues behind market data
+// decoding. Market data and depth subscriptions are sharded over
+// pool.marketDataConnections further connections (consecutive clientIds), each
+// with its own reader and processing thread and its own per-client line and
+// pacing limits. All of them write to one shared QuoteStore, so getQuote()
+// and the order connection's risk checks see every ticker, and their ticks
+// re-mark the positions held on the order connection.
+class ConnectionPool {
+public:
+    explicit ConnectionPool(const ConnectorSettings& settings = ConnectorSettings());
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Fails only if the order connection fails; market data connections that
+    // cannot connect are skipped when routing.
+    bool connect(const std::string& host, int port, int clientId);
+    void disconnect();
+    bool isConnected() const { return orderConnection->isConnected(); }
+
+    std::shared_ptr<IBConnector> orders() const { return orderConnection; }
+    size_t shardCount() const { return feeds.size(); }
+    std::shared_ptr<IBConnector> shard(size_t index) const { return feeds[index]; }
+
+    // Subscribes on the given shard, or on the symbol's hash shard when shard < 0.
+    // Returns the shard used, or -1 when no market data connection is up.
+    int requestMarketData(int tickerId, const Contract& contract, int shard = -1);
+    void cancelMarketData(int tickerId);
+    int requestMarketDepth(int tickerId, const Contract& contract, int numRows = 10, bool smartDepth = true,
+                           int shard = -1);
+    void cancelMarketDepth(int tickerId);
+    // Shard a subscription lives on, -1 if none
+    int quoteShard(int tickerId) const;
+
+    Quote getQuote(TickerId tickerId) const { return quotes->get(tickerId); }
+    size_t quoteCapacity() const { return quotes->capacity(); }
+    bool getOrderBook(TickerId tickerId, BookSnapshot& out, int maxLevels = OrderBookStore::kMaxLevels) const;
+
+    // Order connection first, then each market data connection
+    std::vector<ConnectorStats> stats() const;
+
+private:
+    ConnectorSettings settings;
+    std::shared_ptr<QuoteStore> quotes;
+    std::shared_ptr<IBConnector> orderConnection;
+    std::vector<std::shared_ptr<IBConnector>> feeds;    // market data connections; the order connection if none
+
+    mutable std::mutex routeMutex;
+    std::unordered_map<int, int> quoteRoutes;           // tickerId -> shard
+    std::unordered_map<int, int> depthRoutes;
+
+    int pickShard(const Contract& contract, int shard) const;
+};
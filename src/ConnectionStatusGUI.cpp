@@ -231,8 +231,9 @@ void ConnectionStatusGUI::setupUI() {
     QGroupBox* positionsGroup = new QGroupBox("Positions", this);
     QVBoxLayout* positionsLayout = new QVBoxLayout(positionsGroup);
     
-    positionsTable = new QTableWidget(0, 5, this);
-    positionsTable->setHorizontalHeaderLabels(QStringList() << "Account" << "Symbol" << "Position" << "Avg Cost" << "Value");
+    positionsTable = new QTableWidget(0, 8, this);
+    positionsTable->setHorizontalHeaderLabels(QStringList() << "Account" << "Symbol" << "Position" << "Avg Cost"
+                                              << "Mkt Price" << "Value" << "Unrealized P&L" << "Realized P&L");
     positionsTable->horizontalHeader()->setStretchLastSection(true);
     positionsTable->setAlternatingRowColors(true);
     positionsTable->setStyleSheet(
@@ -402,15 +403,15 @@ void ConnectionStatusGUI::updateMarketData() {
         return;
     }
     
-    auto prices = ibConnector->getTickPrices();
+    // AAPL is subscribed on ticker ID 1 by IBConnector::connect
+    Quote quote = ibConnector->getQuote(1);
     
     if (marketDataLabel) {
         QString marketText = "AAPL Market Data (Delayed)\n";
         
-        // Field IDs: 1=BID, 2=ASK, 4=LAST
-        double bid = prices.count(101) ? prices[101] : 0.0;  // tickerId(1) * 100 + field(1)
-        double ask = prices.count(102) ? prices[102] : 0.0;  // tickerId(1) * 100 + field(2)
-        double last = prices.count(104) ? prices[104] : 0.0; // tickerId(1) * 100 + field(4)
+        double bid = quote.bid;
+        double ask = quote.ask;
+        double last = quote.last;
         
         if (bid > 0) marketText += QString("Bid: $%1  ").arg(bid, 0, 'f', 2);
         else marketText += "Bid: --  ";
@@ -430,8 +431,21 @@ void ConnectionStatusGUI::updateAccountData() {
         return;
     }
     
-    // Update account summary table
-    auto accountSummary = ibConnector->getAccountSummary();
+    // Tables are only rebuilt when a newer snapshot has been published
+    auto accountSummary = ibConnector->accountSummarySnapshot();
+    if (accountSummary->version != shownAccountSummaryVersion) {
+        shownAccountSummaryVersion = accountSummary->version;
+        updateAccountTable(accountSummary->value);
+    }
+    
+    auto positions = ibConnector->positionsSnapshot();
+    if (positions->version != shownPositionsVersion) {
+        shownPositionsVersion = positions->version;
+        updatePositionsTable(positions->value);
+    }
+}
+
+void ConnectionStatusGUI::updateAccountTable(const std::vector<IBConnector::AccountSummaryItem>& accountSummary) {
     accountTable->setRowCount(0);
     
     for (const auto& item : accountSummary) {
@@ -454,9 +468,9 @@ void ConnectionStatusGUI::updateAccountData() {
         currencyItem->setForeground(Qt::black);
         accountTable->setItem(row, 3, currencyItem);
     }
-    
-    // Update positions table
-    auto positions = ibConnector->getPositions();
+}
+
+void ConnectionStatusGUI::updatePositionsTable(const std::vector<IBConnector::PositionItem>& positions) {
     positionsTable->setRowCount(0);
     
     for (const auto& pos : positions) {
@@ -479,9 +493,22 @@ void ConnectionStatusGUI::updateAccountData() {
         avgCostItem->setForeground(Qt::black);
         positionsTable->setItem(row, 3, avgCostItem);
         
-        double value = pos.position * pos.avgCost;
-        auto* valueItem = new QTableWidgetItem(QString::number(value, 'f', 2));
+        // Market columns stay blank until the position has been marked
+        bool marked = pos.marketPrice > 0.0;
+        auto* priceItem = new QTableWidgetItem(marked ? QString::number(pos.marketPrice, 'f', 2) : QString("-"));
+        priceItem->setForeground(Qt::black);
+        positionsTable->setItem(row, 4, priceItem);
+        
+        auto* valueItem = new QTableWidgetItem(marked ? QString::number(pos.marketValue, 'f', 2) : QString("-"));
         valueItem->setForeground(Qt::black);
-        positionsTable->setItem(row, 4, valueItem);
+        positionsTable->setItem(row, 5, valueItem);
+        
+        auto* unrealizedItem = new QTableWidgetItem(marked ? QString::number(pos.unrealizedPnl, 'f', 2) : QString("-"));
+        unrealizedItem->setForeground(pos.unrealizedPnl < 0.0 ? Qt::red : Qt::black);
+        positionsTable->setItem(row, 6, unrealizedItem);
+        
+        auto* realizedItem = new QTableWidgetItem(QString::number(pos.realizedPnl, 'f', 2));
+        realizedItem->setForeground(pos.realizedPnl < 0.0 ? Qt::red : Qt::black);
+        positionsTable->setItem(row, 7, realizedItem);
     }
 }
\ No newline at end of file
@@ -6,13 +6,14 @@
 #include <QTextEdit>
 #include <QTimer>
 #include <QTableWidget>
+#include "IBConnector.h"
+#include <cstdint>
 #include <memory>
 #include <atomic>
 #include <mutex>
 #include <queue>
 #include <string>
-
-class IBConnector;
+#include <vector>
 
 namespace Ui {
 class ConnectionStatusGUI;
@@ -48,6 +49,8 @@ private:
     QLabel* marketDataLabel;
     QTableWidget* accountTable;
     QTableWidget* positionsTable;
+    uint64_t shownAccountSummaryVersion = 0;
+    uint64_t shownPositionsVersion = 0;
     
     // Thread-safe log message queue
     std::mutex logMutex;
@@ -58,4 +61,6 @@ private:
     
     void setupUI();
     void updateUIState(bool connected);
+    void updateAccountTable(const std::vector<IBConnector::AccountSummaryItem>& accountSummary);
+    void updatePositionsTable(const std::vector<IBConnector::PositionItem>& positions);
 };
\ No newline at end of file
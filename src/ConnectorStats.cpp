@@ -0,0 +1,244 @@
+#include "ConnectorStats.h"
+#include "Logger.h"
+
+LatencyHistogram::LatencyHistogram()
+    : counts(new std::atomic<uint64_t>[kBucketCount])
+    , total(0)
+    , sum(0)
+    , maxValue(0) {
+    reset();
+}
+
+int LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < static_cast<uint64_t>(kSubBuckets)) {
+        return static_cast<int>(value);
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - kSubBucketBits;
+    int sub = static_cast<int>(value >> shift) - kSubBuckets;
+    return kSubBuckets + shift * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < kSubBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = (index - kSubBuckets) / kSubBuckets;
+    uint64_t sub = static_cast<uint64_t>((index - kSubBuckets) % kSubBuckets);
+    uint64_t lower = (static_cast<uint64_t>(kSubBuckets) + sub) << shift;
+    return lower + ((static_cast<uint64_t>(1) << shift) - 1);
+}
+
+void LatencyHistogram::record(int64_t valueNs) {
+    uint64_t value = valueNs > 0 ? static_cast<uint64_t>(valueNs) : 0;
+    bump(counts[bucketIndex(value)], 1);
+    bump(total, 1);
+    bump(sum, value);
+    if (valueNs > maxValue.load(std::memory_order_relaxed)) {
+        maxValue.store(valueNs, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::recordConcurrent(int64_t valueNs) {
+    uint64_t value = valueNs > 0 ? static_cast<uint64_t>(valueNs) : 0;
+    counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+    int64_t seen = maxValue.load(std::memory_order_relaxed);
+    while (valueNs > seen && !maxValue.compare_exchange_weak(seen, valueNs, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (int i = 0; i < kBucketCount; ++i) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n ? static_cast<double>(sum.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+int64_t LatencyHistogram::percentile(double pct) const {
+    // Sum the buckets rather than trusting total, which may be a few records ahead
+    uint64_t n = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        n += counts[i].load(std::memory_order_relaxed);
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(pct / 100.0 * n + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            int64_t bound = static_cast<int64_t>(bucketUpperBound(i));
+            int64_t maxSeen = max();
+            return bound < maxSeen ? bound : maxSeen;
+        }
+    }
+    return max();
+}
+
+const char* callbackTypeName(CallbackType type) {
+    switch (type) {
+    case CallbackType::TickPrice: return "tickPrice";
+    case CallbackType::TickSize: return "tickSize";
+    case CallbackType::TickString: return "tickString";
+    case CallbackType::TickByTick: return "tickByTick";
+    case CallbackType::MarketDepth: return "marketDepth";
+    case CallbackType::OrderStatus: return "orderStatus";
+    case CallbackType::OpenOrder: return "openOrder";
+    case CallbackType::AccountSummary: return "accountSummary";
+    case CallbackType::Position: return "position";
+    case CallbackType::Error: return "error";
+    default: return "unknown";
+    }
+}
+
+const char* outboundPriorityName(OutboundPriority priority) {
+    switch (priority) {
+    case OutboundPriority::Cancel: return "cancel";
+    case OutboundPriority::Order: return "order";
+    case OutboundPriority::Subscription: return "subscription";
+    case OutboundPriority::History: return "history";
+    default: return "unknown";
+    }
+}
+
+LatencySummary summarize(const LatencyHistogram& histogram) {
+    LatencySummary summary;
+    summary.count = histogram.count();
+    summary.meanNs = histogram.mean();
+    summary.p50Ns = histogram.percentile(50.0);
+    summary.p99Ns = histogram.percentile(99.0);
+    summary.p999Ns = histogram.percentile(99.9);
+    summary.maxNs = histogram.max();
+    return summary;
+}
+
+namespace {
+double micros(int64_t ns) {
+    return static_cast<double>(ns) / 1000.0;
+}
+}
+
+StatsRecorder::StatsRecorder()
+    : messages(0)
+    , bytes(0)
+    , maxDepth(0)
+    , windowRate(0.0)
+    , windowStartNs(0)
+    , windowStartMessages(0)
+    , lastDumpNs(0) {
+}
+
+void StatsRecorder::recordMessage(int64_t queueWaitNs, uint32_t frameBytes) {
+    messages.store(messages.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    bytes.store(bytes.load(std::memory_order_relaxed) + frameBytes, std::memory_order_relaxed);
+    queueWait.record(queueWaitNs);
+}
+
+void StatsRecorder::recordQueueDepth(size_t depth) {
+    if (depth > maxDepth.load(std::memory_order_relaxed)) {
+        maxDepth.store(depth, std::memory_order_relaxed);
+    }
+}
+
+void StatsRecorder::recordCallback(CallbackType type, int64_t elapsedNs) {
+    // EClient reports send failures through error() on the calling thread, so
+    // that one can arrive from several threads at once
+    if (type == CallbackType::Error) {
+        callbackLatency[static_cast<size_t>(type)].recordConcurrent(elapsedNs);
+        return;
+    }
+    callbackLatency[static_cast<size_t>(type)].record(elapsedNs);
+}
+
+bool StatsRecorder::advance(int64_t nowNs, int64_t dumpIntervalNs) {
+    if (windowStartNs == 0) {
+        windowStartNs = nowNs;
+        lastDumpNs = nowNs;
+        return false;
+    }
+
+    int64_t elapsed = nowNs - windowStartNs;
+    if (elapsed >= 1000000000) {
+        uint64_t total = messages.load(std::memory_order_relaxed);
+        windowRate.store(static_cast<double>(total - windowStartMessages) * 1e9 / elapsed,
+                         std::memory_order_relaxed);
+        windowStartNs = nowNs;
+        windowStartMessages = total;
+    }
+
+    if (dumpIntervalNs > 0 && nowNs - lastDumpNs >= dumpIntervalNs) {
+        lastDumpNs = nowNs;
+        return true;
+    }
+    return false;
+}
+
+ConnectorStats StatsRecorder::snapshot(size_t currentQueueDepth) const {
+    ConnectorStats stats;
+    stats.messagesTotal = messages.load(std::memory_order_relaxed);
+    stats.bytesTotal = bytes.load(std::memory_order_relaxed);
+    stats.messagesPerSecond = windowRate.load(std::memory_order_relaxed);
+    stats.queueDepth = currentQueueDepth;
+    stats.maxQueueDepth = maxDepth.load(std::memory_order_relaxed);
+    stats.queueWait = summarize(queueWait);
+    for (size_t i = 0; i < callbackLatency.size(); ++i) {
+        stats.callbacks[i] = summarize(callbackLatency[i]);
+    }
+    return stats;
+}
+
+void logConnectorStats(const ConnectorStats& stats) {
+    LOG_INFO("Stats: {} msgs, {} bytes, {} msg/s, queue depth {} (max {})",
+             stats.messagesTotal, stats.bytesTotal, stats.messagesPerSecond,
+             stats.queueDepth, stats.maxQueueDepth);
+    LOG_INFO("  queue wait: n={} p50={}us p99={}us p99.9={}us max={}us",
+             stats.queueWait.count, micros(stats.queueWait.p50Ns), micros(stats.queueWait.p99Ns),
+             micros(stats.queueWait.p999Ns), micros(stats.queueWait.maxNs));
+
+    for (size_t i = 0; i < stats.callbacks.size(); ++i) {
+        const LatencySummary& s = stats.callbacks[i];
+        if (s.count == 0) {
+            continue;
+        }
+        LOG_INFO("  {}: n={} p50={}us p99={}us p99.9={}us max={}us",
+                 callbackTypeName(static_cast<CallbackType>(i)), s.count, micros(s.p50Ns),
+                 micros(s.p99Ns), micros(s.p999Ns), micros(s.maxNs));
+    }
+
+    const OutboundStats& out = stats.outbound;
+    if (out.sent > 0 || out.queued > 0) {
+        LOG_INFO("  outbound: {} sent in {} writes, {} queued, {} coalesced, {} throttled, {} rejected",
+                 out.sent, out.writes, out.queued, out.coalesced, out.throttled, out.rejected);
+        for (size_t i = 0; i < out.queueDelay.size(); ++i) {
+            const LatencySummary& s = out.queueDelay[i];
+            if (s.count == 0) {
+                continue;
+            }
+            LOG_INFO("  {} queue delay: n={} p50={}us p99={}us max={}us",
+                     outboundPriorityName(static_cast<OutboundPriority>(i)), s.count, micros(s.p50Ns),
+                     micros(s.p99Ns), micros(s.maxNs));
+        }
+    }
+
+    for (const EventConsumerStats& consumer : stats.eventConsumers) {
+        LOG_INFO("  event consumer {}: lag {}, dropped {}", consumer.name, consumer.lag, consumer.dropped);
+    }
+    if (stats.eventProducerStalls > 0) {
+        LOG_INFO("  event ring: producer waited for consumers {} times", stats.eventProducerStalls);
+    }
+}
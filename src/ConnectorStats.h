@@ -0,0 +1,173 @@
+#pragma once
+
+#include "Clock.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Log-linear latency histogram (HdrHistogram-style) over nanosecond values.
+//
+// Each power of two is split into 32 sub-buckets, so any recorded value is
+// reported within ~3% of its true value, from 1 ns up to the full int64 range,
+// in a fixed 15 KB of counters. record() is single-writer: the owning thread
+// uses plain relaxed load/store, with no locked instructions, so it can stay on
+// in production. Readers on other threads get a slightly stale but valid view.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kBucketCount = kSubBuckets + (64 - kSubBucketBits) * kSubBuckets;
+
+    LatencyHistogram();
+
+    void record(int64_t valueNs);
+    // For histograms written from more than one thread: locked increments.
+    void recordConcurrent(int64_t valueNs);
+    void reset();
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    int64_t max() const { return maxValue.load(std::memory_order_relaxed); }
+    double mean() const;
+    // Value at the given percentile (0-100), as the upper bound of its bucket.
+    int64_t percentile(double pct) const;
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> counts;
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum;
+    std::atomic<int64_t> maxValue;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(int index);
+
+    static void bump(std::atomic<uint64_t>& counter, uint64_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+};
+
+// EWrapper callbacks we time individually.
+enum class CallbackType {
+    TickPrice,
+    TickSize,
+    TickString,
+    TickByTick,
+    MarketDepth,
+    OrderStatus,
+    OpenOrder,
+    AccountSummary,
+    Position,
+    Error,
+    Count
+};
+
+const char* callbackTypeName(CallbackType type);
+
+// Outbound request classes, most urgent first.
+enum class OutboundPriority {
+    Cancel,         // order cancels
+    Order,          // placeOrder, including modifications
+    Subscription,   // market data, depth, account and other streaming requests
+    History,        // bulk lookups (contract details, historical data)
+    Count
+};
+
+const char* outboundPriorityName(OutboundPriority priority);
+
+struct LatencySummary {
+    uint64_t count = 0;
+    double meanNs = 0.0;
+    int64_t p50Ns = 0;
+    int64_t p99Ns = 0;
+    int64_t p999Ns = 0;
+    int64_t maxNs = 0;
+};
+
+LatencySummary summarize(const LatencyHistogram& histogram);
+
+// Outbound scheduler counters.
+struct OutboundStats {
+    size_t queued = 0;
+    uint64_t sent = 0;
+    uint64_t writes = 0;                // socket writes; each carries a batch of messages
+    uint64_t coalesced = 0;             // requests dropped because a later one made them redundant
+    uint64_t throttled = 0;             // times the sender waited for pacing tokens
+    uint64_t rejected = 0;              // orders and cancels refused because the command queue was full
+    std::array<LatencySummary, static_cast<size_t>(OutboundPriority::Count)> queueDelay;    // enqueue -> socket
+};
+
+// Progress of one EventRing consumer.
+struct EventConsumerStats {
+    std::string name;
+    uint64_t sequence = 0;              // next event to handle
+    uint64_t lag = 0;                   // published but not handled yet
+    uint64_t dropped = 0;               // skipped after being lapped (non-gating consumers only)
+};
+
+// Point-in-time copy of the connector counters returned by IBConnector::stats().
+struct ConnectorStats {
+    uint64_t messagesTotal = 0;
+    uint64_t bytesTotal = 0;
+    double messagesPerSecond = 0.0;     // over the last completed window (~1 s)
+    size_t queueDepth = 0;              // frames read but not yet dispatched
+    size_t maxQueueDepth = 0;           // high-water mark since the last dump
+    LatencySummary queueWait;           // socket read -> decode/dispatch
+    std::array<LatencySummary, static_cast<size_t>(CallbackType::Count)> callbacks;
+    OutboundStats outbound;
+    std::vector<EventConsumerStats> eventConsumers;
+    uint64_t eventProducerStalls = 0;   // times the callback thread waited for a gating consumer
+};
+
+// Counters written by the message processing thread only, except for the
+// Error callback timing (see recordCallback).
+class StatsRecorder {
+public:
+    StatsRecorder();
+
+    void recordMessage(int64_t queueWaitNs, uint32_t bytes);
+    void recordQueueDepth(size_t depth);
+    void recordCallback(CallbackType type, int64_t elapsedNs);
+
+    // Rolls the throughput window; returns true when a periodic dump is due.
+    bool advance(int64_t nowNs, int64_t dumpIntervalNs);
+    void resetMaxQueueDepth() { maxDepth.store(0, std::memory_order_relaxed); }
+
+    ConnectorStats snapshot(size_t currentQueueDepth) const;
+
+private:
+    std::atomic<uint64_t> messages;
+    std::atomic<uint64_t> bytes;
+    std::atomic<size_t> maxDepth;
+    std::atomic<double> windowRate;
+    LatencyHistogram queueWait;
+    std::array<LatencyHistogram, static_cast<size_t>(CallbackType::Count)> callbackLatency;
+
+    // Window bookkeeping, processing thread only
+    int64_t windowStartNs;
+    uint64_t windowStartMessages;
+    int64_t lastDumpNs;
+};
+
+// Times one callback invocation into the recorder.
+class CallbackTimer {
+public:
+    CallbackTimer(StatsRecorder& recorder, CallbackType type)
+        : recorder(recorder)
+        , type(type)
+        , startNs(monotonicNanos()) {
+    }
+
+    ~CallbackTimer() {
+        recorder.recordCallback(type, monotonicNanos() - startNs);
+    }
+
+private:
+    StatsRecorder& recorder;
+    CallbackType type;
+    int64_t startNs;
+};
+
+void logConnectorStats(const ConnectorStats& stats);
@@ -0,0 +1,334 @@
+#include "ContractRegistry.h"
+#include "Clock.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+
+namespace {
+const char kIndexMagic[8] = {'F', 'T', 'C', 'R', 'E', 'G', '1', '\0'};
+const uint32_t kIndexFormatVersion = 1;
+
+template <size_t N>
+void copyField(char (&out)[N], const std::string& value) {
+    size_t n = value.size() < N - 1 ? value.size() : N - 1;
+    std::memcpy(out, value.data(), n);
+    std::memset(out + n, 0, N - n);
+}
+
+bool symbolLess(const ContractRecord& record, const std::string& symbol) {
+    return std::strncmp(record.symbol, symbol.c_str(), sizeof(record.symbol)) < 0;
+}
+}
+
+void ContractRecord::toContract(Contract& out) const {
+    out.conId = static_cast<long>(conId);
+    out.symbol = symbol;
+    out.secType = secType;
+    out.currency = currency;
+    out.exchange = exchange;
+    out.primaryExchange = primaryExchange;
+    out.localSymbol = localSymbol;
+    out.tradingClass = tradingClass;
+}
+
+ContractRegistry::ContractRegistry()
+    : mappedRecords(nullptr)
+    , mappedIds(nullptr)
+    , mappedCount(0) {
+}
+
+ContractRegistry::~ContractRegistry() {
+    unmap();
+}
+
+void ContractRegistry::unmap() {
+    file.close();
+    mappedRecords = nullptr;
+    mappedIds = nullptr;
+    mappedCount = 0;
+}
+
+bool ContractRegistry::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    unmap();
+    indexPath = path;
+
+    FILE* probe = std::fopen(path.c_str(), "rb");
+    if (!probe) {
+        LOG_INFO("No contract index at {} yet - contracts will be resolved on demand", path);
+        return true;
+    }
+    std::fclose(probe);
+
+    if (!file.openRead(path)) {
+        return false;
+    }
+
+    const ContractIndexHeader* h = reinterpret_cast<const ContractIndexHeader*>(file.data());
+    if (file.size() < sizeof(ContractIndexHeader) ||
+        std::memcmp(h->magic, kIndexMagic, sizeof(kIndexMagic)) != 0 || h->formatVersion != kIndexFormatVersion) {
+        LOG_ERROR("{} is not a contract index - ignoring it", path);
+        unmap();
+        return false;
+    }
+    size_t expected = sizeof(ContractIndexHeader) +
+                      h->recordCount * (sizeof(ContractRecord) + sizeof(ContractIdEntry));
+    if (file.size() < expected) {
+        LOG_ERROR("Contract index {} is truncated - ignoring it", path);
+        unmap();
+        return false;
+    }
+
+    // Lookups touch a handful of pages per binary search; fault them in now
+    madvise(file.data(), file.size(), MADV_WILLNEED);
+    mappedCount = h->recordCount;
+    mappedRecords = reinterpret_cast<const ContractRecord*>(file.data() + sizeof(ContractIndexHeader));
+    mappedIds = reinterpret_cast<const ContractIdEntry*>(mappedRecords + mappedCount);
+    LOG_INFO("Loaded {} contracts from {}", mappedCount, path);
+    return true;
+}
+
+bool ContractRegistry::save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (indexPath.empty() || resolved.empty()) {
+        return true;
+    }
+
+    // Merge: records resolved this session replace mapped ones with the same symbol
+    std::vector<ContractRecord> records;
+    records.reserve(mappedCount + resolved.size());
+    for (size_t i = 0; i < mappedCount; ++i) {
+        if (resolved.find(mappedRecords[i].symbol) == resolved.end()) {
+            records.push_back(mappedRecords[i]);
+        }
+    }
+    for (const auto& entry : resolved) {
+        records.push_back(entry.second);
+    }
+    std::sort(records.begin(), records.end(), [](const ContractRecord& a, const ContractRecord& b) {
+        return std::strncmp(a.symbol, b.symbol, sizeof(a.symbol)) < 0;
+    });
+
+    std::vector<ContractIdEntry> ids(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        ids[i].conId = records[i].conId;
+        ids[i].record = static_cast<uint32_t>(i);
+        ids[i].reserved = 0;
+    }
+    std::sort(ids.begin(), ids.end(), [](const ContractIdEntry& a, const ContractIdEntry& b) {
+        return a.conId < b.conId;
+    });
+
+    // Write next to the old index and rename over it, so readers never see a partial file
+    std::string tmpPath = indexPath + ".tmp";
+    size_t bytes = sizeof(ContractIndexHeader) + records.size() * (sizeof(ContractRecord) + sizeof(ContractIdEntry));
+    MappedFile out;
+    if (!out.openWrite(tmpPath, bytes, true)) {
+        return false;
+    }
+    ContractIndexHeader* h = reinterpret_cast<ContractIndexHeader*>(out.data());
+    std::memset(h, 0, sizeof(*h));
+    std::memcpy(h->magic, kIndexMagic, sizeof(kIndexMagic));
+    h->formatVersion = kIndexFormatVersion;
+    h->recordCount = static_cast<uint32_t>(records.size());
+    h->savedWallNs = wallClockNanos();
+    char* pos = out.data() + sizeof(ContractIndexHeader);
+    std::memcpy(pos, records.data(), records.size() * sizeof(ContractRecord));
+    std::memcpy(pos + records.size() * sizeof(ContractRecord), ids.data(), ids.size() * sizeof(ContractIdEntry));
+    out.close(bytes);
+
+    if (std::rename(tmpPath.c_str(), indexPath.c_str()) != 0) {
+        LOG_ERROR("Failed to replace contract index {}: {}", indexPath, std::strerror(errno));
+        return false;
+    }
+
+    unmap();
+    if (!file.openRead(indexPath)) {
+        return false;
+    }
+    mappedCount = records.size();
+    mappedRecords = reinterpret_cast<const ContractRecord*>(file.data() + sizeof(ContractIndexHeader));
+    mappedIds = reinterpret_cast<const ContractIdEntry*>(mappedRecords + mappedCount);
+    resolved.clear();
+    resolvedIds.clear();
+    LOG_INFO("Saved {} contracts to {}", mappedCount, indexPath);
+    return true;
+}
+
+const ContractRecord* ContractRegistry::findLocked(const std::string& symbol) const {
+    auto it = resolved.find(symbol);
+    if (it != resolved.end()) {
+        return &it->second;
+    }
+
+    const ContractRecord* end = mappedRecords + mappedCount;
+    const ContractRecord* record = std::lower_bound(mappedRecords, end, symbol, symbolLess);
+    if (record != end && std::strncmp(record->symbol, symbol.c_str(), sizeof(record->symbol)) == 0) {
+        return record;
+    }
+    return nullptr;
+}
+
+const ContractRecord* ContractRegistry::findByConIdLocked(int64_t conId) const {
+    auto it = resolvedIds.find(conId);
+    if (it != resolvedIds.end()) {
+        return &resolved.at(it->second);
+    }
+
+    const ContractIdEntry* end = mappedIds + mappedCount;
+    const ContractIdEntry* entry = std::lower_bound(mappedIds, end, conId,
+        [](const ContractIdEntry& e, int64_t id) { return e.conId < id; });
+    if (entry != end && entry->conId == conId) {
+        return &mappedRecords[entry->record];
+    }
+    return nullptr;
+}
+
+bool ContractRegistry::find(const std::string& symbol, ContractRecord& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const ContractRecord* record = findLocked(symbol);
+    if (!record) {
+        return false;
+    }
+    out = *record;
+    return true;
+}
+
+bool ContractRegistry::findByConId(int64_t conId, ContractRecord& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const ContractRecord* record = findByConIdLocked(conId);
+    if (!record) {
+        return false;
+    }
+    out = *record;
+    return true;
+}
+
+bool ContractRegistry::qualify(Contract& contract) const {
+    if (contract.conId != 0) {
+        return true;
+    }
+
+    ContractRecord record;
+    if (!find(contract.symbol, record)) {
+        return false;
+    }
+    // Records are keyed by symbol alone, so an option, future or currency pair
+    // on a symbol resolved as a stock must not pick up the stock's conId
+    if ((!contract.secType.empty() && contract.secType != record.secType) ||
+        (!contract.currency.empty() && contract.currency != record.currency)) {
+        return false;
+    }
+    // Keep the caller's routing exchange if it chose one
+    std::string exchange = contract.exchange;
+    record.toContract(contract);
+    if (!exchange.empty()) {
+        contract.exchange = exchange;
+    }
+    return true;
+}
+
+size_t ContractRegistry::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = mappedCount;
+    for (const auto& entry : resolved) {
+        const ContractRecord* end = mappedRecords + mappedCount;
+        const ContractRecord* record = std::lower_bound(mappedRecords, end, entry.first, symbolLess);
+        if (record == end || std::strncmp(record->symbol, entry.first.c_str(), sizeof(record->symbol)) != 0) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void ContractRegistry::beginRequest(int reqId, const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending[reqId] = symbol;
+}
+
+bool ContractRegistry::claimLookup(int reqId, const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (findLocked(symbol)) {
+        return false;
+    }
+    for (const auto& entry : pending) {
+        if (entry.second == symbol) {
+            return false;
+        }
+    }
+    pending[reqId] = symbol;
+    return true;
+}
+
+void ContractRegistry::onDetails(int reqId, const Contract& contract, double minTick) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pending.find(reqId);
+    if (it == pending.end()) {
+        return;
+    }
+
+    // Ambiguous symbols can return several contracts; the first one of the
+    // request wins (its resolvedNs stays negative until the request ends)
+    const std::string& symbol = it->second;
+    auto existing = resolved.find(symbol);
+    if (existing != resolved.end() && existing->second.resolvedNs < 0) {
+        return;
+    }
+
+    ContractRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.conId = contract.conId;
+    record.minTick = minTick;
+    record.resolvedNs = -wallClockNanos();      // negative until the request ends
+    copyField(record.symbol, symbol);
+    copyField(record.secType, contract.secType);
+    copyField(record.currency, contract.currency);
+    copyField(record.exchange, "SMART");
+    copyField(record.primaryExchange, contract.primaryExchange);
+    copyField(record.localSymbol, contract.localSymbol);
+    copyField(record.tradingClass, contract.tradingClass);
+
+    if (existing != resolved.end()) {
+        resolvedIds.erase(existing->second.conId);
+    }
+    resolved[symbol] = record;
+    resolvedIds[record.conId] = symbol;
+}
+
+bool ContractRegistry::finishRequest(int reqId) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pending.find(reqId);
+        if (it == pending.end()) {
+            return false;
+        }
+        auto record = resolved.find(it->second);
+        if (record != resolved.end() && record->second.resolvedNs < 0) {
+            record->second.resolvedNs = -record->second.resolvedNs;
+        }
+        pending.erase(it);
+    }
+    requestDone.notify_all();
+    return true;
+}
+
+size_t ContractRegistry::inFlight() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+}
+
+bool ContractRegistry::waitForCapacity(size_t maxInFlight, std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return requestDone.wait_until(lock, deadline, [this, maxInFlight] { return pending.size() < maxInFlight; });
+}
+
+void ContractRegistry::abandonRequests() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.clear();
+    }
+    requestDone.notify_all();
+}
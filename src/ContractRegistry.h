@@ -0,0 +1,108 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "Contract.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One resolved contract as stored in the index file. Fixed size and
+// self-contained so the file can be mapped and searched without parsing.
+struct ContractRecord {
+    int64_t conId;
+    double minTick;
+    int64_t resolvedNs;         // wall clock when the gateway returned it
+    char symbol[24];
+    char secType[8];
+    char currency[8];
+    char exchange[16];          // routing exchange orders are sent to (SMART)
+    char primaryExchange[16];
+    char localSymbol[24];
+    char tradingClass[8];
+
+    void toContract(Contract& out) const;
+};
+
+static_assert(sizeof(ContractRecord) == 128, "contract record must stay 128 bytes");
+
+// Index file layout: header, records sorted by symbol, then conId entries
+// sorted by conId pointing back into the records.
+struct ContractIndexHeader {
+    char magic[8];              // "FTCREG1\0"
+    uint32_t formatVersion;
+    uint32_t recordCount;
+    int64_t savedWallNs;
+    char reserved[40];
+};
+
+static_assert(sizeof(ContractIndexHeader) == 64, "contract index header must stay 64 bytes");
+
+struct ContractIdEntry {
+    int64_t conId;
+    uint32_t record;
+    uint32_t reserved;
+};
+
+// Symbol -> contract cache in front of reqContractDetails.
+//
+// Contracts saved by an earlier session are served straight from the mapped
+// index file (binary search, no load step); contracts resolved in this session
+// sit in a small in-memory overlay until save() rewrites the file. The registry
+// also tracks the in-flight reqContractDetails requests so the connector can
+// pace them. All methods are thread-safe.
+class ContractRegistry {
+public:
+    ContractRegistry();
+    ~ContractRegistry();
+
+    ContractRegistry(const ContractRegistry&) = delete;
+    ContractRegistry& operator=(const ContractRegistry&) = delete;
+
+    // Maps an existing index; a missing file is not an error. Sets the path save() writes to.
+    bool open(const std::string& path);
+    // Writes mapped + resolved contracts to a new index and maps it. No-op without a path.
+    bool save();
+
+    bool find(const std::string& symbol, ContractRecord& out) const;
+    bool findByConId(int64_t conId, ContractRecord& out) const;
+    // Fills conId, exchange and identifiers of a symbol-only contract. Returns
+    // false, leaving it untouched, when the symbol has not been resolved or
+    // the contract's secType or currency (where set) differ from the record's.
+    bool qualify(Contract& contract) const;
+    size_t size() const;
+
+    // Request tracking, used by IBConnector::resolveContracts
+    void beginRequest(int reqId, const std::string& symbol);
+    // beginRequest() unless the symbol is already resolved or being looked up
+    bool claimLookup(int reqId, const std::string& symbol);
+    void onDetails(int reqId, const Contract& contract, double minTick);
+    // Ends a request (details end or error). Returns false for ids it does not own.
+    bool finishRequest(int reqId);
+    size_t inFlight() const;
+    // Waits until fewer than maxInFlight requests are outstanding; false on timeout.
+    bool waitForCapacity(size_t maxInFlight, std::chrono::steady_clock::time_point deadline);
+    void abandonRequests();
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable requestDone;
+    std::string indexPath;
+    MappedFile file;
+    const ContractRecord* mappedRecords;
+    const ContractIdEntry* mappedIds;
+    size_t mappedCount;
+
+    std::map<std::string, ContractRecord> resolved;     // not yet in the mapped index
+    std::unordered_map<int64_t, std::string> resolvedIds;
+    std::unordered_map<int, std::string> pending;       // reqId -> symbol
+
+    const ContractRecord* findLocked(const std::string& symbol) const;
+    const ContractRecord* findByConIdLocked(int64_t conId) const;
+    void unmap();
+};
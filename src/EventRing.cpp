@@ -0,0 +1,255 @@
+#include "EventRing.h"
+#include "Clock.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+size_t roundUpPow2(size_t n) {
+    size_t p = 64;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+// Parked consumers re-check at least this often, so a missed wake-up only costs latency
+const auto kParkTimeout = std::chrono::milliseconds(10);
+}
+
+const char* eventTypeName(EventType type) {
+    switch (type) {
+    case EventType::TickPrice: return "TickPrice";
+    case EventType::TickSize: return "TickSize";
+    case EventType::Depth: return "Depth";
+    case EventType::OrderStatus: return "OrderStatus";
+    case EventType::Position: return "Position";
+    case EventType::Error: return "Error";
+    case EventType::Bar: return "Bar";
+    default: return "Unknown";
+    }
+}
+
+EventRing::EventRing(size_t capacity)
+    : mask(roundUpPow2(capacity) - 1)
+    , slots(new ConnectorEvent[mask + 1])
+    , gateCache(0) {
+    // Touch every slot now rather than on the first lap
+    std::memset(static_cast<void*>(slots.get()), 0, sizeof(ConnectorEvent) * (mask + 1));
+}
+
+EventRing::~EventRing() {
+    stopConsumers();
+}
+
+int EventRing::addConsumer(const ConsumerOptions& options, Handler handler) {
+    std::lock_guard<std::mutex> lock(consumerMutex);
+    size_t count = consumerCount.load(std::memory_order_relaxed);
+    if (count == kMaxConsumers) {
+        LOG_ERROR("Event consumer {} not added: limit of {} reached", options.name, kMaxConsumers);
+        return -1;
+    }
+
+    auto consumer = std::make_unique<Consumer>();
+    for (int id : options.after) {
+        if (id < 0 || static_cast<size_t>(id) >= count || !consumers[id]->running) {
+            LOG_ERROR("Event consumer {} not added: unknown dependency {}", options.name, id);
+            return -1;
+        }
+        // A gating consumer waiting on a lossy one could be lapped through it
+        if (options.gating && !consumers[id]->gating) {
+            LOG_ERROR("Event consumer {} not added: it gates but depends on non-gating {}",
+                      options.name, consumers[id]->options.name);
+            return -1;
+        }
+        consumer->after.push_back(consumers[id].get());
+    }
+    consumer->options = options;
+    consumer->handler = std::move(handler);
+
+    // Start at the cursor: the producer cannot be more than a ring ahead of it
+    uint64_t start = cursor.load(std::memory_order_acquire);
+    for (Consumer* dependency : consumer->after) {
+        start = std::min(start, dependency->next.load(std::memory_order_acquire));
+    }
+    consumer->next.store(start, std::memory_order_relaxed);
+    consumer->gating.store(options.gating, std::memory_order_relaxed);
+    consumer->running.store(true, std::memory_order_relaxed);
+    if (!consumer->after.empty()) {
+        chained.store(true, std::memory_order_relaxed);
+    }
+
+    Consumer& started = *consumer;
+    consumers[count] = std::move(consumer);
+    consumerCount.store(count + 1, std::memory_order_release);
+    started.thread = std::thread(&EventRing::runConsumer, this, std::ref(started));
+
+    LOG_INFO("Event consumer {} started ({}{})", options.name, options.gating ? "gating" : "non-gating",
+             options.after.empty() ? "" : ", after dependencies");
+    return static_cast<int>(count);
+}
+
+void EventRing::stopConsumer(int id) {
+    std::lock_guard<std::mutex> lock(consumerMutex);
+    if (id < 0 || static_cast<size_t>(id) >= consumerCount.load(std::memory_order_relaxed)) {
+        return;
+    }
+    Consumer& consumer = *consumers[id];
+    consumer.running.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> parkLock(parkMutex);
+        parkCV.notify_all();
+    }
+    if (consumer.thread.joinable()) {
+        consumer.thread.join();
+    }
+    // Stop gating the producer, and let dependents run freely past it
+    consumer.gating.store(false, std::memory_order_release);
+    consumer.next.store(UINT64_MAX, std::memory_order_release);
+}
+
+void EventRing::stopConsumers() {
+    size_t count = consumerCount.load(std::memory_order_acquire);
+    // Dependents first, so none is left waiting on a stopped consumer
+    for (size_t i = count; i-- > 0;) {
+        stopConsumer(static_cast<int>(i));
+    }
+}
+
+uint64_t EventRing::minGating(uint64_t upTo) const {
+    uint64_t minimum = upTo;
+    size_t count = consumerCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        const Consumer& consumer = *consumers[i];
+        if (consumer.gating.load(std::memory_order_acquire)) {
+            minimum = std::min(minimum, consumer.next.load(std::memory_order_acquire));
+        }
+    }
+    return minimum;
+}
+
+ConnectorEvent& EventRing::claim() {
+    uint64_t sequence = claimed.load(std::memory_order_relaxed);
+    if (sequence > gateCache + mask) {
+        gateCache = minGating(sequence);
+        if (sequence > gateCache + mask) {
+            // A gating consumer is a full ring behind - wait for it
+            stalls.fetch_add(1, std::memory_order_relaxed);
+            do {
+                wakeConsumers();
+                std::this_thread::yield();
+                gateCache = minGating(sequence);
+            } while (sequence > gateCache + mask);
+        }
+    }
+
+    // Seqlock-style: non-gating readers check claimed after copying a slot
+    claimed.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return slots[sequence & mask];
+}
+
+void EventRing::publish() {
+    cursor.store(claimed.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+void EventRing::wakeConsumers() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(parkMutex);
+        parkCV.notify_all();
+    }
+}
+
+uint64_t EventRing::available(const Consumer& consumer) const {
+    uint64_t limit = cursor.load(std::memory_order_acquire);
+    for (const Consumer* dependency : consumer.after) {
+        limit = std::min(limit, dependency->next.load(std::memory_order_acquire));
+    }
+    return limit;
+}
+
+void EventRing::park(Consumer& consumer, uint64_t next) {
+    parked.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    {
+        std::unique_lock<std::mutex> lock(parkMutex);
+        parkCV.wait_for(lock, kParkTimeout, [&] {
+            return !consumer.running.load(std::memory_order_relaxed) || available(consumer) > next;
+        });
+    }
+    parked.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void EventRing::runConsumer(Consumer& consumer) {
+    applyThreadTuning(consumer.options.thread, "ev-" + consumer.options.name);
+
+    const bool gating = consumer.options.gating;
+    const int64_t spinNs = static_cast<int64_t>(consumer.options.spinMicros) * 1000;
+    const uint64_t capacity = mask + 1;
+    uint64_t next = consumer.next.load(std::memory_order_relaxed);
+    int64_t lastEventNs = monotonicNanos();
+    ConnectorEvent copy;
+
+    while (consumer.running.load(std::memory_order_relaxed)) {
+        uint64_t limit = available(consumer);
+        if (limit > next) {
+            for (; next < limit; ++next) {
+                const ConnectorEvent& slot = slots[next & mask];
+                if (gating) {
+                    // The producer cannot reuse the slot until our sequence moves past it
+                    consumer.handler(slot, next, next + 1 == limit);
+                    continue;
+                }
+
+                std::memcpy(static_cast<void*>(&copy), &slot, sizeof(copy));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                uint64_t claimedNow = claimed.load(std::memory_order_relaxed);
+                if (claimedNow > next + capacity) {
+                    // Lapped: resume an eighth of a ring behind the producer
+                    uint64_t resume = claimedNow - capacity + capacity / 8;
+                    consumer.dropped.fetch_add(resume - next, std::memory_order_relaxed);
+                    next = resume;
+                    break;
+                }
+                consumer.handler(copy, next, next + 1 == limit);
+            }
+            consumer.next.store(next, std::memory_order_release);
+            if (chained.load(std::memory_order_relaxed)) {
+                // Dependents may be parked waiting on us
+                wakeConsumers();
+            }
+            lastEventNs = monotonicNanos();
+            continue;
+        }
+
+        ProcessingMode mode = consumer.options.waitMode;
+        if (mode == ProcessingMode::Blocking ||
+            (mode == ProcessingMode::Hybrid && monotonicNanos() - lastEventNs > spinNs)) {
+            park(consumer, next);
+        } else {
+            cpuRelax();
+        }
+    }
+}
+
+std::vector<EventConsumerStats> EventRing::consumerStats() const {
+    std::vector<EventConsumerStats> all;
+    uint64_t published = cursor.load(std::memory_order_acquire);
+    size_t count = consumerCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        const Consumer& consumer = *consumers[i];
+        uint64_t next = consumer.next.load(std::memory_order_acquire);
+        if (next == UINT64_MAX) {
+            continue;   // stopped
+        }
+        EventConsumerStats stats;
+        stats.name = consumer.options.name;
+        stats.sequence = next;
+        stats.lag = published > next ? published - next : 0;
+        stats.dropped = consumer.dropped.load(std::memory_order_relaxed);
+        all.push_back(std::move(stats));
+    }
+    return all;
+}
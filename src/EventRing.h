@@ -0,0 +1,193 @@
+#pragma once
+
+#include "ConnectorStats.h"
+#include "Settings.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+enum class EventType : uint8_t {
+    TickPrice,
+    TickSize,
+    Depth,
+    OrderStatus,
+    Position,
+    Error,
+    Bar
+};
+
+const char* eventTypeName(EventType type);
+
+struct TickEvent {
+    int tickerId;
+    int field;                          // IB tick type
+    double value;                       // price, or size for TickSize
+};
+
+struct DepthEvent {
+    int tickerId;
+    int position;
+    int operation;                      // 0 insert, 1 update, 2 delete
+    int side;                           // 0 ask, 1 bid
+    double price;
+    double size;
+};
+
+struct OrderStatusEvent {
+    long orderId;
+    double filled;
+    double remaining;
+    double avgFillPrice;
+    double lastFillPrice;
+    char status[16];
+};
+
+struct PositionEvent {
+    long conId;
+    double position;
+    double avgCost;
+    char account[24];
+    char symbol[16];
+};
+
+struct ErrorEvent {
+    int id;
+    int code;
+    char message[96];
+};
+
+// A completed OHLCV bar (BarEngine).
+struct BarEvent {
+    int tickerId;
+    int intervalSeconds;
+    int64_t startNs;                    // bar start, ns since epoch; the bar covers [start, start + interval)
+    double open;
+    double high;
+    double low;
+    double close;
+    double volume;
+    double vwap;                        // close when there was no volume
+    uint32_t trades;                    // size ticks, or the real-time bars' trade counts
+};
+
+// One EWrapper callback as a fixed-size, trivially copyable record. Text
+// fields are truncated to fit and always NUL-terminated.
+struct alignas(64) ConnectorEvent {
+    EventType type;
+    int64_t timeNs;                     // wallClockNanos() when the callback ran
+    union {
+        TickEvent tick;                 // TickPrice, TickSize
+        DepthEvent depth;
+        OrderStatusEvent order;
+        PositionEvent position;
+        ErrorEvent error;
+        BarEvent bar;
+    };
+};
+
+static_assert(std::is_trivially_copyable<ConnectorEvent>::value, "events are copied as raw bytes");
+static_assert(sizeof(ConnectorEvent) == 128, "keep events at two cache lines");
+
+// Copies text into a fixed event field, truncating as needed.
+template <size_t N>
+void copyEventText(char (&out)[N], const std::string& text) {
+    size_t n = text.size() < N - 1 ? text.size() : N - 1;
+    text.copy(out, n);
+    out[n] = '\0';
+}
+
+// Disruptor-style sequencer fanning connector events out to consumer threads.
+//
+// The message processing thread is the single producer: it claims the next
+// slot of a pre-allocated ring, fills it in place and publishes it by moving
+// the cursor. Every consumer runs on its own thread with its own sequence and
+// handles events in order, in batches of whatever has been published. A
+// consumer can be ordered after other consumers (its barrier), so it only sees
+// events they have finished with. Gating consumers hold up the producer when it
+// is a full ring ahead of them; non-gating ones (a GUI bridge) never do, and
+// instead skip ahead and count what they dropped. Nothing is allocated once
+// the consumers are running.
+class EventRing {
+public:
+    static constexpr size_t kMaxConsumers = 16;
+
+    // endOfBatch is set on the last event currently available to the consumer
+    using Handler = std::function<void(const ConnectorEvent& event, uint64_t sequence, bool endOfBatch)>;
+
+    struct ConsumerOptions {
+        std::string name;                   // thread "ev-<name>"
+        std::vector<int> after;             // consumers that must handle each event first
+        bool gating = true;                 // false: may drop events instead of holding up the producer
+        ProcessingMode waitMode = ProcessingMode::Blocking;
+        int spinMicros = 50;                // Hybrid: spin this long before parking
+        ThreadTuning thread;
+    };
+
+    explicit EventRing(size_t capacity = 65536);
+    ~EventRing();
+
+    EventRing(const EventRing&) = delete;
+    EventRing& operator=(const EventRing&) = delete;
+
+    // Starts a consumer at the current cursor. Returns its id, or -1 if there
+    // are too many consumers or a dependency is unknown (or non-gating while
+    // this consumer gates).
+    int addConsumer(const ConsumerOptions& options, Handler handler);
+    // Stops one consumer; it no longer holds up the producer or its dependents.
+    void stopConsumer(int id);
+    void stopConsumers();
+
+    // Producer side - one thread only. claim() waits while the slot is still
+    // needed by a gating consumer; the event becomes visible on publish().
+    ConnectorEvent& claim();
+    void publish();
+    // Wakes parked consumers; called once per batch of published events.
+    void wakeConsumers();
+
+    size_t capacity() const { return mask + 1; }
+    uint64_t published() const { return cursor.load(std::memory_order_relaxed); }
+    std::vector<EventConsumerStats> consumerStats() const;
+    uint64_t producerStalls() const { return stalls.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Consumer {
+        std::atomic<uint64_t> next{0};          // first sequence not handled yet
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> running{false};
+        std::atomic<bool> gating{false};
+        ConsumerOptions options;
+        Handler handler;
+        std::vector<Consumer*> after;
+        std::thread thread;
+    };
+
+    const size_t mask;
+    std::unique_ptr<ConnectorEvent[]> slots;
+    alignas(64) std::atomic<uint64_t> claimed{0};   // ahead of cursor while an event is being written
+    alignas(64) std::atomic<uint64_t> cursor{0};    // events published
+    uint64_t gateCache;                             // producer only: last minimum of the gating sequences
+
+    std::array<std::unique_ptr<Consumer>, kMaxConsumers> consumers;
+    std::atomic<size_t> consumerCount{0};
+    std::atomic<bool> chained{false};               // some consumer runs after another
+    std::mutex consumerMutex;                       // addConsumer / stopConsumer
+
+    std::mutex parkMutex;
+    std::condition_variable parkCV;
+    std::atomic<int> parked{0};
+    std::atomic<uint64_t> stalls{0};
+
+    uint64_t minGating(uint64_t upTo) const;
+    uint64_t available(const Consumer& consumer) const;
+    void runConsumer(Consumer& consumer);
+    void park(Consumer& consumer, uint64_t next);
+};
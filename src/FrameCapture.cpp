@@ -0,0 +1,158 @@
+#include "FrameCapture.h"
+#include "Clock.h"
+#include "Logger.h"
+#include <cstring>
+#include <ctime>
+#include <sys/mman.h>
+
+namespace {
+const char kCaptureMagic[8] = {'F', 'T', 'C', 'A', 'P', '0', '1', '\0'};
+const uint32_t kCaptureFormatVersion = 1;
+
+size_t recordBytes(uint32_t length) {
+    return (sizeof(FrameHeader) + length + 7) & ~static_cast<size_t>(7);
+}
+}
+
+// CaptureWriter
+
+CaptureWriter::CaptureWriter()
+    : failed(false) {
+}
+
+CaptureWriter::~CaptureWriter() {
+    close();
+}
+
+bool CaptureWriter::open(const std::string& path, int serverVersion) {
+    close();
+
+    failed = false;
+    if (!file.openWrite(path, kGrowBytes, true)) {
+        return false;
+    }
+
+    CaptureFileHeader* h = header();
+    std::memcpy(h->magic, kCaptureMagic, sizeof(kCaptureMagic));
+    h->formatVersion = kCaptureFormatVersion;
+    h->serverVersion = serverVersion;
+    h->startWallNs = wallClockNanos();
+    h->startMonotonicNs = monotonicNanos();
+    h->dataBytes = 0;
+    h->recordCount = 0;
+
+    LOG_INFO("Capturing inbound frames to {}", path);
+    return true;
+}
+
+void CaptureWriter::close() {
+    if (!file.isOpen()) {
+        return;
+    }
+    uint64_t used = sizeof(CaptureFileHeader) + header()->dataBytes;
+    uint64_t records = header()->recordCount;
+    std::string path = file.path();
+    // Drop the unused tail of the last chunk
+    file.close(used);
+    LOG_INFO("Capture {} closed: {} frames, {} bytes", path, records, used);
+}
+
+bool CaptureWriter::append(const char* data, uint32_t length, int64_t receiveNs) {
+    if (!file.isOpen() || failed) {
+        return false;
+    }
+
+    size_t offset = sizeof(CaptureFileHeader) + header()->dataBytes;
+    size_t need = recordBytes(length);
+    if (offset + need > file.size()) {
+        size_t newSize = file.size();
+        while (newSize < offset + need) {
+            newSize += kGrowBytes;
+        }
+        if (!file.resize(newSize)) {
+            failed = true;
+            LOG_ERROR("Capture stopped after {} frames", header()->recordCount);
+            return false;
+        }
+    }
+
+    FrameHeader* record = reinterpret_cast<FrameHeader*>(file.data() + offset);
+    record->length = length;
+    record->reserved = 0;
+    record->receiveNs = receiveNs;
+    std::memcpy(record + 1, data, length);
+
+    // Publish the record only once its bytes are in place
+    CaptureFileHeader* h = header();
+    h->dataBytes += need;
+    h->recordCount += 1;
+    return true;
+}
+
+// CaptureReader
+
+CaptureReader::CaptureReader()
+    : dataEnd(nullptr) {
+}
+
+bool CaptureReader::open(const std::string& path) {
+    close();
+
+    if (!file.openRead(path)) {
+        return false;
+    }
+    if (file.size() < sizeof(CaptureFileHeader)) {
+        LOG_ERROR("Capture file {} is truncated", path);
+        close();
+        return false;
+    }
+    madvise(file.data(), file.size(), MADV_SEQUENTIAL);
+
+    const CaptureFileHeader& h = header();
+    if (std::memcmp(h.magic, kCaptureMagic, sizeof(kCaptureMagic)) != 0 || h.formatVersion != kCaptureFormatVersion) {
+        LOG_ERROR("{} is not a capture file", path);
+        close();
+        return false;
+    }
+
+    uint64_t available = file.size() - sizeof(CaptureFileHeader);
+    dataEnd = file.data() + sizeof(CaptureFileHeader) + (h.dataBytes < available ? h.dataBytes : available);
+    return true;
+}
+
+void CaptureReader::close() {
+    file.close();
+    dataEnd = nullptr;
+}
+
+const FrameHeader* CaptureReader::first() const {
+    if (!file.isOpen()) {
+        return nullptr;
+    }
+    return next(nullptr);
+}
+
+const FrameHeader* CaptureReader::next(const FrameHeader* record) const {
+    const char* pos = record ? reinterpret_cast<const char*>(record) + recordBytes(record->length)
+                             : file.data() + sizeof(CaptureFileHeader);
+    if (pos + sizeof(FrameHeader) > dataEnd) {
+        return nullptr;
+    }
+    const FrameHeader* candidate = reinterpret_cast<const FrameHeader*>(pos);
+    if (pos + recordBytes(candidate->length) > dataEnd) {
+        return nullptr;
+    }
+    return candidate;
+}
+
+std::string makeCapturePath(const std::string& directory, int clientId) {
+    makeDirectories(directory);
+
+    char stamp[32];
+    std::time_t now = std::time(nullptr);
+    std::tm tm;
+    localtime_r(&now, &tm);
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+
+    return directory + "/session-" + stamp + "-c" + std::to_string(clientId) + ".ftcap";
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "FrameQueue.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// On-disk layout of a capture file: one header, then FrameHeader records
+// (length, reserved, receiveNs) each followed by the frame payload padded to 8 bytes.
+struct CaptureFileHeader {
+    char magic[8];              // "FTCAP01\0"
+    uint32_t formatVersion;
+    int32_t serverVersion;      // negotiated server version, needed to decode the frames
+    int64_t startWallNs;        // wall clock when the capture was opened
+    int64_t startMonotonicNs;   // steady_clock at the same instant, to map receiveNs to wall time
+    uint64_t dataBytes;         // committed record bytes following the header
+    uint64_t recordCount;
+    char reserved[16];
+};
+
+static_assert(sizeof(CaptureFileHeader) == 64, "capture header must stay 64 bytes");
+
+// Append-only, memory-mapped recorder of inbound API frames.
+//
+// append() is a memcpy into the mapping plus two header stores, so it can run
+// on the message processing thread. The file grows in fixed chunks; the header
+// is updated after every record, so a crashed process still leaves a readable
+// capture up to its last complete frame.
+class CaptureWriter {
+public:
+    CaptureWriter();
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    bool open(const std::string& path, int serverVersion);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    // Returns false (once logged) if the file could not be grown; capture stops.
+    bool append(const char* data, uint32_t length, int64_t receiveNs);
+
+    const std::string& path() const { return file.path(); }
+    uint64_t recordCount() const { return isOpen() ? header()->recordCount : 0; }
+
+private:
+    static constexpr size_t kGrowBytes = 64 * 1024 * 1024;
+
+    MappedFile file;
+    bool failed;
+
+    CaptureFileHeader* header() { return reinterpret_cast<CaptureFileHeader*>(file.data()); }
+    const CaptureFileHeader* header() const { return reinterpret_cast<const CaptureFileHeader*>(file.data()); }
+};
+
+// Read-only mapping of a capture file with sequential record access.
+class CaptureReader {
+public:
+    CaptureReader();
+
+    bool open(const std::string& path);
+    void close();
+
+    const CaptureFileHeader& header() const { return *reinterpret_cast<const CaptureFileHeader*>(file.data()); }
+
+    // Iteration: first() then next(record) until nullptr.
+    const FrameHeader* first() const;
+    const FrameHeader* next(const FrameHeader* record) const;
+
+private:
+    MappedFile file;
+    const char* dataEnd;
+};
+
+// Builds "<directory>/session-YYYYMMDD-HHMMSS-c<clientId>.ftcap" and creates the directory.
+std::string makeCapturePath(const std::string& directory, int clientId);
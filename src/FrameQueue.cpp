@@ -0,0 +1,120 @@
+#include "FrameQueue.h"
+#include <chrono>
+#include <cstring>
+
+namespace {
+size_t roundUpPow2(size_t n) {
+    size_t p = 4096;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+}
+
+FrameQueue::FrameQueue(size_t capacityBytes)
+    : mask(roundUpPow2(capacityBytes) - 1)
+    , buffer(new char[mask + 1]) {
+}
+
+size_t FrameQueue::recordBytes(uint32_t length) {
+    return (sizeof(FrameHeader) + length + 7) & ~static_cast<size_t>(7);
+}
+
+bool FrameQueue::tryPush(const char* data, uint32_t length, int64_t receiveNs) {
+    const size_t cap = capacity();
+    const size_t need = recordBytes(length);
+    if (length > maxFrameLength()) {
+        return false;
+    }
+
+    uint64_t h = head.load(std::memory_order_relaxed);
+    uint64_t t = tail.load(std::memory_order_acquire);
+    size_t offset = h & mask;
+    size_t toEnd = cap - offset;
+    size_t skip = need > toEnd ? toEnd : 0;
+
+    if (h + skip + need - t > cap) {
+        return false;
+    }
+
+    if (skip) {
+        // Not enough contiguous room before the end - leave a marker and wrap
+        uint32_t marker = kWrapMarker;
+        std::memcpy(buffer.get() + offset, &marker, sizeof(marker));
+        h += skip;
+        offset = 0;
+    }
+
+    FrameHeader* header = reinterpret_cast<FrameHeader*>(buffer.get() + offset);
+    header->length = length;
+    header->reserved = 0;
+    header->receiveNs = receiveNs;
+    std::memcpy(header + 1, data, length);
+
+    head.store(h + need, std::memory_order_release);
+    pushed.fetch_add(1, std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumerParked.load(std::memory_order_relaxed)) {
+        wakeConsumer();
+    }
+    return true;
+}
+
+void FrameQueue::wakeConsumer() {
+    std::lock_guard<std::mutex> lock(parkMutex);
+    parkCV.notify_all();
+}
+
+const FrameHeader* FrameQueue::peek() {
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    uint64_t h = head.load(std::memory_order_acquire);
+    if (t == h) {
+        return nullptr;
+    }
+
+    size_t offset = t & mask;
+    uint32_t length;
+    std::memcpy(&length, buffer.get() + offset, sizeof(length));
+    if (length == kWrapMarker) {
+        t += capacity() - offset;
+        tail.store(t, std::memory_order_release);
+        if (t == h) {
+            return nullptr;
+        }
+        offset = 0;
+    }
+
+    const FrameHeader* header = reinterpret_cast<const FrameHeader*>(buffer.get() + offset);
+    currentRecordBytes = recordBytes(header->length);
+    return header;
+}
+
+void FrameQueue::pop() {
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    tail.store(t + currentRecordBytes, std::memory_order_release);
+    popped.fetch_add(1, std::memory_order_relaxed);
+    currentRecordBytes = 0;
+}
+
+bool FrameQueue::empty() const {
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed);
+}
+
+void FrameQueue::waitForData(int64_t timeoutNs) {
+    std::unique_lock<std::mutex> lock(parkMutex);
+    consumerParked.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (empty()) {
+        parkCV.wait_for(lock, std::chrono::nanoseconds(timeoutNs));
+    }
+    consumerParked.store(false, std::memory_order_relaxed);
+}
+
+size_t FrameQueue::depth() const {
+    uint64_t out = popped.load(std::memory_order_relaxed);
+    uint64_t in = pushed.load(std::memory_order_relaxed);
+    return in > out ? static_cast<size_t>(in - out) : 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+// One length-delimited IB API message as it came off the socket.
+struct FrameHeader {
+    uint32_t length;        // payload bytes, excluding the 4-byte wire length prefix
+    uint32_t reserved;
+    int64_t receiveNs;      // steady_clock nanoseconds when the reader split the frame
+
+    const char* payload() const { return reinterpret_cast<const char*>(this + 1); }
+};
+
+// Single-producer / single-consumer byte ring carrying frames from the socket
+// reader thread to the message processing thread.
+//
+// Frames are copied in once and decoded in place, so nothing is allocated per
+// message. The consumer can either busy-poll peek() or park in waitForData();
+// the producer only touches the condition variable when the consumer is parked.
+class FrameQueue {
+public:
+    explicit FrameQueue(size_t capacityBytes = 8 * 1024 * 1024);
+
+    FrameQueue(const FrameQueue&) = delete;
+    FrameQueue& operator=(const FrameQueue&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+    size_t maxFrameLength() const { return capacity() / 2 - sizeof(FrameHeader); }
+
+    // Producer side. Returns false if there is not enough free space right now.
+    bool tryPush(const char* data, uint32_t length, int64_t receiveNs);
+    void wakeConsumer();
+
+    // Consumer side.
+    const FrameHeader* peek();
+    void pop();
+    bool empty() const;
+    // Parks until a frame is available or the timeout expires.
+    void waitForData(int64_t timeoutNs);
+
+    // Frames pushed but not yet popped (approximate from other threads).
+    size_t depth() const;
+    uint64_t pushedCount() const { return pushed.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t kWrapMarker = 0xFFFFFFFFu;
+
+    const size_t mask;
+    std::unique_ptr<char[]> buffer;
+
+    alignas(64) std::atomic<uint64_t> head{0};     // written by the producer
+    std::atomic<uint64_t> pushed{0};
+    alignas(64) std::atomic<uint64_t> tail{0};     // written by the consumer
+    std::atomic<uint64_t> popped{0};
+    uint64_t currentRecordBytes = 0;
+
+    alignas(64) std::atomic<bool> consumerParked{false};
+    std::mutex parkMutex;
+    std::condition_variable parkCV;
+
+    static size_t recordBytes(uint32_t length);
+};
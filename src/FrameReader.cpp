@@ -0,0 +1,140 @@
+#include "FrameReader.h"
+#include "Logger.h"
+#include "Clock.h"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+
+namespace {
+const size_t kInitialBufferBytes = 64 * 1024;
+const int kPollTimeoutMs = 50;
+
+uint32_t readBigEndian32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return (static_cast<uint32_t>(u[0]) << 24) | (static_cast<uint32_t>(u[1]) << 16) |
+           (static_cast<uint32_t>(u[2]) << 8) | static_cast<uint32_t>(u[3]);
+}
+}
+
+FrameReader::FrameReader(int fd, FrameQueue& queue, const ThreadTuning& tuning, bool busyPoll)
+    : fd(fd)
+    , queue(queue)
+    , tuning(tuning)
+    , busyPoll(busyPoll)
+    , running(false)
+    , socketClosed(false)
+    , totalBytes(0)
+    , buffer(kInitialBufferBytes)
+    , used(0) {
+}
+
+FrameReader::~FrameReader() {
+    stop();
+}
+
+void FrameReader::start() {
+    if (running) {
+        return;
+    }
+    running = true;
+    thread = std::thread(&FrameReader::run, this);
+}
+
+void FrameReader::stop() {
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void FrameReader::markClosed() {
+    socketClosed.store(true, std::memory_order_release);
+    queue.wakeConsumer();
+}
+
+void FrameReader::run() {
+    applyThreadTuning(tuning, "ib-reader");
+
+    while (running.load(std::memory_order_relaxed)) {
+        if (!busyPoll) {
+            pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+
+            int rc = poll(&pfd, 1, kPollTimeoutMs);
+            if (rc == 0 || (rc < 0 && errno == EINTR)) {
+                continue;
+            }
+            if (rc < 0) {
+                LOG_ERROR("Reader poll failed: {}", std::strerror(errno));
+                markClosed();
+                return;
+            }
+        }
+
+        if (!readSocket()) {
+            markClosed();
+            return;
+        }
+    }
+}
+
+bool FrameReader::readSocket() {
+    if (used == buffer.size()) {
+        buffer.resize(buffer.size() * 2);
+    }
+
+    ssize_t n = recv(fd, buffer.data() + used, buffer.size() - used, MSG_DONTWAIT);
+    if (n == 0) {
+        LOG_WARN("Socket closed by peer");
+        return false;
+    }
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            if (busyPoll) {
+                cpuRelax();
+            }
+            return true;
+        }
+        LOG_ERROR("Socket read failed: {}", std::strerror(errno));
+        return false;
+    }
+
+    used += static_cast<size_t>(n);
+    totalBytes.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+    return splitFrames(monotonicNanos());
+}
+
+bool FrameReader::splitFrames(int64_t receiveNs) {
+    size_t offset = 0;
+    while (used - offset >= 4) {
+        uint32_t length = readBigEndian32(buffer.data() + offset);
+        if (length > queue.maxFrameLength()) {
+            LOG_ERROR("Frame of {} bytes exceeds frame queue limit of {} bytes", length, queue.maxFrameLength());
+            return false;
+        }
+        if (used - offset - 4 < length) {
+            if (buffer.size() < length + 4) {
+                buffer.resize(length + 4);
+            }
+            break;
+        }
+
+        // Back-pressure: the processing thread is behind, wait for room
+        while (!queue.tryPush(buffer.data() + offset + 4, length, receiveNs)) {
+            if (!running.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        offset += 4 + length;
+    }
+
+    if (offset > 0) {
+        std::memmove(buffer.data(), buffer.data() + offset, used - offset);
+        used -= offset;
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "FrameQueue.h"
+#include "ThreadTuning.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Socket reader thread for an established IB API session.
+//
+// Replaces EReader after the handshake: it reads the socket into a private
+// buffer, splits the length-prefixed frames and pushes them into a FrameQueue
+// for the message processing thread to decode. Owning the thread lets us pin it,
+// give it realtime priority and busy-poll the socket instead of blocking in poll().
+class FrameReader {
+public:
+    FrameReader(int fd, FrameQueue& queue, const ThreadTuning& tuning, bool busyPoll);
+    ~FrameReader();
+
+    FrameReader(const FrameReader&) = delete;
+    FrameReader& operator=(const FrameReader&) = delete;
+
+    void start();
+    void stop();
+
+    // True once the peer closed the socket or a read error occurred.
+    bool closed() const { return socketClosed.load(std::memory_order_acquire); }
+    uint64_t bytesRead() const { return totalBytes.load(std::memory_order_relaxed); }
+
+private:
+    int fd;
+    FrameQueue& queue;
+    ThreadTuning tuning;
+    bool busyPoll;
+
+    std::atomic<bool> running;
+    std::atomic<bool> socketClosed;
+    std::atomic<uint64_t> totalBytes;
+    std::thread thread;
+
+    std::vector<char> buffer;
+    size_t used;
+
+    void run();
+    bool readSocket();
+    bool splitFrames(int64_t receiveNs);
+    void markClosed();
+};
@@ -0,0 +1,378 @@
+#include "HistoricalDownloader.h"
+#include "Logger.h"
+#include "Clock.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+namespace {
+const int64_t kSecondNs = 1000000000LL;
+const int64_t kPacingWindowNs = 600 * kSecondNs;
+const int64_t kDaySeconds = 86400;
+const int64_t kSmallBarSeconds = 30;        // IB's hard request limit applies up to this bar size
+const int kPollMs = 2;
+
+// "yyyymmdd hh:mm:ss GMT"
+std::string endDateTime(int64_t timeNs) {
+    std::time_t seconds = static_cast<std::time_t>(timeNs / kSecondNs);
+    std::tm tm;
+    gmtime_r(&seconds, &tm);
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y%m%d %H:%M:%S GMT", &tm);
+    return text;
+}
+
+// Durations in seconds only go up to a day
+std::string duration(int64_t seconds) {
+    if (seconds <= kDaySeconds) {
+        return std::to_string(seconds) + " S";
+    }
+    return std::to_string((seconds + kDaySeconds - 1) / kDaySeconds) + " D";
+}
+
+bool containsText(const std::string& text, const std::string& lowerNeedle) {
+    std::string lower(text);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return lower.find(lowerNeedle) != std::string::npos;
+}
+}
+
+// One series being downloaded - owned by run(), written to by the processing
+// thread of the connection its request is on
+struct HistoricalDownloader::Series {
+    Contract contract;
+    HistoricalSeriesWriter writer;
+    std::mutex mutex;                   // the writer, between run() and the bar handler
+    Lane* lane = nullptr;               // while a request is out
+    int reqId = 0;
+    RequestFuture future;
+    int failures = 0;                   // failed attempts at the current chunk
+    int64_t notBeforeNs = 0;            // next request not before this
+};
+
+HistoricalDownloader::HistoricalDownloader(std::vector<std::shared_ptr<IBConnector>> connections,
+                                           const HistoricalSettings& settings)
+    : settings(settings)
+    , chunkNs(0)
+    , windowed(false) {
+    for (std::shared_ptr<IBConnector>& connector : connections) {
+        if (connector) {
+            Lane lane;
+            lane.connector = std::move(connector);
+            lanes.push_back(std::move(lane));
+        }
+    }
+}
+
+HistoricalDownloader::~HistoricalDownloader() = default;
+
+int64_t HistoricalDownloader::barSizeSeconds(const std::string& barSize) {
+    char* unit = nullptr;
+    long count = std::strtol(barSize.c_str(), &unit, 10);
+    if (count <= 0 || unit == barSize.c_str()) {
+        return 0;
+    }
+    std::string name(unit);
+    name.erase(0, name.find_first_not_of(' '));
+    if (name.compare(0, 3, "sec") == 0) {
+        return count;
+    }
+    if (name.compare(0, 3, "min") == 0) {
+        return count * 60;
+    }
+    if (name.compare(0, 4, "hour") == 0) {
+        return count * 3600;
+    }
+    if (name.compare(0, 3, "day") == 0) {
+        return count * kDaySeconds;
+    }
+    if (name.compare(0, 4, "week") == 0) {
+        return count * 7 * kDaySeconds;
+    }
+    if (name.compare(0, 5, "month") == 0) {
+        return count * 30 * kDaySeconds;
+    }
+    return 0;
+}
+
+int64_t HistoricalDownloader::defaultChunkSeconds(const std::string& barSize) {
+    // Roughly the largest duration IB accepts for each bar size
+    int64_t seconds = barSizeSeconds(barSize);
+    if (seconds <= 0) {
+        return 0;
+    }
+    if (seconds <= 1) {
+        return 1800;
+    }
+    if (seconds <= 5) {
+        return 3600;
+    }
+    if (seconds <= 15) {
+        return 4 * 3600;
+    }
+    if (seconds <= 30) {
+        return 8 * 3600;
+    }
+    if (seconds <= 60) {
+        return kDaySeconds;
+    }
+    if (seconds <= 180) {
+        return 2 * kDaySeconds;
+    }
+    if (seconds < 3600) {
+        return 7 * kDaySeconds;
+    }
+    if (seconds < kDaySeconds) {
+        return 30 * kDaySeconds;
+    }
+    return 365 * kDaySeconds;
+}
+
+HistoricalProgress HistoricalDownloader::run(const HistoricalJob& job, const std::atomic<bool>* stop) {
+    HistoricalProgress progress;
+    int64_t chunkSeconds = job.chunkSeconds > 0 ? job.chunkSeconds : defaultChunkSeconds(job.barSize);
+    if (lanes.empty() || chunkSeconds <= 0 || job.endNs <= job.startNs) {
+        LOG_ERROR("Historical download of '{}' bars needs a connection, a known bar size and a range", job.barSize);
+        return progress;
+    }
+    chunkNs = chunkSeconds * kSecondNs;
+    windowed = settings.requestsPer10Minutes > 0 && barSizeSeconds(job.barSize) <= kSmallBarSeconds;
+
+    std::vector<std::unique_ptr<Series>> owned;
+    std::deque<Series*> waiting;
+    for (const Contract& contract : job.contracts) {
+        ++progress.series;
+        std::unique_ptr<Series> series = std::make_unique<Series>();
+        series->contract = contract;
+        std::string directory = historicalSeriesDirectory(settings.directory, job.barSize, job.whatToShow,
+                                                          contract.symbol);
+        if (!series->writer.open(directory, contract.symbol, job.startNs, job.endNs, chunkNs)) {
+            ++progress.seriesFailed;
+            continue;
+        }
+        if (series->writer.complete()) {
+            ++progress.seriesComplete;
+            continue;
+        }
+        waiting.push_back(series.get());
+        owned.push_back(std::move(series));
+    }
+    LOG_INFO("Historical download of {} '{}' {} bars: {} series to fetch ({} already complete) over {} connections",
+             job.contracts.size(), job.barSize, job.whatToShow, waiting.size(), progress.seriesComplete,
+             lanes.size());
+
+    const int64_t startedNs = monotonicNanos();
+    const int64_t reportIntervalNs = settings.progressIntervalSeconds * kSecondNs;
+    int64_t lastReportNs = startedNs;
+    std::vector<Series*> inFlight;
+
+    while (!waiting.empty() || !inFlight.empty()) {
+        if (stop && stop->load()) {
+            LOG_WARN("Historical download stopped with {} series unfinished", waiting.size() + inFlight.size());
+            break;
+        }
+        bool usable = false;
+        for (const Lane& lane : lanes) {
+            usable = usable || lane.connector->isConnected() || lane.connector->isReconnecting();
+        }
+        if (!usable) {
+            LOG_ERROR("Historical download stopped: no connection is up");
+            break;
+        }
+        int64_t now = monotonicNanos();
+
+        for (size_t i = 0; i < inFlight.size();) {
+            Series* series = inFlight[i];
+            if (series->future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++i;
+                continue;
+            }
+            inFlight[i] = inFlight.back();
+            inFlight.pop_back();
+            if (settle(*series, series->future.get(), now, progress)) {
+                waiting.push_back(series);
+            }
+        }
+
+        // One pass over the waiting series, in turn, while the limits allow
+        for (size_t pass = waiting.size(); pass > 0; --pass) {
+            Series* series = waiting.front();
+            waiting.pop_front();
+            if (series->notBeforeNs > now) {
+                waiting.push_back(series);
+                continue;
+            }
+            if (!send(*series, job, now, progress)) {
+                waiting.push_front(series);
+                break;
+            }
+            inFlight.push_back(series);
+        }
+
+        if (reportIntervalNs > 0 && now - lastReportNs >= reportIntervalNs) {
+            lastReportNs = now;
+            double seconds = (now - startedNs) / 1e9;
+            LOG_INFO("Historical download: {}/{} series complete, {} in flight, {} bars, {} bars/s",
+                     progress.seriesComplete, progress.series, inFlight.size(), progress.bars,
+                     static_cast<uint64_t>(progress.bars / seconds));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(kPollMs));
+    }
+
+    // Anything still out is abandoned; its chunk is fetched again by the next run
+    for (Series* series : inFlight) {
+        series->lane->connector->cancelHistoricalData(series->reqId);
+        std::lock_guard<std::mutex> lock(series->mutex);
+        series->writer.discardChunk();
+    }
+
+    progress.elapsedSeconds = (monotonicNanos() - startedNs) / 1e9;
+    progress.barsPerSecond = progress.elapsedSeconds > 0.0 ? progress.bars / progress.elapsedSeconds : 0.0;
+    LOG_INFO("Historical download finished: {}/{} series complete, {} failed, {} bars in {} s ({} bars/s)",
+             progress.seriesComplete, progress.series, progress.seriesFailed, progress.bars,
+             static_cast<uint64_t>(progress.elapsedSeconds), static_cast<uint64_t>(progress.barsPerSecond));
+    LOG_INFO("Historical download sent {} requests: {} retries, {} pacing violations", progress.requests,
+             progress.retries, progress.pacingViolations);
+    return progress;
+}
+
+HistoricalDownloader::Lane* HistoricalDownloader::pickLane(int64_t nowNs) {
+    size_t open = 0;
+    for (const Lane& lane : lanes) {
+        open += lane.inFlight;
+    }
+    if (open >= static_cast<size_t>(std::max(settings.maxInFlight, 1))) {
+        return nullptr;
+    }
+    if (windowed) {
+        while (!recentSends.empty() && recentSends.front() <= nowNs - kPacingWindowNs) {
+            recentSends.pop_front();
+        }
+        if (recentSends.size() >= static_cast<size_t>(settings.requestsPer10Minutes)) {
+            return nullptr;
+        }
+    }
+
+    // Least loaded connection that is up and not paused
+    Lane* best = nullptr;
+    for (Lane& lane : lanes) {
+        if (lane.pausedUntilNs > nowNs || !lane.connector->isConnected()) {
+            continue;
+        }
+        if (!best || lane.inFlight < best->inFlight) {
+            best = &lane;
+        }
+    }
+    return best;
+}
+
+bool HistoricalDownloader::send(Series& series, const HistoricalJob& job, int64_t nowNs,
+                                HistoricalProgress& progress) {
+    Lane* lane = pickLane(nowNs);
+    if (!lane) {
+        return false;
+    }
+
+    int64_t chunkStartNs = job.startNs + static_cast<int64_t>(series.writer.chunksDone()) * chunkNs;
+    int64_t chunkEndNs = std::min(chunkStartNs + chunkNs, job.endNs);
+
+    HistoricalRequest request;
+    request.contract = series.contract;
+    request.endDateTime = endDateTime(chunkEndNs);
+    request.duration = duration((chunkEndNs - chunkStartNs + kSecondNs - 1) / kSecondNs);
+    request.barSize = job.barSize;
+    request.whatToShow = job.whatToShow;
+    request.useRth = job.useRth;
+
+    // Bars go straight into the mapped columns on the connection's processing thread
+    Series* target = &series;
+    HistoricalBarHandler onBar = [target](const Bar& bar) {
+        int64_t timeNs;
+        if (!parseHistoricalBarTime(bar.time, timeNs)) {
+            LOG_WARN("Unreadable historical bar time '{}' for {}", bar.time, target->contract.symbol);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(target->mutex);
+        target->writer.append(timeNs, bar.open, bar.high, bar.low, bar.close, static_cast<int64_t>(bar.volume),
+                              bar.wap, bar.count);
+    };
+    series.future = lane->connector->requestHistoricalData(request, std::move(onBar), &series.reqId,
+                                                           settings.timeoutSeconds * 1000);
+    series.lane = lane;
+    ++lane->inFlight;
+    if (windowed) {
+        recentSends.push_back(nowNs);
+    }
+    ++progress.requests;
+    return true;
+}
+
+bool HistoricalDownloader::settle(Series& series, const RequestResult& result, int64_t nowNs,
+                                  HistoricalProgress& progress) {
+    Lane& lane = *series.lane;
+    --lane.inFlight;
+    const std::string& symbol = series.contract.symbol;
+
+    // A chunk with no bars (a holiday, or before the listing) is done too
+    bool noData = result.status == RequestStatus::Failed && result.errorCode == 162 &&
+                  containsText(result.errorMessage, "no data");
+    if (result.ok() || noData) {
+        uint64_t before = series.writer.rowCount();
+        {
+            std::lock_guard<std::mutex> lock(series.mutex);
+            series.writer.commitChunk();
+        }
+        progress.bars += series.writer.rowCount() - before;
+        series.failures = 0;
+        series.notBeforeNs = nowNs + settings.sameContractGapMs * 1000000LL;
+        if (series.writer.complete()) {
+            ++progress.seriesComplete;
+            LOG_DEBUG("Historical series {} complete: {} bars", symbol, series.writer.rowCount());
+            series.writer.close();
+            return false;
+        }
+        return true;
+    }
+
+    // The chunk is fetched again from scratch: stop its bars and drop those already written
+    lane.connector->cancelHistoricalData(series.reqId);
+    {
+        std::lock_guard<std::mutex> lock(series.mutex);
+        series.writer.discardChunk();
+    }
+    series.notBeforeNs = nowNs + settings.retryDelaySeconds * kSecondNs;
+
+    if (result.status == RequestStatus::Failed && result.errorCode == 162 &&
+        containsText(result.errorMessage, "pacing")) {
+        ++progress.pacingViolations;
+        ++progress.retries;
+        lane.pausedUntilNs = nowNs + settings.pacingBackoffSeconds * kSecondNs;
+        LOG_WARN("Historical pacing violation on {}; pausing that connection for {} s", symbol,
+                 settings.pacingBackoffSeconds);
+        return true;
+    }
+    if (result.status == RequestStatus::Disconnected || result.status == RequestStatus::NotConnected) {
+        ++progress.retries;
+        return true;
+    }
+
+    // 200: no security definition; 321: a request IB will never accept
+    bool permanent = result.status == RequestStatus::Failed && (result.errorCode == 200 || result.errorCode == 321);
+    if (permanent || ++series.failures >= std::max(settings.maxAttempts, 1)) {
+        ++progress.seriesFailed;
+        LOG_ERROR("Historical download of {} failed at chunk {}/{}: {} {} {}", symbol,
+                  series.writer.chunksDone() + 1, series.writer.chunkCount(), requestStatusName(result.status),
+                  result.errorCode, result.errorMessage);
+        series.writer.close();
+        return false;
+    }
+    ++progress.retries;
+    LOG_WARN("Historical request for {} {} ({} {}); retrying in {} s", symbol, requestStatusName(result.status),
+             result.errorCode, result.errorMessage, settings.retryDelaySeconds);
+    return true;
+}
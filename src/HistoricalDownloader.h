@@ -0,0 +1,84 @@
+#pragma once
+
+#include "IBConnector.h"
+#include "HistoricalStore.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Bars of one size and type for a set of contracts over [startNs, endNs).
+struct HistoricalJob {
+    std::vector<Contract> contracts;    // one series per contract, filed under contract.symbol
+    std::string barSize = "1 min";
+    std::string whatToShow = "TRADES";
+    bool useRth = true;
+    int64_t startNs = 0;
+    int64_t endNs = 0;
+    int64_t chunkSeconds = 0;           // range covered by one request; 0 picks one for the bar size
+};
+
+struct HistoricalProgress {
+    size_t series = 0;
+    size_t seriesComplete = 0;          // including series finished by an earlier run
+    size_t seriesFailed = 0;
+    uint64_t requests = 0;
+    uint64_t retries = 0;
+    uint64_t pacingViolations = 0;
+    uint64_t bars = 0;                  // committed by this run
+    double elapsedSeconds = 0.0;
+    double barsPerSecond = 0.0;
+};
+
+// Downloads historical bars into columnar series (see HistoricalStore.h),
+// spreading requests over several API connections.
+//
+// Each series is fetched oldest chunk first, one request at a time, so its
+// bars are appended in order straight into the mapped columns from the
+// connection's processing thread; different series are in flight together.
+// Requests are held to IB's historical pacing rules: a cap on open requests,
+// at most requestsPer10Minutes for bars of 30 seconds or less, a gap between
+// requests for the same contract, a wait before repeating a failed request,
+// and a pause of the connection after a pacing violation. Every completed
+// chunk is checkpointed in the series header, so running an interrupted job
+// again resumes where it stopped.
+class HistoricalDownloader {
+public:
+    HistoricalDownloader(std::vector<std::shared_ptr<IBConnector>> connections,
+                         const HistoricalSettings& settings);
+    ~HistoricalDownloader();
+
+    // Blocks until every series is complete or has failed, or until *stop is
+    // set. Unfinished chunks are discarded and downloaded again next time.
+    HistoricalProgress run(const HistoricalJob& job, const std::atomic<bool>* stop = nullptr);
+
+    // Seconds in a bar size such as "5 secs", "1 min" or "1 day"; 0 if unknown.
+    static int64_t barSizeSeconds(const std::string& barSize);
+    // Longest range IB serves in one request for the bar size.
+    static int64_t defaultChunkSeconds(const std::string& barSize);
+
+private:
+    struct Series;
+
+    struct Lane {
+        std::shared_ptr<IBConnector> connector;
+        size_t inFlight = 0;
+        int64_t pausedUntilNs = 0;      // after a pacing violation
+    };
+
+    HistoricalSettings settings;
+    std::vector<Lane> lanes;
+    std::deque<int64_t> recentSends;    // send times within the last ten minutes, all lanes
+
+    // Of the running job
+    int64_t chunkNs;
+    bool windowed;                      // small bars: requestsPer10Minutes applies
+
+    // Queues the series' next chunk; false if no connection may take a request now.
+    bool send(Series& series, const HistoricalJob& job, int64_t nowNs, HistoricalProgress& progress);
+    // Checkpoints or retries a finished request; true if the series has chunks left.
+    bool settle(Series& series, const RequestResult& result, int64_t nowNs, HistoricalProgress& progress);
+    Lane* pickLane(int64_t nowNs);
+};
@@ -0,0 +1,288 @@
+#include "HistoricalStore.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace {
+const char kSeriesMagic[8] = {'F', 'T', 'H', 'I', 'S', 'T', '1', '\0'};
+const uint32_t kSeriesFormatVersion = 1;
+const uint64_t kGrowRows = 1 << 16;
+
+enum Column { Time, Open, High, Low, Close, Volume, Wap, Count };
+
+struct ColumnInfo {
+    const char* file;
+    size_t width;
+};
+
+const ColumnInfo kColumnInfo[] = {
+    {"ts.col", sizeof(int64_t)},
+    {"open.col", sizeof(double)},
+    {"high.col", sizeof(double)},
+    {"low.col", sizeof(double)},
+    {"close.col", sizeof(double)},
+    {"volume.col", sizeof(int64_t)},
+    {"wap.col", sizeof(double)},
+    {"count.col", sizeof(int32_t)},
+};
+
+std::string pathPart(const std::string& text) {
+    std::string safe;
+    for (char c : text) {
+        bool ok = std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '-' || c == '_';
+        safe += ok ? c : '_';
+    }
+    return safe.empty() ? "UNKNOWN" : safe;
+}
+
+int64_t utcSeconds(int year, int month, int day, int hour, int minute, int second) {
+    std::tm tm = {};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = second;
+    return static_cast<int64_t>(timegm(&tm));
+}
+}
+
+std::string historicalSeriesDirectory(const std::string& root, const std::string& barSize,
+                                      const std::string& whatToShow, const std::string& symbol) {
+    return root + "/" + pathPart(barSize) + "/" + pathPart(whatToShow) + "/" + pathPart(symbol);
+}
+
+bool parseHistoricalBarTime(const std::string& text, int64_t& timeNs) {
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    if (text.size() == 8 && std::sscanf(text.c_str(), "%4d%2d%2d", &year, &month, &day) == 3) {
+        timeNs = utcSeconds(year, month, day, 0, 0, 0) * 1000000000LL;
+        return true;
+    }
+    // formatDate 1 ("yyyymmdd  hh:mm:ss"), should a gateway send it anyway
+    if (std::sscanf(text.c_str(), "%4d%2d%2d %d:%d:%d", &year, &month, &day, &hour, &minute, &second) == 6) {
+        timeNs = utcSeconds(year, month, day, hour, minute, second) * 1000000000LL;
+        return true;
+    }
+    char* end = nullptr;
+    long long seconds = std::strtoll(text.c_str(), &end, 10);
+    if (end == text.c_str() || *end != '\0') {
+        return false;
+    }
+    timeNs = static_cast<int64_t>(seconds) * 1000000000LL;
+    return true;
+}
+
+// HistoricalSeriesWriter
+
+HistoricalSeriesWriter::HistoricalSeriesWriter()
+    : capacity(0)
+    , pending(0)
+    , lastTimeNs(INT64_MIN) {
+}
+
+HistoricalSeriesWriter::~HistoricalSeriesWriter() {
+    close();
+}
+
+bool HistoricalSeriesWriter::open(const std::string& directory, const std::string& symbol, int64_t startNs,
+                                  int64_t endNs, int64_t chunkNs) {
+    close();
+    if (chunkNs <= 0 || endNs <= startNs) {
+        LOG_ERROR("Invalid historical range for {}", symbol);
+        return false;
+    }
+    if (!makeDirectories(directory) || !index.openWrite(directory + "/index.bin", sizeof(HistoricalSeriesHeader))) {
+        return false;
+    }
+
+    HistoricalSeriesHeader* h = header();
+    if (std::memcmp(h->magic, kSeriesMagic, sizeof(kSeriesMagic)) != 0) {
+        std::memcpy(h->magic, kSeriesMagic, sizeof(kSeriesMagic));
+        h->formatVersion = kSeriesFormatVersion;
+        h->chunkCount = static_cast<uint32_t>((endNs - startNs + chunkNs - 1) / chunkNs);
+        h->startNs = startNs;
+        h->endNs = endNs;
+        h->chunkNs = chunkNs;
+        h->rowCount.store(0, std::memory_order_relaxed);
+        h->chunksDone.store(0, std::memory_order_relaxed);
+        std::strncpy(h->symbol, symbol.c_str(), sizeof(h->symbol) - 1);
+    } else if (h->formatVersion != kSeriesFormatVersion || h->startNs != startNs || h->endNs != endNs ||
+               h->chunkNs != chunkNs) {
+        LOG_ERROR("Historical series {} was written for a different range; move it away to download again",
+                  directory);
+        index.close();
+        return false;
+    }
+
+    uint64_t rows = h->rowCount.load(std::memory_order_relaxed);
+    uint64_t wanted = (rows / kGrowRows + 1) * kGrowRows;
+    capacity = UINT64_MAX;
+    for (size_t i = 0; i < kColumns; ++i) {
+        if (!columns[i].openWrite(directory + "/" + kColumnInfo[i].file, wanted * kColumnInfo[i].width)) {
+            close();
+            return false;
+        }
+        capacity = std::min<uint64_t>(capacity, columns[i].size() / kColumnInfo[i].width);
+    }
+
+    pending = 0;
+    lastTimeNs = rows ? column<int64_t>(Time)[rows - 1] : INT64_MIN;
+    if (h->chunksDone.load(std::memory_order_relaxed) > 0) {
+        LOG_DEBUG("Resuming historical series {} at chunk {}/{} ({} bars)", directory,
+                  h->chunksDone.load(std::memory_order_relaxed), h->chunkCount, rows);
+    }
+    return true;
+}
+
+void HistoricalSeriesWriter::close() {
+    if (!index.isOpen()) {
+        return;
+    }
+    uint64_t rows = header()->rowCount.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kColumns; ++i) {
+        columns[i].close(rows * kColumnInfo[i].width);
+    }
+    index.close();
+    capacity = 0;
+    pending = 0;
+}
+
+uint32_t HistoricalSeriesWriter::chunkCount() const {
+    return index.isOpen() ? header()->chunkCount : 0;
+}
+
+uint32_t HistoricalSeriesWriter::chunksDone() const {
+    return index.isOpen() ? header()->chunksDone.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t HistoricalSeriesWriter::rowCount() const {
+    return index.isOpen() ? header()->rowCount.load(std::memory_order_relaxed) : 0;
+}
+
+bool HistoricalSeriesWriter::append(int64_t timeNs, double open, double high, double low, double close,
+                                    int64_t volume, double wap, int32_t count) {
+    HistoricalSeriesHeader* h = header();
+    uint64_t committed = h->rowCount.load(std::memory_order_relaxed);
+    int64_t previousNs = pending ? column<int64_t>(Time)[committed + pending - 1] : lastTimeNs;
+    if (timeNs <= previousNs || timeNs < h->startNs || timeNs >= h->endNs) {
+        return false;
+    }
+
+    uint64_t row = committed + pending;
+    if (row == capacity && !grow(capacity + kGrowRows)) {
+        return false;
+    }
+    column<int64_t>(Time)[row] = timeNs;
+    column<double>(Open)[row] = open;
+    column<double>(High)[row] = high;
+    column<double>(Low)[row] = low;
+    column<double>(Close)[row] = close;
+    column<int64_t>(Volume)[row] = volume;
+    column<double>(Wap)[row] = wap;
+    column<int32_t>(Count)[row] = count;
+    ++pending;
+    return true;
+}
+
+void HistoricalSeriesWriter::commitChunk() {
+    HistoricalSeriesHeader* h = header();
+    uint64_t rows = h->rowCount.load(std::memory_order_relaxed) + pending;
+    if (pending) {
+        lastTimeNs = column<int64_t>(Time)[rows - 1];
+    }
+    pending = 0;
+    h->rowCount.store(rows, std::memory_order_release);
+    h->chunksDone.store(std::min(h->chunksDone.load(std::memory_order_relaxed) + 1, h->chunkCount),
+                        std::memory_order_release);
+}
+
+bool HistoricalSeriesWriter::grow(uint64_t rows) {
+    for (size_t i = 0; i < kColumns; ++i) {
+        if (!columns[i].resize(rows * kColumnInfo[i].width)) {
+            return false;
+        }
+    }
+    capacity = rows;
+    return true;
+}
+
+// HistoricalSeriesReader
+
+bool HistoricalSeriesReader::open(const std::string& directory) {
+    for (MappedFile& file : columns) {
+        file.close();
+    }
+    if (!index.openRead(directory + "/index.bin")) {
+        return false;
+    }
+    if (index.size() < sizeof(HistoricalSeriesHeader) ||
+        std::memcmp(header().magic, kSeriesMagic, sizeof(kSeriesMagic)) != 0 ||
+        header().formatVersion != kSeriesFormatVersion) {
+        LOG_ERROR("{} is not a historical bar series", directory);
+        index.close();
+        return false;
+    }
+
+    if (header().rowCount.load(std::memory_order_acquire) == 0) {
+        return true;
+    }
+    for (size_t i = 0; i < kColumns; ++i) {
+        if (!columns[i].openRead(directory + "/" + kColumnInfo[i].file)) {
+            index.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t HistoricalSeriesReader::rowCount() const {
+    if (!index.isOpen() || !columns[0].isOpen()) {
+        return 0;
+    }
+    // Never read past what this reader has mapped
+    size_t rows = header().rowCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < kColumns; ++i) {
+        rows = std::min(rows, columns[i].size() / kColumnInfo[i].width);
+    }
+    return rows;
+}
+
+uint32_t HistoricalSeriesReader::chunksDone() const {
+    return index.isOpen() ? header().chunksDone.load(std::memory_order_acquire) : 0;
+}
+
+uint32_t HistoricalSeriesReader::chunkCount() const {
+    return index.isOpen() ? header().chunkCount : 0;
+}
+
+HistoricalBarSpan HistoricalSeriesReader::slice(size_t begin, size_t end) const {
+    HistoricalBarSpan span;
+    if (begin >= end) {
+        return span;
+    }
+    span.timeNs = reinterpret_cast<const int64_t*>(columns[Time].data()) + begin;
+    span.open = reinterpret_cast<const double*>(columns[Open].data()) + begin;
+    span.high = reinterpret_cast<const double*>(columns[High].data()) + begin;
+    span.low = reinterpret_cast<const double*>(columns[Low].data()) + begin;
+    span.close = reinterpret_cast<const double*>(columns[Close].data()) + begin;
+    span.volume = reinterpret_cast<const int64_t*>(columns[Volume].data()) + begin;
+    span.wap = reinterpret_cast<const double*>(columns[Wap].data()) + begin;
+    span.count = reinterpret_cast<const int32_t*>(columns[Count].data()) + begin;
+    span.size = end - begin;
+    return span;
+}
+
+HistoricalBarSpan HistoricalSeriesReader::range(int64_t fromNs, int64_t toNs) const {
+    size_t rows = rowCount();
+    if (rows == 0 || fromNs >= toNs) {
+        return HistoricalBarSpan();
+    }
+    const int64_t* ts = reinterpret_cast<const int64_t*>(columns[Time].data());
+    size_t begin = static_cast<size_t>(std::lower_bound(ts, ts + rows, fromNs) - ts);
+    size_t end = static_cast<size_t>(std::lower_bound(ts + begin, ts + rows, toNs) - ts);
+    return slice(begin, end);
+}
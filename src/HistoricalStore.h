@@ -0,0 +1,136 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Columnar historical bars, one series per bar size, data type and symbol:
+//
+//   <root>/<BAR_SIZE>/<WHAT_TO_SHOW>/<SYMBOL>/index.bin   header and download checkpoint
+//                                             ts.col      int64  bar start, ns since epoch (UTC)
+//                                             open.col    double
+//                                             high.col    double
+//                                             low.col     double
+//                                             close.col   double
+//                                             volume.col  int64
+//                                             wap.col     double
+//                                             count.col   int32  trades, -1 where IB has none
+//
+// A series covers the range [startNs, endNs) of the download that created it,
+// fetched oldest chunk first, so rows are in time order. The header doubles as
+// the checkpoint: chunks [0, chunksDone) are complete and their rows counted
+// in rowCount; rows past rowCount belong to an unfinished chunk and are
+// overwritten when the download resumes.
+struct HistoricalSeriesHeader {
+    char magic[8];                      // "FTHIST1\0"
+    uint32_t formatVersion;
+    uint32_t chunkCount;                // chunks the range is downloaded in
+    int64_t startNs;
+    int64_t endNs;
+    int64_t chunkNs;
+    std::atomic<uint64_t> rowCount;     // published after the rows' columns are written
+    std::atomic<uint32_t> chunksDone;
+    uint32_t reserved;
+    char symbol[24];
+};
+
+static_assert(sizeof(HistoricalSeriesHeader) == 80, "series header must stay 80 bytes");
+
+// A contiguous run of bars, pointing straight into the mapped columns.
+struct HistoricalBarSpan {
+    const int64_t* timeNs = nullptr;
+    const double* open = nullptr;
+    const double* high = nullptr;
+    const double* low = nullptr;
+    const double* close = nullptr;
+    const int64_t* volume = nullptr;
+    const double* wap = nullptr;
+    const int32_t* count = nullptr;
+    size_t size = 0;
+};
+
+// Directory of one series; the parts are sanitised for use as path components.
+std::string historicalSeriesDirectory(const std::string& root, const std::string& barSize,
+                                      const std::string& whatToShow, const std::string& symbol);
+
+// Bar time as sent with formatDate 2: epoch seconds for intraday bars,
+// yyyymmdd (taken as UTC midnight) for daily and longer ones.
+bool parseHistoricalBarTime(const std::string& text, int64_t& timeNs);
+
+// Appends the bars of one series. Rows go into the mapped columns as they
+// arrive; commitChunk() publishes them and advances the checkpoint. Not
+// thread-safe.
+class HistoricalSeriesWriter {
+public:
+    HistoricalSeriesWriter();
+    ~HistoricalSeriesWriter();
+
+    HistoricalSeriesWriter(const HistoricalSeriesWriter&) = delete;
+    HistoricalSeriesWriter& operator=(const HistoricalSeriesWriter&) = delete;
+
+    // Creates the series, or resumes it after its last complete chunk. Fails if
+    // the existing series was written for a different range or chunk length.
+    bool open(const std::string& directory, const std::string& symbol, int64_t startNs, int64_t endNs,
+              int64_t chunkNs);
+    void close();
+    bool isOpen() const { return index.isOpen(); }
+
+    uint32_t chunkCount() const;
+    uint32_t chunksDone() const;
+    bool complete() const { return chunksDone() >= chunkCount(); }
+    uint64_t rowCount() const;
+    uint64_t pendingRows() const { return pending; }
+
+    // Adds a bar to the chunk being downloaded. Bars outside the series range or
+    // not after the previous row (overlapping chunk edges) are skipped.
+    bool append(int64_t timeNs, double open, double high, double low, double close, int64_t volume, double wap,
+                int32_t count);
+    // Checkpoint: the pending rows become part of the series and the chunk is done.
+    void commitChunk();
+    // Forgets the pending rows of a chunk that will be downloaded again.
+    void discardChunk() { pending = 0; }
+
+private:
+    static constexpr size_t kColumns = 8;
+
+    MappedFile index;
+    MappedFile columns[kColumns];
+    uint64_t capacity;
+    uint64_t pending;                   // rows of the current chunk, after rowCount
+    int64_t lastTimeNs;                 // time of the last row written
+
+    HistoricalSeriesHeader* header() { return reinterpret_cast<HistoricalSeriesHeader*>(index.data()); }
+    const HistoricalSeriesHeader* header() const {
+        return reinterpret_cast<const HistoricalSeriesHeader*>(index.data());
+    }
+    template <typename T>
+    T* column(size_t i) { return reinterpret_cast<T*>(columns[i].data()); }
+    bool grow(uint64_t rows);
+};
+
+// Zero-copy reader for one series. Picks up rows committed after open() only
+// when opened again.
+class HistoricalSeriesReader {
+public:
+    bool open(const std::string& directory);
+
+    size_t rowCount() const;
+    uint32_t chunksDone() const;
+    uint32_t chunkCount() const;
+    HistoricalBarSpan all() const { return slice(0, rowCount()); }
+    // Bars with fromNs <= time < toNs.
+    HistoricalBarSpan range(int64_t fromNs, int64_t toNs) const;
+
+private:
+    static constexpr size_t kColumns = 8;
+
+    MappedFile index;
+    MappedFile columns[kColumns];
+
+    const HistoricalSeriesHeader& header() const {
+        return *reinterpret_cast<const HistoricalSeriesHeader*>(index.data());
+    }
+    HistoricalBarSpan slice(size_t begin, size_t end) const;
+};
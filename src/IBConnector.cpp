@@ -1,107 +1,260 @@
 #include "IBConnector.h"
-#include <iostream>
+#include <algorithm>
 #include <sstream>
 #include <chrono>
-#include <iomanip>
-#include <ctime>
 #include "EReaderOSSignal.h"
-#include "EReader.h"
+#include "EDecoder.h"
+#include "Logger.h"
+#include "Clock.h"
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+
+namespace {
+// Frames decoded per pass before re-checking shouldProcessMessages
+const size_t kMaxFramesPerDrain = 256;
+// Idle spin iterations between housekeeping passes (snapshots, stats, deadlines)
+const unsigned kSpinsPerHousekeeping = 1024;
+// Set on a connector's message processing thread, the event ring's only producer
+thread_local bool onProcessingThread = false;
+
+// ExecutionFilter time: UTC, yyyymmdd-hh:mm:ss
+std::string formatExecutionTime(int64_t wallNs) {
+    time_t seconds = static_cast<time_t>(wallNs / 1000000000);
+    struct tm tm;
+    gmtime_r(&seconds, &tm);
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y%m%d-%H:%M:%S", &tm);
+    return text;
+}
+}
 
-IBConnector::IBConnector() 
-    : connected(false)
+IBConnector::IBConnector(const ConnectorSettings& settings, ConnectionRole role,
+                         std::shared_ptr<QuoteStore> sharedQuotes) 
+    : settings(settings)
+    , role(role)
+    , connected(false)
     , nextOrderId(1)
+    , accountSummaryDirty(false)
+    , positionsDirty(false)
+    , marksDirty(false)
+    , lastPositionsPublishNs(0)
+    , ordersDirty(false)
+    , quoteStorage(sharedQuotes ? std::move(sharedQuotes) : std::make_shared<QuoteStore>())
+    , quotes(*quoteStorage)
+    , quotesShared(quoteStorage.use_count() > 1)
+    , prints(quotes.capacity(), settings.tickByTickRing)
+    , bars(quotes.capacity(), settings.bars.intervalsSeconds, [this](const BarEvent& bar) { publishBar(bar); })
+    , positionBook(quotes.capacity())
+    , markQueued(std::make_unique<std::atomic<bool>[]>(quotes.capacity()))
+    , markQueue(quotes.capacity())
+    , positionOwner(this)
+    , riskGate(settings.risk, quotes)
+    , nextRequestId(1 << 24)
+    , accountSummaryReqId(0)
+    , outbound(settings.outbound)
+    , sessionPort(0)
+    , sessionClientId(0)
+    , connectionLost(false)
+    , resubscribeRequested(false)
+    , lostAtNs(0)
+    , stopReconnect(false)
+    , reconnecting(false)
+    , firstTickPendingSinceNs(0)
+    , jitterRng(std::random_device()())
+    , positionsResync(false)
+    , ordersResync(false)
+    , resyncSinceNs(0)
+    , executionsReqId(0)
     , shouldProcessMessages(false)
+    , events(settings.events.capacity)
     , connectionEstablished(false) {
     
     signal = std::make_unique<EReaderOSSignal>(2000);
-    client = std::make_unique<EClientSocket>(this, signal.get());
-    log("IBConnector initialized");
+    client = std::make_unique<CapturingClientSocket>(this, signal.get());
+    
+    if (!settings.tickHistoryDirectory.empty()) {
+        tickHistory = std::make_unique<TickHistory>(settings.tickHistoryDirectory, settings.tickHistoryQueue);
+        tickHistory->start();
+    }
+    if (!settings.contractIndexFile.empty()) {
+        contracts.open(settings.contractIndexFile);
+    }
+    
+    // Tick logging runs off the callback thread; under load it drops lines rather than delay callbacks
+    EventRing::ConsumerOptions logOptions;
+    logOptions.name = "log";
+    logOptions.gating = false;
+    events.addConsumer(logOptions, [](const ConnectorEvent& event, uint64_t, bool) { logTickEvent(event); });
+    LOG_INFO("IBConnector initialized");
 }
 
 IBConnector::~IBConnector() {
     disconnect();
+    events.stopConsumers();
 }
 
 bool IBConnector::connect(const std::string& host, int port, int clientId) {
-    log("Attempting to connect to " + host + ":" + std::to_string(port) + " with client ID " + std::to_string(clientId));
+    LOG_INFO("Attempting to connect to {}:{} with client ID {}", host, port, clientId);
     
     if (connected) {
-        log("Already connected");
+        LOG_INFO("Already connected");
         return true;
     }
-    
-    // Attempt connection
-    bool success = client->eConnect(host.c_str(), port, clientId, false);
-    
-    if (!success) {
-        log("Failed to establish socket connection");
+    if (reconnecting) {
+        LOG_WARN("Reconnect in progress - call disconnect() first to connect elsewhere");
         return false;
     }
+    // A reconnect thread that gave up has exited; start afresh
+    if (reconnectThread.joinable()) {
+        reconnectThread.join();
+    }
     
-    // Create reader after successful connection
-    reader = std::unique_ptr<EReader>(new EReader(client.get(), signal.get()));
-    reader->start();
+    sessionHost = host;
+    sessionPort = port;
+    sessionClientId = clientId;
+    stopReconnect = false;
+    {
+        std::lock_guard<std::mutex> lock(reconnectMutex);
+        connectionLost = false;
+        resubscribeRequested = false;
+    }
     
-    // Start message processing thread
-    shouldProcessMessages = true;
-    messageProcessingThread = std::thread(&IBConnector::processMessages, this);
+    if (!openSession()) {
+        clearData();
+        return false;
+    }
     
-    // Wait for connection acknowledgment
-    std::unique_lock<std::mutex> lock(connectionMutex);
-    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    connected = true;
+    LOG_INFO("Successfully connected to IB");
     
-    if (connectionCV.wait_until(lock, timeout, [this] { return connectionEstablished.load(); })) {
-        connected = true;
-        log("Successfully connected to IB");
-        
-        // Request initial data
-        client->reqManagedAccts();
+    // Request initial data
+    if (role != ConnectionRole::MarketData) {
+        outbound.enqueue(OutboundPriority::Subscription, [this] { client->reqManagedAccts(); });
         
         // Request account summary
         requestAccountSummary();
         
         // Request positions
         requestPositions();
-        
-        // Request delayed market data for Apple stock (free)
-        client->reqMarketDataType(3); // 3 = Delayed data
-        
+    }
+    
+    // Request delayed market data for Apple stock (free)
+    outbound.enqueue(OutboundPriority::Subscription, [this] { client->reqMarketDataType(3); }); // 3 = Delayed data
+    
+    if (role == ConnectionRole::Standalone) {
         Contract appleContract;
         appleContract.symbol = "AAPL";
         appleContract.secType = "STK";
         appleContract.currency = "USD";
         appleContract.exchange = "SMART";
         requestMarketData(1, appleContract);
-        
-        return true;
-    } else {
-        log("Connection timeout");
-        disconnect();
-        return false;
     }
+    
+    if (settings.reconnect.enabled) {
+        reconnectThread = std::thread(&IBConnector::reconnectLoop, this);
+    }
+    return true;
 }
 
-void IBConnector::disconnect() {
-    if (!connected) {
-        return;
+bool IBConnector::openSession() {
+    // Attempt connection
+    bool success = client->eConnect(sessionHost.c_str(), sessionPort, sessionClientId, false);
+    
+    if (!success) {
+        LOG_ERROR("Failed to establish socket connection");
+        return false;
     }
     
-    log("Disconnecting from IB");
+    if (!settings.captureDirectory.empty()) {
+        capture = std::make_unique<CaptureWriter>();
+        if (!capture->open(makeCapturePath(settings.captureDirectory, sessionClientId), client->EClient::serverVersion())) {
+            capture.reset();
+        }
+    }
     
-    connected = false;
+    // Handshake is done - our own reader takes over the socket from here
+    frames = std::make_unique<FrameQueue>(settings.frameQueueBytes);
+    frameReader = std::make_unique<FrameReader>(client->fd(), *frames, settings.readerThread,
+                                                 settings.processingMode == ProcessingMode::Spin);
+    frameReader->start();
+    
+    // Start message processing thread
+    shouldProcessMessages = true;
+    messageProcessingThread = std::thread(&IBConnector::processMessages, this);
+    
+    // Wait for connection acknowledgment
+    std::unique_lock<std::mutex> lock(connectionMutex);
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    connectionCV.wait_until(lock, timeout, [this] { return connectionEstablished.load() || stopReconnect.load(); });
+    if (connectionEstablished) {
+        // From here on every request goes out through the sender thread
+        outbound.start(*client);
+        return true;
+    }
+    lock.unlock();
+    
+    LOG_ERROR("Connection timeout");
+    closeSession();
+    return false;
+}
+
+void IBConnector::closeSession() {
     connectionEstablished = false;
     shouldProcessMessages = false;
     
+    if (frames) {
+        frames->wakeConsumer();
+    }
+    if (messageProcessingThread.joinable()) {
+        messageProcessingThread.join();
+    }
+    // Queued requests die with the session; subscriptions are replayed on reconnect
+    outbound.stop();
+    
+    // Stop reading before the socket is closed underneath the reader
+    if (frameReader) {
+        frameReader->stop();
+    }
+    
     if (client->isConnected()) {
         client->eDisconnect();
     }
     
-    if (messageProcessingThread.joinable()) {
-        messageProcessingThread.join();
+    frameReader.reset();
+    frames.reset();
+    capture.reset();
+}
+
+void IBConnector::disconnect() {
+    if (!connected && !messageProcessingThread.joinable() && !reconnectThread.joinable()) {
+        return;
+    }
+    
+    LOG_INFO("Disconnecting from IB");
+    
+    // Stop reconnecting first - it is the only other thread that opens sessions
+    {
+        std::lock_guard<std::mutex> lock(reconnectMutex);
+        stopReconnect = true;
+    }
+    reconnectCV.notify_all();
+    {
+        // Also wakes a reconnect attempt waiting for the handshake
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        connectionCV.notify_all();
     }
+    if (reconnectThread.joinable()) {
+        reconnectThread.join();
+    }
+    reconnecting = false;
     
+    connected = false;
+    closeSession();
     clearData();
-    log("Disconnected from IB");
+    // Keeps contracts resolved on first use for the next session
+    contracts.save();
+    LOG_INFO("Disconnected from IB");
 }
 
 bool IBConnector::isConnected() const {
@@ -109,19 +262,163 @@ bool IBConnector::isConnected() const {
 }
 
 void IBConnector::processMessages() {
+    applyThreadTuning(settings.processingThread, "ib-process");
+    onProcessingThread = true;
+    LOG_INFO("Message processing running in {} mode", processingModeName(settings.processingMode));
+    
+    EDecoder decoder(client->EClient::serverVersion(), this, client.get());
+    const int64_t spinNs = static_cast<int64_t>(settings.spinMicros) * 1000;
+    int64_t parkNs = static_cast<int64_t>(settings.parkTimeoutMs) * 1000000;
+    if (quotesShared && settings.positionMarkPublishMs > 0) {
+        // Ticks on the pool's other connections only queue marks here
+        parkNs = std::min<int64_t>(parkNs, static_cast<int64_t>(settings.positionMarkPublishMs) * 1000000);
+    }
+    int64_t lastFrameNs = monotonicNanos();
+    unsigned idleSpins = 0;
+    
     while (shouldProcessMessages) {
-        if (client->isConnected() && reader) {
-            signal->waitForSignal();
-            errno = 0;
-            reader->processMsgs();
+        if (drainFrames(decoder) > 0) {
+            events.wakeConsumers();
+            publishSnapshots();
+            closeBars();
+            lastFrameNs = monotonicNanos();
+            idleSpins = 0;
+            updateStats(lastFrameNs);
+            requests.expire(lastFrameNs);
+            continue;
+        }
+        
+        if (frameReader->closed()) {
+            // Socket EOF or read error - same handling EReader gives a closed socket.
+            // The sender stops first so nothing writes to the socket being closed.
+            outbound.stop();
+            client->eDisconnect();
+            connectionClosed();
+            break;
+        }
+        
+        bool park = settings.processingMode == ProcessingMode::Blocking ||
+                    (settings.processingMode == ProcessingMode::Hybrid && monotonicNanos() - lastFrameNs > spinNs);
+        
+        if (park) {
+            // Wake up in time to expire the next request deadline and close the next bars
+            int64_t untilDeadlineNs = std::min(requests.nextDeadlineNs() - monotonicNanos(),
+                                               bars.nextCloseNs() - wallClockNanos());
+            frames->waitForData(untilDeadlineNs < parkNs ? (untilDeadlineNs > 0 ? untilDeadlineNs : 0) : parkNs);
+            // Another connection's ticks may have queued marks
+            publishSnapshots();
+            closeBars();
+            int64_t now = monotonicNanos();
+            updateStats(now);
+            requests.expire(now);
+        } else {
+            if (++idleSpins % kSpinsPerHousekeeping == 0) {
+                publishSnapshots();
+                closeBars();
+                int64_t now = monotonicNanos();
+                updateStats(now);
+                requests.expire(now);
+            }
+            cpuRelax();
+        }
+    }
+}
+
+size_t IBConnector::drainFrames(EDecoder& decoder) {
+    statsRecorder.recordQueueDepth(frames->depth());
+    
+    size_t count = 0;
+    while (count < kMaxFramesPerDrain) {
+        const FrameHeader* frame = frames->peek();
+        if (!frame) {
+            break;
+        }
+        
+        statsRecorder.recordMessage(monotonicNanos() - frame->receiveNs, frame->length);
+        if (capture) {
+            capture->append(frame->payload(), frame->length, frame->receiveNs);
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        const char* begin = frame->payload();
+        decoder.parseAndProcessMsg(begin, frame->payload() + frame->length);
+        frames->pop();
+        ++count;
+    }
+    return count;
+}
+
+void IBConnector::updateStats(int64_t nowNs) {
+    const int64_t dumpIntervalNs = static_cast<int64_t>(settings.statsIntervalSeconds) * 1000000000;
+    if (statsRecorder.advance(nowNs, dumpIntervalNs)) {
+        logConnectorStats(stats());
+        statsRecorder.resetMaxQueueDepth();
+    }
+}
+
+ConnectorStats IBConnector::stats() const {
+    ConnectorStats current = statsRecorder.snapshot(frames ? frames->depth() : 0);
+    current.outbound = outbound.stats();
+    current.eventConsumers = events.consumerStats();
+    current.eventProducerStalls = events.producerStalls();
+    return current;
+}
+
+int IBConnector::addEventConsumer(const EventRing::ConsumerOptions& options, EventRing::Handler handler) {
+    return events.addConsumer(options, std::move(handler));
+}
+
+void IBConnector::publishBar(const BarEvent& bar) {
+    if (ConnectorEvent* event = claimEvent(EventType::Bar, wallClockNanos())) {
+        event->bar = bar;
+        events.publish();
+    }
+}
+
+void IBConnector::closeBars() {
+    if (bars.enabled() && bars.advance(wallClockNanos()) > 0) {
+        events.wakeConsumers();
+    }
+}
+
+ConnectorEvent* IBConnector::claimEvent(EventType type, int64_t timeNs) {
+    // EClient reports some errors on the calling thread; those are only logged
+    if (!onProcessingThread) {
+        return nullptr;
+    }
+    ConnectorEvent& event = events.claim();
+    event.type = type;
+    event.timeNs = timeNs;
+    return &event;
+}
+
+void IBConnector::logTickEvent(const ConnectorEvent& event) {
+    if (event.type != EventType::TickPrice) {
+        return;
+    }
+    const char* fieldName = nullptr;
+    switch (event.tick.field) {
+        case 1: case 66: fieldName = "BID"; break;
+        case 2: case 67: fieldName = "ASK"; break;
+        case 4: case 68: fieldName = "LAST"; break;
+        default: break;
+    }
+    
+    // Only log significant price updates to avoid spam
+    if (fieldName) {
+        LOG_INFO("Ticker {} {}: ${}", event.tick.tickerId, fieldName, event.tick.value);
     }
 }
 
+int64_t IBConnector::requestDeadline(int timeoutMs) const {
+    return monotonicNanos() + static_cast<int64_t>(timeoutMs) * 1000000;
+}
+
 void IBConnector::nextValidId(OrderId orderId) {
-    log("Next valid order ID: " + std::to_string(orderId));
-    nextOrderId = orderId;
+    LOG_INFO("Next valid order ID: {}", orderId);
+    
+    // Never move backwards - ids may already have been handed out past this point
+    OrderId current = nextOrderId.load();
+    while (current < orderId && !nextOrderId.compare_exchange_weak(current, orderId)) {
+    }
     
     // Signal that connection is established
     {
@@ -132,28 +429,310 @@ void IBConnector::nextValidId(OrderId orderId) {
 }
 
 void IBConnector::connectAck() {
-    log("Connection acknowledged by TWS/Gateway");
+    LOG_INFO("Connection acknowledged by TWS/Gateway");
 }
 
 void IBConnector::connectionClosed() {
-    log("Connection closed by TWS/Gateway");
+    LOG_WARN("Connection closed by TWS/Gateway");
     connected = false;
-    connectionEstablished = false;
+    bool wasEstablished = connectionEstablished.exchange(false);
+    requests.failAll(RequestStatus::Disconnected);
+    if (wasEstablished) {
+        notifyConnectionLost();
+    }
 }
 
 void IBConnector::error(int id, int errorCode, const std::string& errorString) {
-    std::string logMsg = "Error " + std::to_string(errorCode) + ": " + errorString;
+    CallbackTimer timer(statsRecorder, CallbackType::Error);
+    
+    if (ConnectorEvent* event = claimEvent(EventType::Error, wallClockNanos())) {
+        event->error.id = id;
+        event->error.code = errorCode;
+        copyEventText(event->error.message, errorString);
+        events.publish();
+    }
+    
     if (id != -1) {
-        logMsg += " (ID: " + std::to_string(id) + ")";
+        LOG_WARN("Error {}: {} (ID: {})", errorCode, errorString, id);
+    } else {
+        LOG_WARN("Error {}: {}", errorCode, errorString);
+    }
+    
+    // Order-level rejections and cancellations arrive as errors against the order id
+    if (errorCode == 201 || errorCode == 202) {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        OrderRecord* record = orders.find(id);
+        if (record) {
+            bool wasTerminal = isTerminal(record->stage);
+            orders.transition(*record, errorCode == 201 ? OrderStage::Rejected : OrderStage::Cancelled, wallClockNanos());
+            releaseRisk(*record, record->filled, wasTerminal);
+            ordersDirty = true;
+        }
+    }
+    
+    // Without the executions since a reconnect, orders missing from the resync
+    // cannot be settled; they stay Unknown and keep their reservation
+    if (id > 0 && (errorCode < 2100 || errorCode >= 2200)) {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        if (id == executionsReqId) {
+            LOG_WARN("Executions request failed - {} order(s) left in state Unknown", unconfirmedOrders.size());
+            unconfirmedOrders.clear();
+            resyncFills.clear();
+            executionsReqId = 0;
+        }
+    }
+    
+    // Errors against a request id fail its future; 2100-2199 are informational warnings
+    if (id != -1 && (errorCode < 2100 || errorCode >= 2200)) {
+        contracts.finishRequest(id);
+        dropHistoricalHandler(id);
+        requests.fail(id, errorCode, errorString);
+    }
+    
+    // Depth stream restarted by the gateway - the book is rebuilt from fresh inserts
+    if (errorCode == 317) {
+        books.reset(id);
     }
-    log(logMsg);
     
     // Handle connection errors
     if (errorCode == 502 || errorCode == 503 || errorCode == 504) {
-        log("Connection error detected");
+        LOG_ERROR("Connection error detected");
         connected = false;
-        connectionEstablished = false;
+        // Failed connection attempts report 502 too; only a lost session is reconnected
+        if (connectionEstablished.exchange(false)) {
+            notifyConnectionLost();
+        }
+    }
+    
+    // Gateway lost and regained its link to IB and dropped our market data
+    if (errorCode == 1101 && settings.reconnect.enabled) {
+        {
+            std::lock_guard<std::mutex> lock(reconnectMutex);
+            resubscribeRequested = true;
+        }
+        reconnectCV.notify_all();
+    }
+}
+
+void IBConnector::notifyConnectionLost() {
+    if (!settings.reconnect.enabled) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(reconnectMutex);
+        if (connectionLost || stopReconnect) {
+            return;
+        }
+        connectionLost = true;
+        lostAtNs = monotonicNanos();
+        ++reconnectTotals.connectionLosses;
+    }
+    reconnecting = true;
+    reconnectCV.notify_all();
+}
+
+void IBConnector::reconnectLoop() {
+    std::unique_lock<std::mutex> lock(reconnectMutex);
+    while (true) {
+        reconnectCV.wait(lock, [this] { return stopReconnect || connectionLost || resubscribeRequested; });
+        if (stopReconnect) {
+            break;
+        }
+        
+        if (connectionLost) {
+            connectionLost = false;
+            resubscribeRequested = false;
+            int64_t lostNs = lostAtNs;
+            lock.unlock();
+            bool restored = reestablishSession(lostNs);
+            lock.lock();
+            if (!restored) {
+                break;
+            }
+        } else {
+            resubscribeRequested = false;
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> subscriptionLock(subscriptionMutex);
+                if (isConnected()) {
+                    replaySubscriptions();
+                }
+            }
+            lock.lock();
+        }
+    }
+}
+
+bool IBConnector::reestablishSession(int64_t lostNs) {
+    closeSession();
+    contracts.abandonRequests();
+    {
+        std::lock_guard<std::mutex> lock(historicalMutex);
+        historicalHandlers.clear();
+    }
+    requests.failAll(RequestStatus::Disconnected);
+    
+    const ReconnectSettings& policy = settings.reconnect;
+    int64_t delayMs = policy.initialDelayMs > 0 ? policy.initialDelayMs : 1;
+    for (int attempt = 1; policy.maxAttempts <= 0 || attempt <= policy.maxAttempts; ++attempt) {
+        // Exponential backoff with jitter, so a gateway restart is not met by
+        // every client reconnecting in lockstep
+        double jitter = std::min(std::max(policy.jitter, 0.0), 1.0);
+        double spread = std::uniform_real_distribution<double>(1.0 - jitter, 1.0)(jitterRng);
+        auto wait = std::chrono::milliseconds(static_cast<int64_t>(delayMs * spread));
+        delayMs = std::min<int64_t>(delayMs * 2, std::max(policy.maxDelayMs, policy.initialDelayMs));
+        {
+            std::unique_lock<std::mutex> lock(reconnectMutex);
+            if (reconnectCV.wait_for(lock, wait, [this] { return stopReconnect.load(); })) {
+                return false;
+            }
+        }
+        
+        LOG_INFO("Reconnecting to {}:{} (attempt {})", sessionHost, sessionPort, attempt);
+        if (openSession()) {
+            int64_t outageNs = monotonicNanos() - lostNs;
+            firstTickPendingSinceNs = lostNs;
+            resync(lostNs);
+            {
+                std::lock_guard<std::mutex> lock(reconnectMutex);
+                ++reconnectTotals.reconnects;
+                reconnectTotals.lastOutageNs = outageNs;
+            }
+            reconnecting = false;
+            LOG_INFO("Reconnected after {} ms and {} attempt(s)", outageNs / 1000000, attempt);
+            return true;
+        }
+        
+        std::lock_guard<std::mutex> lock(reconnectMutex);
+        ++reconnectTotals.failedAttempts;
+        if (stopReconnect) {
+            return false;
+        }
+    }
+    
+    LOG_ERROR("Giving up reconnecting after {} attempts - cached data is stale until connect()", policy.maxAttempts);
+    reconnecting = false;
+    return false;
+}
+
+void IBConnector::resync(int64_t lostNs) {
+    {
+        // Subscriptions made while the session was down were only registered;
+        // connected flips under the lock so each one is sent exactly once
+        std::lock_guard<std::mutex> lock(subscriptionMutex);
+        connected = true;
+        if (role != ConnectionRole::MarketData) {
+            outbound.enqueue(OutboundPriority::Subscription, [this] { client->reqManagedAccts(); });
+        }
+        outbound.enqueue(OutboundPriority::Subscription, [this] { client->reqMarketDataType(3); });
+        replaySubscriptions();
+    }
+    if (role == ConnectionRole::MarketData) {
+        return;
+    }
+    
+    bool summaryActive;
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        // The old summary request died with the session
+        summaryActive = accountSummaryReqId != 0;
+        accountSummaryReqId = 0;
+        
+        // Positions and open orders are reconciled against what the gateway reports
+        positionBook.beginSync();
+        positionsResync = true;
+        ordersResync = true;
+        resyncSeenOrders.clear();
+        resyncSinceNs = wallClockNanos() - (monotonicNanos() - lostNs);
+        unconfirmedOrders.clear();
+        executionsReqId = 0;
+        resyncFills.clear();
+        
+        for (const auto& request : accountPnlRequests) {
+            requestAccountPnl(request.first, request.second);
+        }
+        positionBook.forEachPnlRequest([this](int reqId, const Position& position) {
+            requestPositionPnl(reqId, position.account, position.contract.conId);
+        });
+    }
+    if (summaryActive) {
+        requestAccountSummary();
+    }
+    requestPositions();
+    requestAllOpenOrders();
+}
+
+void IBConnector::replaySubscriptions() {
+    for (const auto& subscription : subscriptions.marketData()) {
+        sendMarketData(subscription.first, subscription.second);
     }
+    for (const auto& subscription : subscriptions.depth()) {
+        const DepthSubscription& depth = subscription.second;
+        books.reset(subscription.first);
+        sendMarketDepth(subscription.first, depth.contract, depth.numRows, depth.smartDepth);
+    }
+    for (const auto& subscription : subscriptions.realTimeBars()) {
+        sendRealTimeBars(subscription.first, subscription.second);
+    }
+    for (const auto& subscription : subscriptions.tickByTick()) {
+        sendTickByTick(subscription.first, subscription.second.contract, subscription.second.type);
+    }
+    LOG_INFO("Replayed {} market data, {} depth, {} real-time bar and {} tick-by-tick subscriptions",
+             subscriptions.marketData().size(), subscriptions.depth().size(), subscriptions.realTimeBars().size(),
+             subscriptions.tickByTick().size());
+}
+
+void IBConnector::sendMarketData(int tickerId, const Contract& contract) {
+    outbound.subscribe(OutboundStream::MarketData, tickerId, [this, tickerId, contract] {
+        client->reqMktData(tickerId, contract, "", false, false, TagValueListSPtr());
+    });
+}
+
+void IBConnector::sendMarketDepth(int tickerId, const Contract& contract, int numRows, bool smartDepth) {
+    outbound.subscribe(OutboundStream::Depth, tickerId, [this, tickerId, contract, numRows, smartDepth] {
+        client->reqMktDepth(tickerId, contract, numRows, smartDepth, TagValueListSPtr());
+    });
+}
+
+void IBConnector::sendRealTimeBars(int tickerId, const Contract& contract) {
+    outbound.subscribe(OutboundStream::RealTimeBars, tickerId, [this, tickerId, contract] {
+        client->reqRealTimeBars(kRealTimeBarIdBase + tickerId, contract, BarEngine::kRealTimeBarSeconds, "TRADES",
+                                false, TagValueListSPtr());
+    });
+}
+
+int IBConnector::tickByTickReqId(int tickerId, TickByTickType type) {
+    return kTickByTickIdBase + tickerId * kTickByTickTypes + (static_cast<int>(type) - 1);
+}
+
+void IBConnector::sendTickByTick(int reqId, const Contract& contract, TickByTickType type) {
+    outbound.subscribe(OutboundStream::TickByTick, reqId, [this, reqId, contract, type] {
+        client->reqTickByTickData(reqId, contract, tickByTickTypeName(type), 0, false);
+    });
+}
+
+void IBConnector::requestAccountPnl(int reqId, const std::string& account) {
+    outbound.enqueue(OutboundPriority::Subscription, [this, reqId, account] { client->reqPnL(reqId, account, ""); });
+}
+
+void IBConnector::requestPositionPnl(int reqId, const std::string& account, long conId) {
+    outbound.enqueue(OutboundPriority::Subscription, [this, reqId, account, conId] {
+        client->reqPnLSingle(reqId, account, "", static_cast<int>(conId));
+    });
+}
+
+void IBConnector::recordFirstTick(int64_t pendingSinceNs) {
+    int64_t elapsedNs = monotonicNanos() - pendingSinceNs;
+    {
+        std::lock_guard<std::mutex> lock(reconnectMutex);
+        reconnectTotals.lastTimeToFirstTickNs = elapsedNs;
+    }
+    LOG_INFO("First tick {} ms after the connection was lost", elapsedNs / 1000000);
+}
+
+ReconnectStats IBConnector::reconnectStats() const {
+    std::lock_guard<std::mutex> lock(reconnectMutex);
+    return reconnectTotals;
 }
 
 void IBConnector::managedAccounts(const std::string& accountsList) {
@@ -168,191 +747,909 @@ void IBConnector::managedAccounts(const std::string& accountsList) {
             managedAccountsList.push_back(account);
         }
     }
+    defaultAccountCell.publish(managedAccountsList.size() == 1 ? managedAccountsList.front() : std::string());
     
-    log("Managed accounts: " + accountsList);
+    LOG_INFO("Managed accounts: {}", accountsList);
 }
 
-void IBConnector::requestAccountSummary() {
+RequestFuture IBConnector::requestAccountSummary(int timeoutMs) {
     if (!isConnected()) {
-        log("Not connected - cannot request account summary");
-        return;
+        LOG_WARN("Not connected - cannot request account summary");
+        return RequestTracker::settled(RequestStatus::NotConnected);
     }
     
     std::lock_guard<std::mutex> lock(dataMutex);
     accountSummaryData.clear();
+    accountSummaryDirty = true;
+    publishSnapshotsLocked();
+    
+    // Only two summary subscriptions may be active - replace the previous one
+    if (accountSummaryReqId != 0) {
+        int previousReqId = accountSummaryReqId;
+        outbound.enqueue(OutboundPriority::Subscription,
+                         [this, previousReqId] { client->cancelAccountSummary(previousReqId); });
+    }
+    accountSummaryReqId = nextRequestId.fetch_add(1);
+    RequestFuture future = requests.add(accountSummaryReqId, RequestKind::AccountSummary, requestDeadline(timeoutMs));
     
     // Request account summary for all accounts
-    client->reqAccountSummary(1, "All", "NetLiquidation,TotalCashValue,SettledCash,AccruedCash,BuyingPower,EquityWithLoanValue,PreviousEquityWithLoanValue,GrossPositionValue");
+    int reqId = accountSummaryReqId;
+    outbound.enqueue(OutboundPriority::Subscription, [this, reqId] {
+        client->reqAccountSummary(reqId, "All", "NetLiquidation,TotalCashValue,SettledCash,AccruedCash,BuyingPower,EquityWithLoanValue,PreviousEquityWithLoanValue,GrossPositionValue");
+    });
     
-    log("Requested account summary");
+    LOG_INFO("Requested account summary (ID: {})", accountSummaryReqId);
+    return future;
 }
 
 void IBConnector::accountSummary(int reqId, const std::string& account, const std::string& tag,
                                 const std::string& value, const std::string& currency) {
+    CallbackTimer timer(statsRecorder, CallbackType::AccountSummary);
+    
     std::lock_guard<std::mutex> lock(dataMutex);
     accountSummaryData.push_back({account, tag, value, currency});
+    accountSummaryDirty = true;
     
     // Only log important account info
     if (tag == "NetLiquidation" || tag == "TotalCashValue" || tag == "BuyingPower" || 
         tag == "AvailableFunds" || tag == "GrossPositionValue") {
-        log("Account " + account + " - " + tag + ": $" + value);
+        LOG_INFO("Account {} - {}: ${}", account, tag, value);
     }
 }
 
 void IBConnector::accountSummaryEnd(int reqId) {
-    log("Account summary complete");
+    // Waiters read the snapshot as soon as the future completes
+    publishSnapshots();
+    requests.complete(reqId);
+    LOG_INFO("Account summary complete");
 }
 
-void IBConnector::requestPositions() {
+RequestFuture IBConnector::requestPositions(int timeoutMs) {
     if (!isConnected()) {
-        log("Not connected - cannot request positions");
-        return;
+        LOG_WARN("Not connected - cannot request positions");
+        return RequestTracker::settled(RequestStatus::NotConnected);
     }
     
-    std::lock_guard<std::mutex> lock(dataMutex);
-    positionsData.clear();
-    
-    client->reqPositions();
-    log("Requested positions");
+    // Positions update in place, so there is nothing to clear; positionEnd carries
+    // no id and completes every outstanding positions request
+    RequestFuture future = requests.add(nextRequestId.fetch_add(1), RequestKind::Positions, requestDeadline(timeoutMs));
+    outbound.enqueue(OutboundPriority::Subscription, [this] { client->reqPositions(); });
+    LOG_INFO("Requested positions");
+    return future;
 }
 
 void IBConnector::position(const std::string& account, const Contract& contract,
                           double position, double avgCost) {
+    CallbackTimer timer(statsRecorder, CallbackType::Position);
+    
+    if (ConnectorEvent* event = claimEvent(EventType::Position, wallClockNanos())) {
+        event->position.conId = contract.conId;
+        event->position.position = position;
+        event->position.avgCost = avgCost;
+        copyEventText(event->position.account, account);
+        copyEventText(event->position.symbol, contract.symbol);
+        events.publish();
+    }
+    
     std::lock_guard<std::mutex> lock(dataMutex);
-    positionsData.push_back({account, contract, position, avgCost});
+    bool created = false;
+    size_t entry = positionBook.update(account, contract, position, avgCost, created);
+    positionsDirty = true;
+    riskGate.setPosition(account, contract.symbol, position);
+    bool isOption = contract.secType == "OPT" || contract.secType == "FOP";
+    portfolio.setPosition(entry, account, contract.symbol, isOption, position,
+                          std::atof(contract.multiplier.c_str()), avgCost);
     
-    log("Position: " + account + " " + contract.symbol + " " + std::to_string(position) + " @ " + std::to_string(avgCost));
-}
-
-void IBConnector::positionEnd() {
-    log("Positions complete");
+    // Stream realized/daily P&L for every new position, and once per account
+    if (created && settings.subscribePnl && contract.conId != 0) {
+        int reqId = nextRequestId.fetch_add(1);
+        positionBook.setPnlRequest(entry, reqId);
+        requestPositionPnl(reqId, account, contract.conId);
+        
+        bool accountSubscribed = false;
+        for (const auto& request : accountPnlRequests) {
+            accountSubscribed = accountSubscribed || request.second == account;
+        }
+        if (!accountSubscribed) {
+            int accountReqId = nextRequestId.fetch_add(1);
+            accountPnlRequests[accountReqId] = account;
+            requestAccountPnl(accountReqId, account);
+        }
+    }
+    
+    LOG_INFO("Position: {} {} {} @ {}", account, contract.symbol, position, avgCost);
 }
 
-void IBConnector::requestMarketData(int tickerId, const Contract& contract) {
-    if (!isConnected()) {
-        log("Not connected - cannot request market data");
-        return;
+void IBConnector::pnl(int reqId, double dailyPnL, double unrealizedPnL, double realizedPnL) {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    auto it = accountPnlRequests.find(reqId);
+    if (it != accountPnlRequests.end()) {
+        positionBook.setAccountPnl(it->second, {unrealizedPnL, realizedPnL, dailyPnL});
     }
-    
-    client->reqMktData(tickerId, contract, "", false, false, TagValueListSPtr());
-    log("Requested market data for " + contract.symbol + " (ID: " + std::to_string(tickerId) + ")");
 }
 
-void IBConnector::cancelMarketData(int tickerId) {
-    if (!isConnected()) {
-        return;
+void IBConnector::pnlSingle(int reqId, int pos, double dailyPnL, double unrealizedPnL, double realizedPnL, double value) {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    size_t entry = 0;
+    if (positionBook.applyPnlSingle(reqId, dailyPnL, unrealizedPnL, realizedPnL, value, &entry)) {
+        marksDirty = true;
+        const Position& p = positionBook.positions()[entry];
+        if (!p.liveMark && p.marketPrice > 0.0) {
+            portfolio.setPrice(entry, p.marketPrice);
+        }
     }
-    
-    client->cancelMktData(tickerId);
-    log("Cancelled market data for ID: " + std::to_string(tickerId));
 }
 
-void IBConnector::tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib& attribs) {
+void IBConnector::positionEnd() {
     {
         std::lock_guard<std::mutex> lock(dataMutex);
-        tickPrices[tickerId * 100 + field] = price;
-    }
-    
-    std::string fieldName;
-    switch (field) {
-        case 1: fieldName = "BID"; break;
-        case 2: fieldName = "ASK"; break;
-        case 4: fieldName = "LAST"; break;
-        default: fieldName = "FIELD_" + std::to_string(field); break;
-    }
-    
-    // Only log significant price updates to avoid spam
-    if (field == 1 || field == 2 || field == 4) {
-        log("AAPL " + fieldName + ": $" + std::to_string(price));
+        if (positionsResync) {
+            positionsResync = false;
+            // Closed while we were disconnected
+            for (size_t entry : positionBook.endSync()) {
+                const Position& p = positionBook.positions()[entry];
+                bool isOption = p.contract.secType == "OPT" || p.contract.secType == "FOP";
+                riskGate.setPosition(p.account, p.contract.symbol, 0.0);
+                portfolio.setPosition(entry, p.account, p.contract.symbol, isOption, 0.0,
+                                      std::atof(p.contract.multiplier.c_str()), p.avgCost);
+                positionsDirty = true;
+                LOG_INFO("Position {} {} closed while disconnected", p.account, p.contract.symbol);
+            }
+        }
     }
+    publishSnapshots();
+    requests.complete(RequestKind::Positions);
+    LOG_INFO("Positions complete");
 }
 
-void IBConnector::tickSize(TickerId tickerId, TickType field, int size) {
-    tickSizes[tickerId * 100 + field] = size;
-}
-
-void IBConnector::tickString(TickerId tickerId, TickType tickType, const std::string& value) {
-    // Handle string-based tick data
+size_t IBConnector::resolveContracts(const std::vector<std::string>& symbols, int timeoutSeconds) {
+    if (!isConnected()) {
+        LOG_WARN("Not connected - cannot resolve contracts");
+        return 0;
+    }
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSeconds);
+    const size_t maxInFlight = settings.contractRequestsInFlight > 0 ? settings.contractRequestsInFlight : 1;
+    const int64_t intervalNs = settings.contractRequestsPerSecond > 0
+        ? static_cast<int64_t>(1e9 / settings.contractRequestsPerSecond) : 0;
+    int64_t nextSendNs = monotonicNanos();
+    size_t requested = 0;
+    
+    // Keep up to maxInFlight lookups outstanding, paced under the gateway's message rate limit
+    for (const std::string& symbol : symbols) {
+        ContractRecord record;
+        if (contracts.find(symbol, record)) {
+            continue;
+        }
+        if (!contracts.waitForCapacity(maxInFlight, deadline) || !isConnected()) {
+            break;
+        }
+        int64_t now = monotonicNanos();
+        if (now < nextSendNs) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(nextSendNs - now));
+        }
+        nextSendNs = (now > nextSendNs ? now : nextSendNs) + intervalNs;
+        
+        Contract contract;
+        contract.symbol = symbol;
+        contract.secType = "STK";
+        contract.exchange = "SMART";
+        contract.currency = "USD";
+        
+        requestContractDetails(contract, timeoutSeconds * 1000);
+        ++requested;
+    }
+    
+    if (!contracts.waitForCapacity(1, deadline)) {
+        LOG_WARN("Contract lookups timed out with {} outstanding", contracts.inFlight());
+        contracts.abandonRequests();
+    }
+    contracts.save();
+    
+    size_t resolved = 0;
+    for (const std::string& symbol : symbols) {
+        ContractRecord record;
+        if (contracts.find(symbol, record)) {
+            ++resolved;
+        }
+    }
+    LOG_INFO("Resolved {}/{} contracts ({} looked up)", resolved, symbols.size(), requested);
+    return resolved;
 }
 
-void IBConnector::placeOrder(int orderId, const Contract& contract, const Order& order) {
+RequestFuture IBConnector::requestContractDetails(const Contract& contract, int timeoutMs) {
     if (!isConnected()) {
-        log("Not connected - cannot place order");
+        LOG_WARN("Not connected - cannot request contract details");
+        return RequestTracker::settled(RequestStatus::NotConnected);
+    }
+    
+    int reqId = nextRequestId.fetch_add(1);
+    contracts.beginRequest(reqId, contract.symbol);
+    RequestFuture future = requests.add(reqId, RequestKind::ContractDetails, requestDeadline(timeoutMs));
+    outbound.enqueue(OutboundPriority::History, [this, reqId, contract] { client->reqContractDetails(reqId, contract); });
+    return future;
+}
+
+// Symbols subscribed or traded before anyone resolved them are looked up in
+// the background, so later orders go out by conId. disconnect() saves them.
+void IBConnector::resolveOnFirstUse(const Contract& contract) {
+    if (contract.conId != 0 || contract.symbol.empty() || (!contract.secType.empty() && contract.secType != "STK") ||
+        !isConnected()) {
+        return;
+    }
+    int reqId = nextRequestId.fetch_add(1);
+    if (!contracts.claimLookup(reqId, contract.symbol)) {
         return;
     }
     
-    client->placeOrder(orderId, contract, order);
-    log("Placed order " + std::to_string(orderId) + " for " + contract.symbol);
+    Contract lookup;
+    lookup.symbol = contract.symbol;
+    lookup.secType = "STK";
+    lookup.exchange = "SMART";
+    lookup.currency = contract.currency.empty() ? "USD" : contract.currency;
+    outbound.enqueue(OutboundPriority::History, [this, reqId, lookup] { client->reqContractDetails(reqId, lookup); });
+    LOG_DEBUG("Looking up contract for {} (request {})", contract.symbol, reqId);
+}
+
+void IBConnector::contractDetails(int reqId, const ContractDetails& contractDetails) {
+    contracts.onDetails(reqId, contractDetails.contract, contractDetails.minTick);
+}
+
+void IBConnector::contractDetailsEnd(int reqId) {
+    contracts.finishRequest(reqId);
+    requests.complete(reqId);
+}
+
+RequestFuture IBConnector::requestHistoricalData(const HistoricalRequest& request, HistoricalBarHandler onBar,
+                                                int* reqIdOut, int timeoutMs) {
+    if (!isConnected()) {
+        LOG_WARN("Not connected - cannot request historical data");
+        return RequestTracker::settled(RequestStatus::NotConnected);
+    }
+    
+    int reqId = nextRequestId.fetch_add(1);
+    if (reqIdOut) {
+        *reqIdOut = reqId;
+    }
+    {
+        std::lock_guard<std::mutex> lock(historicalMutex);
+        historicalHandlers[reqId] = std::move(onBar);
+    }
+    RequestFuture future = requests.add(reqId, RequestKind::HistoricalData, requestDeadline(timeoutMs));
+    outbound.enqueue(OutboundPriority::History, [this, reqId, request] {
+        client->reqHistoricalData(reqId, request.contract, request.endDateTime, request.duration, request.barSize,
+                                  request.whatToShow, request.useRth ? 1 : 0, 2, false, TagValueListSPtr());
+    });
+    return future;
+}
+
+void IBConnector::cancelHistoricalData(int reqId) {
+    {
+        std::lock_guard<std::mutex> lock(historicalMutex);
+        if (historicalHandlers.erase(reqId) == 0) {
+            return;
+        }
+    }
+    requests.fail(reqId, 0, "Cancelled");
+    if (isConnected()) {
+        outbound.enqueue(OutboundPriority::History, [this, reqId] { client->cancelHistoricalData(reqId); });
+    }
+}
+
+void IBConnector::dropHistoricalHandler(int reqId) {
+    std::lock_guard<std::mutex> lock(historicalMutex);
+    historicalHandlers.erase(reqId);
 }
 
-void IBConnector::cancelOrder(int orderId) {
+void IBConnector::historicalData(TickerId reqId, const Bar& bar) {
+    // Called under the lock so cancelHistoricalData() never races a running handler
+    std::lock_guard<std::mutex> lock(historicalMutex);
+    auto it = historicalHandlers.find(static_cast<int>(reqId));
+    if (it != historicalHandlers.end()) {
+        it->second(bar);
+    }
+}
+
+void IBConnector::historicalDataEnd(int reqId, const std::string& startDateStr, const std::string& endDateStr) {
+    dropHistoricalHandler(reqId);
+    requests.complete(reqId);
+    LOG_DEBUG("Historical data {} complete ({} - {})", reqId, startDateStr, endDateStr);
+}
+
+void IBConnector::requestMarketData(int tickerId, const Contract& contract) {
+    if (!isConnected() && !reconnecting) {
+        LOG_WARN("Not connected - cannot request market data");
+        return;
+    }
+    
+    if (!quotes.inRange(tickerId)) {
+        LOG_ERROR("Ticker ID {} exceeds quote store capacity ({})", tickerId, quotes.capacity());
+        return;
+    }
+    
+    if (tickHistory) {
+        tickHistory->registerTicker(tickerId, contract.symbol);
+    }
+    positionOwner->resolveOnFirstUse(contract);
+    positionOwner->linkQuote(tickerId, contract);
+    
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
+    subscriptions.addMarketData(tickerId, contract);
     if (!isConnected()) {
-        log("Not connected - cannot cancel order");
+        LOG_INFO("Market data for {} (ID: {}) will be requested on reconnect", contract.symbol, tickerId);
+        return;
+    }
+    sendMarketData(tickerId, contract);
+    LOG_INFO("Requested market data for {} (ID: {})", contract.symbol, tickerId);
+}
+
+void IBConnector::requestMarketDepth(int tickerId, const Contract& contract, int numRows, bool smartDepth) {
+    if (!isConnected() && !reconnecting) {
+        LOG_WARN("Not connected - cannot request market depth");
+        return;
+    }
+    
+    if (!books.inRange(tickerId)) {
+        LOG_ERROR("Depth ID {} exceeds order book capacity ({})", tickerId, books.capacity());
         return;
     }
     
-    client->cancelOrder(orderId);
-    log("Cancelled order " + std::to_string(orderId));
+    numRows = std::min(numRows, OrderBookStore::kMaxLevels);
+    books.reset(tickerId);
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        smartDepthIds.erase(std::remove(smartDepthIds.begin(), smartDepthIds.end(), tickerId), smartDepthIds.end());
+        if (smartDepth) {
+            smartDepthIds.push_back(tickerId);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
+    subscriptions.addDepth(tickerId, {contract, numRows, smartDepth});
+    if (!isConnected()) {
+        LOG_INFO("Depth for {} (ID: {}) will be requested on reconnect", contract.symbol, tickerId);
+        return;
+    }
+    sendMarketDepth(tickerId, contract, numRows, smartDepth);
+    LOG_INFO("Requested {} depth rows for {} (ID: {})", numRows, contract.symbol, tickerId);
 }
 
-void IBConnector::requestAllOpenOrders() {
+void IBConnector::cancelMarketDepth(int tickerId) {
+    std::lock_guard<std::mutex> subscriptionLock(subscriptionMutex);
+    subscriptions.removeDepth(tickerId);
     if (!isConnected()) {
-        log("Not connected - cannot request open orders");
         return;
     }
     
-    std::lock_guard<std::mutex> lock(dataMutex);
-    openOrdersData.clear();
+    bool smartDepth = false;
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        auto it = std::find(smartDepthIds.begin(), smartDepthIds.end(), tickerId);
+        if (it != smartDepthIds.end()) {
+            smartDepth = true;
+            smartDepthIds.erase(it);
+        }
+    }
     
-    client->reqAllOpenOrders();
-    log("Requested all open orders");
+    outbound.unsubscribe(OutboundStream::Depth, tickerId,
+                         [this, tickerId, smartDepth] { client->cancelMktDepth(tickerId, smartDepth); });
+    LOG_INFO("Cancelled market depth for ID: {}", tickerId);
 }
 
-void IBConnector::openOrder(OrderId orderId, const Contract& contract, const Order& order, const OrderState& orderState) {
+void IBConnector::requestRealTimeBars(int tickerId, const Contract& contract) {
+    if (!isConnected() && !reconnecting) {
+        LOG_WARN("Not connected - cannot request real-time bars");
+        return;
+    }
+    if (!bars.enabled() || !bars.inRange(tickerId)) {
+        LOG_ERROR("Real-time bars for ID {} not requested: bars are disabled or the ID exceeds {}",
+                  tickerId, quotes.capacity());
+        return;
+    }
+    
+    bars.setSource(tickerId, BarSource::RealTimeBars);
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
+    subscriptions.addRealTimeBars(tickerId, contract);
+    if (!isConnected()) {
+        LOG_INFO("Real-time bars for {} (ID: {}) will be requested on reconnect", contract.symbol, tickerId);
+        return;
+    }
+    sendRealTimeBars(tickerId, contract);
+    LOG_INFO("Requested real-time bars for {} (ID: {})", contract.symbol, tickerId);
+}
+
+void IBConnector::cancelRealTimeBars(int tickerId) {
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
+    if (!subscriptions.removeRealTimeBars(tickerId)) {
+        return;
+    }
+    bars.setSource(tickerId, BarSource::Ticks);
+    if (!isConnected()) {
+        return;
+    }
+    
+    outbound.unsubscribe(OutboundStream::RealTimeBars, tickerId,
+                         [this, tickerId] { client->cancelRealTimeBars(kRealTimeBarIdBase + tickerId); });
+    LOG_INFO("Cancelled real-time bars for ID: {}", tickerId);
+}
+
+void IBConnector::requestTickByTick(int tickerId, const Contract& contract, TickByTickType type) {
+    if (!isConnected() && !reconnecting) {
+        LOG_WARN("Not connected - cannot request tick-by-tick data");
+        return;
+    }
+    if (!prints.reserve(tickerId)) {
+        LOG_ERROR("Tick-by-tick data for ID {} not requested: the ID exceeds {}", tickerId, prints.capacity());
+        return;
+    }
+    
+    int reqId = tickByTickReqId(tickerId, type);
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
+    subscriptions.addTickByTick(reqId, {tickerId, type, contract});
+    if (!isConnected()) {
+        LOG_INFO("{} tick-by-tick data for {} (ID: {}) will be requested on reconnect", tickByTickTypeName(type),
+                 contract.symbol, tickerId);
+        return;
+    }
+    sendTickByTick(reqId, contract, type);
+    LOG_INFO("Requested {} tick-by-tick data for {} (ID: {})", tickByTickTypeName(type), contract.symbol, tickerId);
+}
+
+void IBConnector::cancelTickByTick(int tickerId, TickByTickType type) {
+    int reqId = tickByTickReqId(tickerId, type);
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
+    if (!subscriptions.removeTickByTick(reqId)) {
+        return;
+    }
+    if (!isConnected()) {
+        return;
+    }
+    
+    outbound.unsubscribe(OutboundStream::TickByTick, reqId, [this, reqId] { client->cancelTickByTickData(reqId); });
+    LOG_INFO("Cancelled {} tick-by-tick data for ID: {}", tickByTickTypeName(type), tickerId);
+}
+
+void IBConnector::cancelMarketData(int tickerId) {
+    std::lock_guard<std::mutex> lock(subscriptionMutex);
+    subscriptions.removeMarketData(tickerId);
+    positionOwner->unlinkQuote(tickerId);
+    if (!isConnected()) {
+        return;
+    }
+    
+    outbound.unsubscribe(OutboundStream::MarketData, tickerId, [this, tickerId] { client->cancelMktData(tickerId); });
+    LOG_INFO("Cancelled market data for ID: {}", tickerId);
+}
+
+void IBConnector::tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib& attribs) {
+    CallbackTimer timer(statsRecorder, CallbackType::TickPrice);
+    
+    int64_t nowNs = wallClockNanos();
+    quotes.updatePrice(tickerId, field, price, nowNs);
+    if (ConnectorEvent* event = claimEvent(EventType::TickPrice, nowNs)) {
+        event->tick = {static_cast<int>(tickerId), static_cast<int>(field), price};
+        events.publish();
+    }
+    int64_t pendingSinceNs = firstTickPendingSinceNs.load(std::memory_order_relaxed);
+    if (pendingSinceNs != 0 && firstTickPendingSinceNs.compare_exchange_strong(pendingSinceNs, 0)) {
+        recordFirstTick(pendingSinceNs);
+    }
+    if (tickHistory) {
+        tickHistory->recordPrice(tickerId, field, price, nowNs);
+    }
+    if (field == 4 || field == 68) {
+        bars.onTradePrice(tickerId, price, nowNs);
+    }
+    
+    bool marksPositions = field == 1 || field == 2 || field == 4 || field == 66 || field == 67 || field == 68;
+    if (marksPositions && positionOwner->positionBook.tracksTicker(tickerId)) {
+        positionOwner->queueMark(tickerId);
+    }
+}
+
+void IBConnector::tickOptionComputation(TickerId tickerId, TickType tickType, double impliedVol, double delta,
+                                        double optPrice, double pvDividend, double gamma, double vega,
+                                        double theta, double undPrice) {
+    // Model Greeks (13, delayed 83) of held options feed the portfolio aggregation
+    if ((tickType != 13 && tickType != 83) || !positionOwner->positionBook.tracksTicker(tickerId)) {
+        return;
+    }
+    // Unset values arrive as DBL_MAX
+    if (!(delta >= -1.0 && delta <= 1.0) || std::fabs(gamma) > 1e300 || std::fabs(vega) > 1e300 ||
+        std::fabs(theta) > 1e300) {
+        return;
+    }
+    double underlyingPrice = std::fabs(undPrice) < 1e300 ? undPrice : 0.0;
+    positionOwner->applyGreeks(tickerId, delta, gamma, vega, theta, underlyingPrice);
+}
+
+void IBConnector::tickSize(TickerId tickerId, TickType field, int size) {
+    CallbackTimer timer(statsRecorder, CallbackType::TickSize);
+    
+    int64_t nowNs = wallClockNanos();
+    quotes.updateSize(tickerId, field, size, nowNs);
+    if (ConnectorEvent* event = claimEvent(EventType::TickSize, nowNs)) {
+        event->tick = {static_cast<int>(tickerId), static_cast<int>(field), static_cast<double>(size)};
+        events.publish();
+    }
+    if (tickHistory) {
+        tickHistory->recordSize(tickerId, field, size, nowNs);
+    }
+    if (field == 5 || field == 69) {
+        bars.onTradeSize(tickerId, size, nowNs);
+    }
+}
+
+void IBConnector::tickString(TickerId tickerId, TickType tickType, const std::string& value) {
+    CallbackTimer timer(statsRecorder, CallbackType::TickString);
+    
+    // Handle string-based tick data
+}
+
+void IBConnector::updateMktDepth(TickerId id, int position, int operation, int side, double price, int size) {
+    CallbackTimer timer(statsRecorder, CallbackType::MarketDepth);
+    
+    int64_t nowNs = wallClockNanos();
+    if (ConnectorEvent* event = claimEvent(EventType::Depth, nowNs)) {
+        event->depth = {static_cast<int>(id), position, operation, side, price, static_cast<double>(size)};
+        events.publish();
+    }
+    if (!books.update(id, position, operation, side, price, size, nowNs)) {
+        LOG_DEBUG("Ignored depth update for ID {} at position {}", id, position);
+    }
+}
+
+void IBConnector::realtimeBar(TickerId reqId, long time, double open, double high, double low, double close,
+                              long volume, double wap, int count) {
+    bars.onRealTimeBar(reqId - kRealTimeBarIdBase, static_cast<int64_t>(time) * 1000000000LL, open, high, low,
+                       close, static_cast<double>(volume), wap, count);
+}
+
+void IBConnector::tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size,
+                                    const TickAttribLast& tickAttribLast, const std::string& exchange,
+                                    const std::string& specialConditions) {
+    CallbackTimer timer(statsRecorder, CallbackType::TickByTick);
+    
+    TickPrint print = {};
+    print.timeNs = static_cast<int64_t>(time) * 1000000000LL;
+    print.receivedNs = wallClockNanos();
+    print.price = price;
+    print.size = size;
+    print.type = tickType == static_cast<int>(TickByTickType::AllLast) ? TickByTickType::AllLast : TickByTickType::Last;
+    print.flags = (tickAttribLast.pastLimit ? TickPrint::kPastLimit : 0) |
+                  (tickAttribLast.unreported ? TickPrint::kUnreported : 0);
+    copyEventText(print.exchange, exchange);
+    size_t first = specialConditions.find_first_not_of(' ');
+    if (first != std::string::npos) {
+        copyEventText(print.conditions, specialConditions.substr(first));
+    }
+    prints.append((reqId - kTickByTickIdBase) / kTickByTickTypes, print);
+}
+
+void IBConnector::tickByTickBidAsk(int reqId, time_t time, double bidPrice, double askPrice, int bidSize,
+                                   int askSize, const TickAttribBidAsk& tickAttribBidAsk) {
+    CallbackTimer timer(statsRecorder, CallbackType::TickByTick);
+    
+    TickPrint print = {};
+    print.timeNs = static_cast<int64_t>(time) * 1000000000LL;
+    print.receivedNs = wallClockNanos();
+    print.price = bidPrice;
+    print.askPrice = askPrice;
+    print.size = bidSize;
+    print.askSize = askSize;
+    print.type = TickByTickType::BidAsk;
+    print.flags = (tickAttribBidAsk.bidPastLow ? TickPrint::kBidPastLow : 0) |
+                  (tickAttribBidAsk.askPastHigh ? TickPrint::kAskPastHigh : 0);
+    prints.append((reqId - kTickByTickIdBase) / kTickByTickTypes, print);
+}
+
+void IBConnector::tickByTickMidPoint(int reqId, time_t time, double midPoint) {
+    CallbackTimer timer(statsRecorder, CallbackType::TickByTick);
+    
+    TickPrint print = {};
+    print.timeNs = static_cast<int64_t>(time) * 1000000000LL;
+    print.receivedNs = wallClockNanos();
+    print.price = midPoint;
+    print.type = TickByTickType::MidPoint;
+    prints.append((reqId - kTickByTickIdBase) / kTickByTickTypes, print);
+}
+
+void IBConnector::updateMktDepthL2(TickerId id, int position, const std::string& marketMaker, int operation,
+                                   int side, double price, int size, bool isSmartDepth) {
+    // Books are aggregated by position; the reporting exchange/market maker is not kept
+    updateMktDepth(id, position, operation, side, price, size);
+}
+
+OrderId IBConnector::allocateOrderId() {
+    return nextOrderId.fetch_add(1);
+}
+
+OrderReject IBConnector::placeOrder(int orderId, const Contract& symbolContract, const Order& order,
+                                    int64_t* submittedNs) {
+    if (!isConnected()) {
+        LOG_WARN("Not connected - cannot place order");
+        return OrderReject::NotConnected;
+    }
+    
+    // Send by conId when the registry knows the symbol, so the gateway does not resolve it again
+    Contract contract = symbolContract;
+    if (!contracts.qualify(contract)) {
+        resolveOnFirstUse(contract);
+    }
+    
+    // placeOrder on a working order's id modifies it. The id of an order that
+    // has ended cannot be reused: its stage can no longer move, so the new
+    // order would never be tracked or released.
+    RiskHold hold;
+    OrderReject reject = checkOrderId(orderId, contract, order, hold);
+    if (reject != OrderReject::None) {
+        LOG_WARN("Order {} for {} rejected: {}", orderId, contract.symbol, orderRejectName(reject));
+        return reject;
+    }
+    
+    // Orders without an account keep the one they were placed under, or go to
+    // the only managed account, which is also the account positions are
+    // reported under. With several there is no safe default: limits kept
+    // under "" would never see the real positions.
+    SnapshotHandle<std::string> defaultAccount = defaultAccountCell.load();
+    const std::string& account = !order.account.empty() ? order.account
+                               : !hold.account.empty() ? hold.account
+                               : defaultAccount->value;
+    if (account.empty()) {
+        LOG_WARN("Order {} for {} rejected: no account given and not exactly one managed account", orderId,
+                 contract.symbol);
+        return OrderReject::NoAccount;
+    }
+    
+    // Lock-free; dataMutex is only taken below to record the order. A modify
+    // reserves only the change from what the order already holds.
+    reject = riskGate.check(account, contract, order, hold.quantity, hold.slot);
+    if (reject != OrderReject::None) {
+        LOG_WARN("Order {} for {} rejected by risk checks: {}", orderId, contract.symbol, orderRejectName(reject));
+        return reject;
+    }
+    
+    std::shared_ptr<OrderDetails> previous;
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        
+        // An order we cannot track would escape the open-order count, the
+        // position limits and status tracking, so it is not sent at all. The
+        // order may also have ended, filled further or been modified by
+        // another caller while the checks ran.
+        bool existed = orders.find(orderId) != nullptr;
+        OrderRecord* record = orders.insert(orderId);
+        if (!record) {
+            reject = OrderReject::RiskCapacity;
+        } else if (isTerminal(record->stage)) {
+            reject = OrderReject::OrderEnded;
+        } else if (order.totalQuantity <= record->filled || existed != hold.modify) {
+            reject = OrderReject::InvalidOrder;
+        } else if (existed) {
+            RiskHold now = riskHold(*record);
+            if (now.quantity != hold.quantity || now.slot != hold.slot) {
+                reject = OrderReject::InvalidOrder;
+            }
+        }
+        if (reject != OrderReject::None) {
+            if (!record) {
+                LOG_ERROR("Order table full ({} orders) - order {} for {} rejected", orders.capacity(), orderId,
+                          contract.symbol);
+            } else {
+                LOG_WARN("Order {} for {} rejected: {}", orderId, contract.symbol, orderRejectName(reject));
+            }
+            riskGate.undoCheck(account, contract.symbol, order, hold.quantity, hold.slot);
+            return reject;
+        }
+        previous = record->details;
+        OrderDetails& details = record->mutableDetails();
+        details.contract = contract;
+        details.order = order;
+        details.order.account = account;
+        // A modify keeps what has already filled
+        record->remaining = order.totalQuantity - record->filled;
+        record->updateTimeNs = wallClockNanos();
+        record->riskReserved = riskGate.enabled();
+        record->riskQuantity = order.totalQuantity;
+        // Published by the processing thread with its next batch
+        ordersDirty = true;
+    }
+    
+    // Encoded here, outside any lock; the sender thread only copies the bytes out
+    std::string encoded;
+    client->capture(encoded, [&] { client->placeOrder(orderId, contract, order); });
+    int64_t submitNs = outbound.submit(OutboundPriority::Order, orderId, encoded);
+    if (submittedNs) {
+        *submittedNs = submitNs;
+    }
+    if (submitNs == 0) {
+        LOG_ERROR("Outbound command queue full - order {} for {} not sent", orderId, contract.symbol);
+        if (hold.modify) {
+            revertModify(orderId, std::move(previous), hold);
+        } else {
+            abandonOrder(orderId);
+        }
+        return OrderReject::QueueFull;
+    }
+    LOG_INFO("Placed order {} for {}", orderId, contract.symbol);
+    return OrderReject::None;
+}
+
+IBConnector::RiskHold IBConnector::riskHold(const OrderRecord& record) {
+    // An order that holds nothing (placed elsewhere, or with the gate off) is
+    // treated as new for what has not filled yet
+    RiskHold hold;
+    hold.modify = true;
+    hold.slot = record.riskReserved;
+    hold.quantity = record.riskReserved ? record.riskQuantity : record.filled;
+    if (record.details) {
+        hold.account = record.details->order.account;
+    }
+    return hold;
+}
+
+OrderReject IBConnector::checkOrderId(OrderId orderId, const Contract& contract, const Order& order,
+                                      RiskHold& hold) const {
     std::lock_guard<std::mutex> lock(dataMutex);
+    const OrderRecord* existing = orders.find(orderId);
+    if (!existing) {
+        return OrderReject::None;
+    }
+    if (isTerminal(existing->stage)) {
+        return OrderReject::OrderEnded;
+    }
+    hold = riskHold(*existing);
+    // A modify cannot take the quantity below what has already filled, nor
+    // move the order to another side, symbol or account
+    if (order.totalQuantity <= existing->filled) {
+        return OrderReject::InvalidOrder;
+    }
+    if (existing->details) {
+        const OrderDetails& details = *existing->details;
+        if (order.action != details.order.action || contract.symbol != details.contract.symbol ||
+            (!order.account.empty() && !hold.account.empty() && order.account != hold.account)) {
+            return OrderReject::InvalidOrder;
+        }
+    }
+    return OrderReject::None;
+}
+
+void IBConnector::revertModify(OrderId orderId, std::shared_ptr<OrderDetails> previous, const RiskHold& hold) {
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        OrderRecord* record = orders.find(orderId);
+        // An order that ended meanwhile has already released the modified reservation
+        if (record && !isTerminal(record->stage) && record->details) {
+            // Back to what the order held before, fills since included
+            const OrderDetails& modified = *record->details;
+            riskGate.undoCheck(modified.order.account, modified.contract.symbol, modified.order,
+                               hold.slot ? hold.quantity : record->filled, hold.slot);
+            record->riskReserved = hold.slot;
+            record->riskQuantity = hold.slot ? hold.quantity : 0.0;
+            if (previous) {
+                record->remaining = previous->order.totalQuantity - record->filled;
+            }
+            record->details = std::move(previous);
+            ordersDirty = true;
+        }
+    }
+    publishSnapshots();
+}
+
+void IBConnector::abandonOrder(OrderId orderId) {
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        OrderRecord* record = orders.find(orderId);
+        if (record && !isTerminal(record->stage)) {
+            orders.transition(*record, OrderStage::Rejected, wallClockNanos());
+            record->status = "Rejected";
+            releaseRisk(*record, record->filled, false);
+            ordersDirty = true;
+        }
+    }
+    publishSnapshots();
+}
+
+int64_t IBConnector::cancelOrder(int orderId) {
+    if (!isConnected()) {
+        LOG_WARN("Not connected - cannot cancel order");
+        return 0;
+    }
     
-    // Find existing order or create new entry
-    auto it = std::find_if(openOrdersData.begin(), openOrdersData.end(),
-                          [orderId](const OrderInfo& info) { return info.orderId == orderId; });
+    std::string encoded;
+    client->capture(encoded, [&] { client->cancelOrder(orderId); });
+    int64_t submitNs = outbound.submit(OutboundPriority::Cancel, orderId, encoded);
+    if (submitNs == 0) {
+        LOG_ERROR("Outbound command queue full - cancel for order {} not sent", orderId);
+        return 0;
+    }
+    LOG_INFO("Cancelled order {}", orderId);
+    return submitNs;
+}
+
+RequestFuture IBConnector::requestAllOpenOrders(int timeoutMs) {
+    if (!isConnected()) {
+        LOG_WARN("Not connected - cannot request open orders");
+        return RequestTracker::settled(RequestStatus::NotConnected);
+    }
     
-    if (it != openOrdersData.end()) {
-        it->contract = contract;
-        it->order = order;
-        it->orderState = orderState;
-    } else {
-        OrderInfo info;
-        info.orderId = orderId;
-        info.contract = contract;
-        info.order = order;
-        info.orderState = orderState;
-        openOrdersData.push_back(info);
+    // Known orders keep their stage; openOrder/orderStatus replies update them in place
+    RequestFuture future = requests.add(nextRequestId.fetch_add(1), RequestKind::OpenOrders, requestDeadline(timeoutMs));
+    outbound.enqueue(OutboundPriority::Subscription, [this] { client->reqAllOpenOrders(); });
+    LOG_INFO("Requested all open orders");
+    return future;
+}
+
+void IBConnector::openOrder(OrderId orderId, const Contract& contract, const Order& order, const OrderState& orderState) {
+    CallbackTimer timer(statsRecorder, CallbackType::OpenOrder);
+    
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        OrderRecord* record = orders.insert(orderId);
+        if (ordersResync) {
+            resyncSeenOrders.push_back(orderId);
+        }
+        if (record) {
+            OrderDetails& details = record->mutableDetails();
+            details.contract = contract;
+            details.order = order;
+            details.orderState = orderState;
+            ordersDirty = true;
+        }
     }
     
-    log("Open order: " + std::to_string(orderId) + " " + contract.symbol + " " + order.action + " " + std::to_string(order.totalQuantity));
+    LOG_INFO("Open order: {} {} {} {}", orderId, contract.symbol, order.action, order.totalQuantity);
 }
 
 void IBConnector::openOrderEnd() {
-    log("Open orders complete");
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        if (ordersResync) {
+            ordersResync = false;
+            reconcileOrders();
+        }
+    }
+    publishSnapshots();
+    requests.complete(RequestKind::OpenOrders);
+    LOG_INFO("Open orders complete");
 }
 
 void IBConnector::orderStatus(OrderId orderId, const std::string& status, double filled,
                              double remaining, double avgFillPrice, int permId, int parentId,
                              double lastFillPrice, int clientId, const std::string& whyHeld, double mktCapPrice) {
-    std::lock_guard<std::mutex> lock(dataMutex);
+    CallbackTimer timer(statsRecorder, CallbackType::OrderStatus);
     
-    // Update order status
-    auto it = std::find_if(openOrdersData.begin(), openOrdersData.end(),
-                          [orderId](const OrderInfo& info) { return info.orderId == orderId; });
+    if (ConnectorEvent* event = claimEvent(EventType::OrderStatus, wallClockNanos())) {
+        event->order.orderId = orderId;
+        event->order.filled = filled;
+        event->order.remaining = remaining;
+        event->order.avgFillPrice = avgFillPrice;
+        event->order.lastFillPrice = lastFillPrice;
+        copyEventText(event->order.status, status);
+        events.publish();
+    }
     
-    if (it != openOrdersData.end()) {
-        it->status = status;
-        it->filled = filled;
-        it->remaining = remaining;
-        it->avgFillPrice = avgFillPrice;
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        OrderRecord* record = orders.insert(orderId);
+        if (ordersResync) {
+            resyncSeenOrders.push_back(orderId);
+        }
+        if (record) {
+            double previousFilled = record->filled;
+            bool wasTerminal = isTerminal(record->stage);
+            if (orders.applyStatus(*record, status, filled, remaining, avgFillPrice,
+                                   lastFillPrice, permId, wallClockNanos())) {
+                releaseRisk(*record, previousFilled, wasTerminal);
+                ordersDirty = true;
+            } else {
+                LOG_DEBUG("Ignored stale status {} for order {} ({})", status, orderId, orderStageName(record->stage));
+            }
+        }
     }
     
-    log("Order status: " + std::to_string(orderId) + " " + status + " filled: " + std::to_string(filled) + 
-        " remaining: " + std::to_string(remaining) + " avg price: " + std::to_string(avgFillPrice));
+    LOG_INFO("Order status: {} {} filled: {} remaining: {} avg price: {}",
+             orderId, status, filled, remaining, avgFillPrice);
 }
 
 std::vector<std::string> IBConnector::getManagedAccounts() const {
@@ -361,38 +1658,309 @@ std::vector<std::string> IBConnector::getManagedAccounts() const {
 }
 
 std::vector<IBConnector::AccountSummaryItem> IBConnector::getAccountSummary() const {
-    std::lock_guard<std::mutex> lock(dataMutex);
-    return accountSummaryData;
+    return accountSummaryCell.load()->value;
 }
 
 std::vector<IBConnector::PositionItem> IBConnector::getPositions() const {
-    std::lock_guard<std::mutex> lock(dataMutex);
-    return positionsData;
+    return positionsCell.load()->value;
 }
 
 std::vector<IBConnector::OrderInfo> IBConnector::getOpenOrders() const {
+    return openOrdersCell.load()->value;
+}
+
+PnlTotals IBConnector::getPnlTotals() const {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    return positionBook.totals();
+}
+
+bool IBConnector::getAccountPnl(const std::string& account, PnlTotals& out) const {
     std::lock_guard<std::mutex> lock(dataMutex);
-    return openOrdersData;
+    return positionBook.getAccountPnl(account, out);
 }
 
-std::map<int, double> IBConnector::getTickPrices() const {
+bool IBConnector::marksDue(int64_t nowNs) const {
+    return marksDirty.load(std::memory_order_relaxed) &&
+           nowNs - lastPositionsPublishNs.load(std::memory_order_relaxed) >=
+               static_cast<int64_t>(settings.positionMarkPublishMs) * 1000000;
+}
+
+void IBConnector::publishSnapshots() {
+    if (!accountSummaryDirty.load(std::memory_order_relaxed) && !positionsDirty.load(std::memory_order_relaxed) &&
+        !ordersDirty.load(std::memory_order_relaxed) && markQueue.sizeApprox() == 0 && !marksDue(monotonicNanos())) {
+        return;
+    }
     std::lock_guard<std::mutex> lock(dataMutex);
-    return tickPrices;
+    publishSnapshotsLocked();
+}
+
+void IBConnector::publishSnapshotsLocked() {
+    // Price ticks since the last pass; the tick path never takes dataMutex
+    applyMarks();
+    
+    // One new version per domain per batch of callbacks, not per callback
+    if (accountSummaryDirty.exchange(false)) {
+        accountSummaryCell.publish(accountSummaryData);
+    }
+    // Copying the positions is O(positions), so ticks that only re-mark them are
+    // folded into one republish per positionMarkPublishMs
+    int64_t nowNs = monotonicNanos();
+    if (positionsDirty.exchange(false) || marksDue(nowNs)) {
+        marksDirty = false;
+        lastPositionsPublishNs.store(nowNs, std::memory_order_relaxed);
+        positionsCell.publish(positionBook.positions());
+    }
+    if (ordersDirty.exchange(false)) {
+        std::vector<OrderInfo> open;
+        orders.forEach([&open](const OrderRecord& record) {
+            if (!isTerminal(record.stage)) {
+                open.push_back(toOrderInfo(record));
+            }
+        });
+        openOrdersCell.publish(std::move(open));
+    }
+}
+
+bool IBConnector::getOrder(OrderId orderId, OrderInfo& out) const {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    const OrderRecord* record = orders.find(orderId);
+    if (!record) {
+        return false;
+    }
+    out = toOrderInfo(*record);
+    return true;
+}
+
+IBConnector::OrderInfo IBConnector::toOrderInfo(const OrderRecord& record) {
+    static const std::shared_ptr<const OrderDetails> noDetails = std::make_shared<const OrderDetails>();
+    OrderInfo info;
+    info.orderId = record.orderId;
+    info.details = record.details ? record.details : noDetails;
+    info.stage = record.stage;
+    info.status = record.status.empty() ? orderStageName(record.stage) : record.status;
+    info.filled = record.filled;
+    info.remaining = record.remaining;
+    info.avgFillPrice = record.avgFillPrice;
+    info.lastFillPrice = record.lastFillPrice;
+    info.permId = record.permId;
+    return info;
+}
+
+void IBConnector::reconcileOrders() {
+    // Orders still working before the outage that the gateway no longer reports
+    // as open have ended meanwhile, possibly by filling. They keep their stage
+    // and reservation, marked Unknown, until the executions since the loss are in.
+    std::sort(resyncSeenOrders.begin(), resyncSeenOrders.end());
+    unconfirmedOrders.clear();
+    orders.forEach([this](const OrderRecord& record) {
+        if (!isTerminal(record.stage) &&
+            !std::binary_search(resyncSeenOrders.begin(), resyncSeenOrders.end(), record.orderId)) {
+            unconfirmedOrders.push_back(record.orderId);
+        }
+    });
+    resyncSeenOrders.clear();
+    if (unconfirmedOrders.empty()) {
+        return;
+    }
+    
+    for (OrderId orderId : unconfirmedOrders) {
+        orders.find(orderId)->status = "Unknown";
+        LOG_WARN("Order {} is no longer open after reconnecting - checking executions", orderId);
+    }
+    ordersDirty = true;
+    
+    // Our own executions since the connection was lost; cumQty is per order,
+    // so the newest one for an order gives its fill total
+    ExecutionFilter filter;
+    filter.m_clientId = sessionClientId;
+    filter.m_time = formatExecutionTime(resyncSinceNs);
+    executionsReqId = nextRequestId.fetch_add(1);
+    resyncFills.clear();
+    requests.add(executionsReqId, RequestKind::Executions, requestDeadline(kDefaultRequestTimeoutMs));
+    int reqId = executionsReqId;
+    outbound.enqueue(OutboundPriority::Subscription, [this, reqId, filter] { client->reqExecutions(reqId, filter); });
+}
+
+void IBConnector::execDetails(int reqId, const Contract& contract, const Execution& execution) {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    // Live fills are applied from orderStatus; only the resync request is used here
+    if (reqId == 0 || reqId != executionsReqId) {
+        return;
+    }
+    std::pair<double, double>& fill = resyncFills[execution.orderId];
+    if (execution.cumQty > fill.first) {
+        fill = {execution.cumQty, execution.avgPrice};
+    }
+}
+
+void IBConnector::execDetailsEnd(int reqId) {
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        if (reqId == 0 || reqId != executionsReqId) {
+            return;
+        }
+        settleUnconfirmedOrders();
+    }
+    publishSnapshots();
+    requests.complete(reqId);
+    LOG_INFO("Executions since the reconnect complete");
+}
+
+void IBConnector::settleUnconfirmedOrders() {
+    for (OrderId orderId : unconfirmedOrders) {
+        OrderRecord* record = orders.find(orderId);
+        if (!record || isTerminal(record->stage)) {
+            continue;       // a status update has settled it already
+        }
+        
+        double previousFilled = record->filled;
+        auto fill = resyncFills.find(orderId);
+        double filled = fill != resyncFills.end() ? std::max(fill->second.first, previousFilled) : previousFilled;
+        double total = record->details ? record->details->order.totalQuantity : previousFilled + record->remaining;
+        bool complete = filled >= total && filled > 0.0;
+        if (fill != resyncFills.end() && fill->second.first > previousFilled) {
+            record->avgFillPrice = fill->second.second;
+        }
+        
+        // Positions already reported after the reconnect include these fills;
+        // otherwise they reach the risk gate as fills, as they would have live
+        record->filled = positionsResync ? filled : previousFilled;
+        orders.transition(*record, complete ? OrderStage::Filled : OrderStage::Cancelled, wallClockNanos());
+        releaseRisk(*record, previousFilled, false);
+        record->filled = filled;
+        record->remaining = complete ? 0.0 : total - filled;
+        record->status = complete ? "Filled" : "Inactive";
+        ordersDirty = true;
+        LOG_WARN("Order {} {} while disconnected ({} filled)", orderId, complete ? "filled" : "ended", filled);
+    }
+    unconfirmedOrders.clear();
+    resyncFills.clear();
+    executionsReqId = 0;
+}
+
+void IBConnector::releaseRisk(OrderRecord& record, double previousFilled, bool wasTerminal) {
+    if (!record.riskReserved || !record.details) {
+        return;
+    }
+    
+    const Order& order = record.details->order;
+    const std::string& symbol = record.details->contract.symbol;
+    bool buy = order.action == "BUY";
+    
+    if (record.filled > previousFilled) {
+        riskGate.onFill(order.account, symbol, buy, record.filled - previousFilled);
+    }
+    if (!wasTerminal && isTerminal(record.stage)) {
+        double unfilled = record.riskQuantity - record.filled;
+        riskGate.onOrderClosed(order.account, symbol, buy, unfilled > 0.0 ? unfilled : 0.0);
+        record.riskReserved = false;
+    }
+}
+
+void IBConnector::linkQuote(int tickerId, const Contract& contract) {
+    riskGate.registerQuote(contract.symbol, tickerId);
+    std::lock_guard<std::mutex> lock(dataMutex);
+    positionBook.linkQuote(contract, tickerId);
+}
+
+void IBConnector::unlinkQuote(int tickerId) {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    positionBook.unlinkQuote(tickerId);
+}
+
+void IBConnector::queueMark(TickerId tickerId) {
+    // Queued once until applyMarks() takes it, so the queue never holds more
+    // than one entry per ticker and cannot fill up
+    if (!markQueued[tickerId].exchange(true, std::memory_order_acq_rel)) {
+        markQueue.tryPush([tickerId](long& slot) { slot = tickerId; });
+    }
+}
+
+void IBConnector::applyMarks() {
+    markQueue.drain([this](long tickerId) {
+        // Cleared before the quote is read, so a tick after the read queues the ticker again
+        markQueued[tickerId].exchange(false, std::memory_order_acq_rel);
+        // Re-mark held positions on this ticker: last trade, else the mid
+        Quote quote = quotes.get(tickerId);
+        double mark = quote.last > 0.0 ? quote.last
+                    : (quote.bid > 0.0 && quote.ask > 0.0 ? (quote.bid + quote.ask) / 2.0 : 0.0);
+        if (positionBook.mark(tickerId, mark)) {
+            marksDirty = true;
+            for (uint32_t entry : positionBook.entriesOnTicker(tickerId)) {
+                portfolio.setPrice(entry, mark);
+            }
+        }
+    });
+}
+
+void IBConnector::applyGreeks(TickerId tickerId, double delta, double gamma, double vega, double theta,
+                              double underlyingPrice) {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    if (!positionBook.tracksTicker(tickerId)) {
+        return;
+    }
+    for (uint32_t entry : positionBook.entriesOnTicker(tickerId)) {
+        portfolio.setGreeks(entry, delta, gamma, vega, theta, underlyingPrice);
+    }
+}
+
+Quote IBConnector::getQuote(TickerId tickerId) const {
+    return quotes.get(tickerId);
+}
+
+PortfolioRisk IBConnector::getPortfolioRisk() {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    applyMarks();
+    return portfolio.refresh();
+}
+
+void IBConnector::setRiskFactors(const std::string& symbol, double beta, const std::string& sector) {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    portfolio.setRiskFactors(symbol, beta, sector);
+}
+
+bool IBConnector::getOrderBook(TickerId tickerId, BookSnapshot& out, int maxLevels) const {
+    return books.snapshot(tickerId, out, maxLevels);
 }
 
 void IBConnector::clearData() {
+    {
+        // Taken before dataMutex, in the same order as the subscription calls
+        std::lock_guard<std::mutex> lock(subscriptionMutex);
+        subscriptions.clear();
+    }
+    
     std::lock_guard<std::mutex> lock(dataMutex);
     managedAccountsList.clear();
+    defaultAccountCell.publish(std::string());
     accountSummaryData.clear();
-    positionsData.clear();
-    openOrdersData.clear();
-    tickPrices.clear();
-    tickSizes.clear();
+    positionBook.clear();
+    portfolio.clear();
+    accountPnlRequests.clear();
+    orders.clear();
+    accountSummaryDirty = true;
+    positionsDirty = true;
+    ordersDirty = true;
+    publishSnapshotsLocked();
+    riskGate.reset();
+    contracts.abandonRequests();
+    {
+        std::lock_guard<std::mutex> historyLock(historicalMutex);
+        historicalHandlers.clear();
+    }
+    requests.failAll(RequestStatus::Disconnected);
+    accountSummaryReqId = 0;
+    positionsResync = false;
+    ordersResync = false;
+    resyncSeenOrders.clear();
+    unconfirmedOrders.clear();
+    executionsReqId = 0;
+    resyncFills.clear();
+    // A shared store is cleared by its owner once every writer has stopped
+    if (!quotesShared) {
+        quotes.clear();
+    }
+    books.clear();
+    smartDepthIds.clear();
+    bars.clear();
 }
-
-void IBConnector::log(const std::string& message) const {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    
-    std::cout << "[" << std::put_time(std::localtime(&time_t), "%H:%M:%S") << "] " << message << std::endl;
-}
\ No newline at end of file
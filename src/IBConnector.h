@@ -5,40 +5,150 @@
 #include "Contract.h"
 #include "Order.h"
 #include "OrderState.h"
+#include "Execution.h"
 #include "EReaderOSSignal.h"
-#include "EReader.h"
+#include "QuoteStore.h"
+#include "OrderBook.h"
+#include "OrderTable.h"
+#include "FrameQueue.h"
+#include "FrameReader.h"
+#include "Settings.h"
+#include "ConnectorStats.h"
+#include "FrameCapture.h"
+#include "TickHistory.h"
+#include "RiskGate.h"
+#include "ContractRegistry.h"
+#include "RequestTracker.h"
+#include "Snapshot.h"
+#include "PositionBook.h"
+#include "PortfolioAnalytics.h"
+#include "SubscriptionRegistry.h"
+#include "OutboundScheduler.h"
+#include "MpscQueue.h"
+#include "EventRing.h"
+#include "BarEngine.h"
+#include "TickByTickStore.h"
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
-#include <map>
+#include <unordered_map>
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <random>
+
+class EDecoder;
+
+// What a connection is used for; a ConnectionPool runs one Orders connection
+// and several MarketData ones.
+enum class ConnectionRole {
+    Standalone,     // everything on one socket (the default)
+    Orders,         // orders, accounts and positions; no startup market data
+    MarketData      // market data and depth only; no account requests at connect
+};
+
+// Connection losses and how quickly the session came back.
+struct ReconnectStats {
+    uint64_t connectionLosses = 0;
+    uint64_t reconnects = 0;
+    uint64_t failedAttempts = 0;
+    int64_t lastOutageNs = 0;           // connection lost -> session re-established
+    int64_t lastTimeToFirstTickNs = 0;  // connection lost -> first tick after reconnecting
+};
+
+// One reqHistoricalData call.
+struct HistoricalRequest {
+    Contract contract;
+    std::string endDateTime;            // "yyyymmdd hh:mm:ss GMT"; empty means now
+    std::string duration;               // "1800 S", "5 D", "1 W", "1 M", "1 Y"
+    std::string barSize;                // "1 secs", "1 min", "5 mins", "1 hour", "1 day"
+    std::string whatToShow = "TRADES";
+    bool useRth = true;
+};
+
+// Receives the bars of one historical request, on the message processing thread.
+using HistoricalBarHandler = std::function<void(const Bar& bar)>;
 
 class IBConnector : public DefaultEWrapper {
 public:
-    IBConnector();
+    static constexpr int kDefaultRequestTimeoutMs = 10000;
+    static constexpr int kDefaultHistoricalTimeoutMs = 120000;
+    
+    // With sharedQuotes, ticks are written to that store instead of a private
+    // one; every ticker id must then be subscribed on one connection only.
+    explicit IBConnector(const ConnectorSettings& settings = ConnectorSettings(),
+                         ConnectionRole role = ConnectionRole::Standalone,
+                         std::shared_ptr<QuoteStore> sharedQuotes = nullptr);
     ~IBConnector();
 
     // Connection management
+    // After a successful connect() a dropped session is re-established in the
+    // background (settings.reconnect): subscriptions are sent again and orders
+    // and positions are reconciled rather than cleared. disconnect() stops
+    // reconnecting and clears all data.
     bool connect(const std::string& host = "127.0.0.1", int port = 4001, int clientId = 1);
     void disconnect();
     bool isConnected() const;
+    bool isReconnecting() const { return reconnecting; }
+    ReconnectStats reconnectStats() const;
     
     // Account management
+    // Request/response calls return a future that completes on the matching end
+    // callback, fails on an error for the request id, or times out.
     std::vector<std::string> getManagedAccounts() const;
-    void requestAccountSummary();
-    void requestPositions();
+    RequestFuture requestAccountSummary(int timeoutMs = kDefaultRequestTimeoutMs);
+    RequestFuture requestPositions(int timeoutMs = kDefaultRequestTimeoutMs);
     
     // Market data
     void requestMarketData(int tickerId, const Contract& contract);
     void cancelMarketData(int tickerId);
+    void requestMarketDepth(int tickerId, const Contract& contract, int numRows = 10, bool smartDepth = true);
+    void cancelMarketDepth(int tickerId);
+    // Builds the ticker's bars from 5 second real-time bars (TRADES) instead of
+    // its LAST ticks; intervals that are not a multiple of 5 seconds get no bars.
+    void requestRealTimeBars(int tickerId, const Contract& contract);
+    void cancelRealTimeBars(int tickerId);
+    // Every print of a reqTickByTickData stream goes into the ticker's ring in
+    // tickByTick(); a ticker may have one stream of each type, sharing its ring.
+    void requestTickByTick(int tickerId, const Contract& contract, TickByTickType type);
+    void cancelTickByTick(int tickerId, TickByTickType type);
+    const TickByTickStore& tickByTick() const { return prints; }
+    
+    // Contracts
+    // Looks up symbols (US stocks on SMART) that are not in the registry yet with
+    // paced reqContractDetails batches, waits for them and saves the registry.
+    // Returns how many of the symbols are resolved afterwards.
+    size_t resolveContracts(const std::vector<std::string>& symbols, int timeoutSeconds = 60);
+    // One lookup; the result goes into the registry under contract.symbol.
+    RequestFuture requestContractDetails(const Contract& contract, int timeoutMs = kDefaultRequestTimeoutMs);
+    const ContractRegistry& contractRegistry() const { return contracts; }
+    
+    // Historical data
+    // Bars (formatDate 2: epoch seconds, or yyyymmdd for daily bars) are handed
+    // to onBar as they arrive and the future completes on historicalDataEnd.
+    // Requests go out at History priority but are not held to IB's historical
+    // pacing limits here; HistoricalDownloader does that. The request id is
+    // stored in reqIdOut, for cancelHistoricalData().
+    RequestFuture requestHistoricalData(const HistoricalRequest& request, HistoricalBarHandler onBar,
+                                        int* reqIdOut = nullptr, int timeoutMs = kDefaultHistoricalTimeoutMs);
+    // Stops delivery to the handler; for requests that timed out or are no longer wanted.
+    void cancelHistoricalData(int reqId);
     
     // Orders
-    void placeOrder(int orderId, const Contract& contract, const Order& order);
-    void cancelOrder(int orderId);
-    void requestAllOpenOrders();
+    // Hands out order ids from nextValidId onwards; safe from any thread.
+    OrderId allocateOrderId();
+    // Runs the pre-trade risk checks and sends the order; nothing is sent unless
+    // the result is OrderReject::None. Orders and cancels are encoded on the
+    // calling thread and handed to the sender thread without locking; the
+    // submission time (monotonicNanos()) is stored in submittedNs, and returned
+    // by cancelOrder (0 if nothing was sent). Placing a working order's id again
+    // modifies it; the id of an order that has ended is rejected (OrderEnded).
+    OrderReject placeOrder(int orderId, const Contract& contract, const Order& order,
+                           int64_t* submittedNs = nullptr);
+    int64_t cancelOrder(int orderId);
+    RequestFuture requestAllOpenOrders(int timeoutMs = kDefaultRequestTimeoutMs);
     
     // EWrapper interface implementation
     void nextValidId(OrderId orderId) override;
@@ -54,11 +164,35 @@ public:
     void position(const std::string& account, const Contract& contract,
                  double position, double avgCost) override;
     void positionEnd() override;
+    void pnl(int reqId, double dailyPnL, double unrealizedPnL, double realizedPnL) override;
+    void pnlSingle(int reqId, int pos, double dailyPnL, double unrealizedPnL, double realizedPnL, double value) override;
+    
+    // Contract callbacks
+    void contractDetails(int reqId, const ContractDetails& contractDetails) override;
+    void contractDetailsEnd(int reqId) override;
+    
+    // Historical data callbacks
+    void historicalData(TickerId reqId, const Bar& bar) override;
+    void historicalDataEnd(int reqId, const std::string& startDateStr, const std::string& endDateStr) override;
     
     // Market data callbacks
     void tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib& attribs) override;
+    void tickOptionComputation(TickerId tickerId, TickType tickType, double impliedVol, double delta,
+                               double optPrice, double pvDividend, double gamma, double vega, double theta,
+                               double undPrice) override;
     void tickSize(TickerId tickerId, TickType field, int size) override;
     void tickString(TickerId tickerId, TickType tickType, const std::string& value) override;
+    void updateMktDepth(TickerId id, int position, int operation, int side, double price, int size) override;
+    void updateMktDepthL2(TickerId id, int position, const std::string& marketMaker, int operation,
+                          int side, double price, int size, bool isSmartDepth) override;
+    void realtimeBar(TickerId reqId, long time, double open, double high, double low, double close,
+                     long volume, double wap, int count) override;
+    void tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size,
+                           const TickAttribLast& tickAttribLast, const std::string& exchange,
+                           const std::string& specialConditions) override;
+    void tickByTickBidAsk(int reqId, time_t time, double bidPrice, double askPrice, int bidSize, int askSize,
+                          const TickAttribBidAsk& tickAttribBidAsk) override;
+    void tickByTickMidPoint(int reqId, time_t time, double midPoint) override;
     
     // Order callbacks
     void openOrder(OrderId orderId, const Contract& contract, const Order& order, const OrderState& orderState) override;
@@ -66,6 +200,8 @@ public:
     void orderStatus(OrderId orderId, const std::string& status, double filled,
                     double remaining, double avgFillPrice, int permId, int parentId,
                     double lastFillPrice, int clientId, const std::string& whyHeld, double mktCapPrice) override;
+    void execDetails(int reqId, const Contract& contract, const Execution& execution) override;
+    void execDetailsEnd(int reqId) override;
     
     // Getters for data
     OrderId getNextValidOrderId() const { return nextOrderId; }
@@ -77,51 +213,205 @@ public:
         std::string currency;
     };
     
-    struct PositionItem {
-        std::string account;
-        Contract contract;
-        double position;
-        double avgCost;
-    };
+    using PositionItem = Position;
     
     struct OrderInfo {
         OrderId orderId;
-        Contract contract;
-        Order order;
-        OrderState orderState;
+        std::shared_ptr<const OrderDetails> details;    // shared with the order table and other snapshot versions
+        OrderStage stage;
         std::string status;
         double filled;
         double remaining;
         double avgFillPrice;
+        double lastFillPrice;
+        int permId;
+        
+        const Contract& contract() const { return details->contract; }
+        const Order& order() const { return details->order; }
+        const OrderState& orderState() const { return details->orderState; }
     };
     
+    // Immutable, versioned views published by the message processing thread
+    // after each batch of callbacks. Taking one is lock-free and copies nothing;
+    // a handle stays valid (and unchanged) for as long as it is held.
+    using AccountSummarySnapshot = SnapshotHandle<std::vector<AccountSummaryItem>>;
+    using PositionsSnapshot = SnapshotHandle<std::vector<PositionItem>>;
+    using OrdersSnapshot = SnapshotHandle<std::vector<OrderInfo>>;
+    AccountSummarySnapshot accountSummarySnapshot() const { return accountSummaryCell.load(); }
+    PositionsSnapshot positionsSnapshot() const { return positionsCell.load(); }
+    // Orders that have not reached a terminal stage
+    OrdersSnapshot openOrdersSnapshot() const { return openOrdersCell.load(); }
+    // Current versions, to skip work when nothing changed since a snapshot was taken
+    uint64_t accountSummaryVersion() const { return accountSummaryCell.version(); }
+    uint64_t positionsVersion() const { return positionsCell.version(); }
+    uint64_t openOrdersVersion() const { return openOrdersCell.version(); }
+    
+    // Copies of the current snapshots
     std::vector<AccountSummaryItem> getAccountSummary() const;
     std::vector<PositionItem> getPositions() const;
+    // Running P&L over all positions, and IB's account level figures
+    PnlTotals getPnlTotals() const;
+    bool getAccountPnl(const std::string& account, PnlTotals& out) const;
+    // Exposure and Greeks over all positions, by account and by sector
+    PortfolioRisk getPortfolioRisk();
+    // Beta and sector for positions on an underlying symbol (default: beta 1, unassigned)
+    void setRiskFactors(const std::string& symbol, double beta, const std::string& sector);
     std::vector<OrderInfo> getOpenOrders() const;
-    std::map<int, double> getTickPrices() const;
+    bool getOrder(OrderId orderId, OrderInfo& out) const;
+    Quote getQuote(TickerId tickerId) const;
+    bool getOrderBook(TickerId tickerId, BookSnapshot& out, int maxLevels = OrderBookStore::kMaxLevels) const;
+    
+    // Latency histograms, throughput and queue depth (safe from any thread)
+    ConnectorStats stats() const;
+    
+    // Consumers of the callback event stream (ticks, depth, order status,
+    // positions, errors, completed bars), each on its own thread; see EventRing. Events are
+    // published by the message processing thread before the callback's own
+    // state updates are visible in snapshots. Returns the consumer id, or -1.
+    int addEventConsumer(const EventRing::ConsumerOptions& options, EventRing::Handler handler);
+    void stopEventConsumer(int id) { events.stopConsumer(id); }
+    
+    // Marks positions and registers risk reference prices on owner instead of
+    // this connection, so a market data connection can feed the positions held
+    // by an order connection. Call before connect(); owner must outlive this.
+    void setPositionOwner(IBConnector* owner) { positionOwner = owner ? owner : this; }
 
 private:
-    std::unique_ptr<EClientSocket> client;
-    std::unique_ptr<EReaderOSSignal> signal;
-    std::unique_ptr<EReader> reader;
+    ConnectorSettings settings;
+    ConnectionRole role;
+    std::unique_ptr<CapturingClientSocket> client;
+    std::unique_ptr<EReaderOSSignal> signal;    // only used by eConnect for the handshake
+    std::unique_ptr<FrameQueue> frames;
+    std::unique_ptr<FrameReader> frameReader;
+    std::unique_ptr<CaptureWriter> capture;     // inbound frame recording, when enabled
     std::atomic<bool> connected;
     std::atomic<OrderId> nextOrderId;
     
     // Data storage
     mutable std::mutex dataMutex;
     std::vector<std::string> managedAccountsList;
+    SnapshotCell<std::string> defaultAccountCell;   // the only managed account, empty if none or several; read by placeOrder
     std::vector<AccountSummaryItem> accountSummaryData;
-    std::vector<PositionItem> positionsData;
-    std::vector<OrderInfo> openOrdersData;
+    OrderTable orders;
     
-    // Market data
-    std::map<int, double> tickPrices;
-    std::map<int, int> tickSizes;
+    // Published views of the data above; the dirty flags are set under dataMutex
+    SnapshotCell<std::vector<AccountSummaryItem>> accountSummaryCell;
+    SnapshotCell<std::vector<PositionItem>> positionsCell;
+    SnapshotCell<std::vector<OrderInfo>> openOrdersCell;
+    std::atomic<bool> accountSummaryDirty;
+    std::atomic<bool> positionsDirty;
+    std::atomic<bool> marksDirty;               // only marks and P&L changed; published at most every positionMarkPublishMs
+    std::atomic<int64_t> lastPositionsPublishNs;
+    std::atomic<bool> ordersDirty;
+    void publishSnapshots();
+    void publishSnapshotsLocked();
+    bool marksDue(int64_t nowNs) const;
+    
+    // Market data - written only by the message processing thread
+    std::shared_ptr<QuoteStore> quoteStorage;
+    QuoteStore& quotes;
+    bool quotesShared;                          // other connections write to the same store
+    OrderBookStore books;
+    std::vector<int> smartDepthIds;             // depth requests that must be cancelled as SMART depth
+    TickByTickStore prints;                     // tick-by-tick prints, rings allocated on request
+    std::unique_ptr<TickHistory> tickHistory;   // full tick history, when enabled
+    BarEngine bars;                             // OHLCV bars, published as Bar events
+    PositionBook positionBook;                  // guarded by dataMutex
+    PortfolioAnalytics portfolio;               // lanes are positionBook indices; guarded by dataMutex
+    // Held tickers whose price changed since they were last marked. Ticks only
+    // queue the ticker, lock-free; applyMarks() re-marks from the quote store.
+    std::unique_ptr<std::atomic<bool>[]> markQueued;
+    MpscQueue<long> markQueue;
+    IBConnector* positionOwner;                 // connection whose positions our ticks mark
+    std::unordered_map<int, std::string> accountPnlRequests;    // reqPnL id -> account
+    RiskGate riskGate;
+    ContractRegistry contracts;
+    std::atomic<int> nextRequestId;             // reqIds for one-shot requests, above any ticker id
+    RequestTracker requests;
+    int accountSummaryReqId;                    // live account summary subscription, 0 if none
+    
+    // Bar handlers of outstanding historical requests, by reqId
+    std::mutex historicalMutex;
+    std::unordered_map<int, HistoricalBarHandler> historicalHandlers;
+    void dropHistoricalHandler(int reqId);
+    
+    // Every request is sent by the scheduler's sender thread, paced and by priority
+    OutboundScheduler outbound;
+    void sendMarketData(int tickerId, const Contract& contract);
+    void sendMarketDepth(int tickerId, const Contract& contract, int numRows, bool smartDepth);
+    void sendRealTimeBars(int tickerId, const Contract& contract);
+    // reqRealTimeBars ids are the ticker id plus this, clear of ticker and one-shot ids
+    static constexpr int kRealTimeBarIdBase = 1 << 23;
+    // reqTickByTickData ids: one per ticker and type, below the real-time bar ids
+    static constexpr int kTickByTickIdBase = 1 << 22;
+    static constexpr int kTickByTickTypes = 4;
+    static int tickByTickReqId(int tickerId, TickByTickType type);
+    void sendTickByTick(int reqId, const Contract& contract, TickByTickType type);
+    void requestAccountPnl(int reqId, const std::string& account);
+    void requestPositionPnl(int reqId, const std::string& account, long conId);
+    
+    // Streaming subscriptions, replayed after a reconnect. The mutex is held while
+    // a subscription is registered and sent, so a replay never duplicates one.
+    std::mutex subscriptionMutex;
+    SubscriptionRegistry subscriptions;
+    void replaySubscriptions();
+    
+    // Session parameters of the last connect()
+    std::string sessionHost;
+    int sessionPort;
+    int sessionClientId;
+    bool openSession();
+    void closeSession();
+    
+    // Reconnection - the reconnect thread runs from the first connect() until disconnect()
+    std::thread reconnectThread;
+    mutable std::mutex reconnectMutex;
+    std::condition_variable reconnectCV;
+    bool connectionLost;                        // guarded by reconnectMutex
+    bool resubscribeRequested;                  // guarded by reconnectMutex
+    int64_t lostAtNs;                           // guarded by reconnectMutex
+    ReconnectStats reconnectTotals;             // guarded by reconnectMutex
+    std::atomic<bool> stopReconnect;
+    std::atomic<bool> reconnecting;
+    std::atomic<int64_t> firstTickPendingSinceNs;   // loss time until the first tick after a reconnect
+    std::mt19937 jitterRng;                     // reconnect thread only
+    void reconnectLoop();
+    void notifyConnectionLost();
+    bool reestablishSession(int64_t lostNs);
+    void resync(int64_t lostNs);
+    void recordFirstTick(int64_t pendingSinceNs);
+    
+    // Reconciliation after a reconnect - guarded by dataMutex
+    bool positionsResync;
+    bool ordersResync;
+    std::vector<OrderId> resyncSeenOrders;
+    int64_t resyncSinceNs;                      // wall clock when the connection was lost
+    // Orders missing from the open-order resync, status Unknown until the
+    // executions since the loss say whether they filled
+    std::vector<OrderId> unconfirmedOrders;
+    int executionsReqId;                        // 0 when no executions request is outstanding
+    std::unordered_map<OrderId, std::pair<double, double>> resyncFills;    // cumulative quantity, average price
+    void reconcileOrders();
+    void settleUnconfirmedOrders();
     
     // Threading
     std::thread messageProcessingThread;
     std::atomic<bool> shouldProcessMessages;
     void processMessages();
+    size_t drainFrames(EDecoder& decoder);
+    void updateStats(int64_t nowNs);
+    int64_t requestDeadline(int timeoutMs) const;
+    
+    // Instrumentation - written by the message processing thread only
+    StatsRecorder statsRecorder;
+    
+    // Callback fan-out - the message processing thread is the only producer
+    EventRing events;
+    ConnectorEvent* claimEvent(EventType type, int64_t timeNs);
+    static void logTickEvent(const ConnectorEvent& event);
+    void publishBar(const BarEvent& bar);
+    // Closes bars whose interval has ended
+    void closeBars();
     
     // Synchronization
     std::mutex connectionMutex;
@@ -130,5 +420,30 @@ private:
     
     // Helper methods
     void clearData();
-    void log(const std::string& message) const;
+    static OrderInfo toOrderInfo(const OrderRecord& record);
+    void releaseRisk(OrderRecord& record, double previousFilled, bool wasTerminal);
+    // What a working order already holds with the RiskGate, so a modify
+    // reserves only the difference
+    struct RiskHold {
+        bool modify = false;
+        double quantity = 0.0;
+        bool slot = false;
+        std::string account;
+    };
+    static RiskHold riskHold(const OrderRecord& record);
+    // Whether placeOrder may use orderId: new, or a working order to modify
+    OrderReject checkOrderId(OrderId orderId, const Contract& contract, const Order& order, RiskHold& hold) const;
+    // Ends an order that was recorded but could not be sent
+    void abandonOrder(OrderId orderId);
+    // Puts back a working order whose modify could not be sent
+    void revertModify(OrderId orderId, std::shared_ptr<OrderDetails> previous, const RiskHold& hold);
+    // Background lookup of a stock the registry does not know yet
+    void resolveOnFirstUse(const Contract& contract);
+    // Position and risk side of a subscription; called on positionOwner
+    void linkQuote(int tickerId, const Contract& contract);
+    void unlinkQuote(int tickerId);
+    void queueMark(TickerId tickerId);
+    // Under dataMutex
+    void applyMarks();
+    void applyGreeks(TickerId tickerId, double delta, double gamma, double vega, double theta, double underlyingPrice);
 };
\ No newline at end of file
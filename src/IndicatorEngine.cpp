@@ -0,0 +1,306 @@
+#include "IndicatorEngine.h"
+#include "PortfolioAnalytics.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FATTY_X86_KERNELS 1
+#endif
+
+// Raw column pointers handed to the kernels
+struct IndicatorLanes {
+    double* samples;
+    double* last;
+    double* emaFast;
+    double* emaSlow;
+    double* priceVolume;
+    double* volume;
+    double* base;
+    double* windowSum;
+    double* windowSumSq;
+    double* windowFilled;
+    int32_t* windowHead;
+    double* history;
+    int32_t capacity;
+    int32_t window;
+    double fastAlpha;
+    double slowAlpha;
+};
+
+namespace {
+using BatchKernel = void (*)(const IndicatorLanes&, const double*, const double*, size_t, size_t);
+
+void updateLane(const IndicatorLanes& s, size_t i, double x, double v) {
+    if (s.samples[i] == 0.0) {
+        s.emaFast[i] = x;
+        s.emaSlow[i] = x;
+        s.base[i] = x;
+    } else {
+        s.emaFast[i] += s.fastAlpha * (x - s.emaFast[i]);
+        s.emaSlow[i] += s.slowAlpha * (x - s.emaSlow[i]);
+    }
+    s.last[i] = x;
+    s.samples[i] += 1.0;
+    if (v > 0.0) {
+        s.priceVolume[i] += x * v;
+        s.volume[i] += v;
+    }
+
+    // Replace the oldest sample once the window is full
+    double d = x - s.base[i];
+    double* slot = s.history + static_cast<size_t>(s.windowHead[i]) * s.capacity + i;
+    if (s.windowFilled[i] == s.window) {
+        s.windowSum[i] -= *slot;
+        s.windowSumSq[i] -= *slot * *slot;
+    } else {
+        s.windowFilled[i] += 1.0;
+    }
+    *slot = d;
+    s.windowSum[i] += d;
+    s.windowSumSq[i] += d * d;
+    s.windowHead[i] = s.windowHead[i] + 1 == s.window ? 0 : s.windowHead[i] + 1;
+}
+
+void updateLanesScalar(const IndicatorLanes& s, const double* prices, const double* volumes, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        if (!std::isnan(prices[i])) {
+            updateLane(s, i, prices[i], volumes ? volumes[i] : 0.0);
+        }
+    }
+}
+
+#ifdef FATTY_X86_KERNELS
+__attribute__((target("avx2,fma")))
+void updateLanesAvx2(const IndicatorLanes& s, const double* prices, const double* volumes, size_t begin, size_t end) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d fastAlpha = _mm256_set1_pd(s.fastAlpha);
+    const __m256d slowAlpha = _mm256_set1_pd(s.slowAlpha);
+    const __m256d window = _mm256_set1_pd(s.window);
+    const __m128i capacity = _mm_set1_epi32(s.capacity);
+    const __m128i laneStep = _mm_setr_epi32(0, 1, 2, 3);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256d x = _mm256_loadu_pd(prices + i);
+        __m256d valid = _mm256_cmp_pd(x, x, _CMP_ORD_Q);
+        int validBits = _mm256_movemask_pd(valid);
+        if (validBits == 0) {
+            continue;
+        }
+
+        __m256d samples = _mm256_loadu_pd(s.samples + i);
+        __m256d first = _mm256_and_pd(_mm256_cmp_pd(samples, zero, _CMP_EQ_OQ), valid);
+        __m256d emaFast = _mm256_loadu_pd(s.emaFast + i);
+        __m256d emaSlow = _mm256_loadu_pd(s.emaSlow + i);
+        __m256d nextFast = _mm256_blendv_pd(_mm256_fmadd_pd(fastAlpha, _mm256_sub_pd(x, emaFast), emaFast), x, first);
+        __m256d nextSlow = _mm256_blendv_pd(_mm256_fmadd_pd(slowAlpha, _mm256_sub_pd(x, emaSlow), emaSlow), x, first);
+        _mm256_storeu_pd(s.emaFast + i, _mm256_blendv_pd(emaFast, nextFast, valid));
+        _mm256_storeu_pd(s.emaSlow + i, _mm256_blendv_pd(emaSlow, nextSlow, valid));
+        _mm256_storeu_pd(s.last + i, _mm256_blendv_pd(_mm256_loadu_pd(s.last + i), x, valid));
+        _mm256_storeu_pd(s.samples + i, _mm256_blendv_pd(samples, _mm256_add_pd(samples, one), valid));
+        __m256d base = _mm256_blendv_pd(_mm256_loadu_pd(s.base + i), x, first);
+        _mm256_storeu_pd(s.base + i, base);
+
+        if (volumes) {
+            __m256d v = _mm256_loadu_pd(volumes + i);
+            __m256d traded = _mm256_and_pd(_mm256_cmp_pd(v, zero, _CMP_GT_OQ), valid);
+            __m256d pv = _mm256_loadu_pd(s.priceVolume + i);
+            __m256d vol = _mm256_loadu_pd(s.volume + i);
+            _mm256_storeu_pd(s.priceVolume + i, _mm256_blendv_pd(pv, _mm256_fmadd_pd(x, v, pv), traded));
+            _mm256_storeu_pd(s.volume + i, _mm256_blendv_pd(vol, _mm256_add_pd(vol, v), traded));
+        }
+
+        // Rolling window: the lanes' ring positions differ, so gather the outgoing samples
+        __m256d d = _mm256_sub_pd(x, base);
+        __m128i heads = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s.windowHead + i));
+        __m128i slots = _mm_add_epi32(_mm_mullo_epi32(heads, capacity),
+                                      _mm_add_epi32(laneStep, _mm_set1_epi32(static_cast<int32_t>(i))));
+        __m256d filled = _mm256_loadu_pd(s.windowFilled + i);
+        __m256d full = _mm256_and_pd(_mm256_cmp_pd(filled, window, _CMP_EQ_OQ), valid);
+        __m256d outgoing = _mm256_mask_i32gather_pd(zero, s.history, slots, full, 8);
+        __m256d sum = _mm256_loadu_pd(s.windowSum + i);
+        __m256d sumSq = _mm256_loadu_pd(s.windowSumSq + i);
+        __m256d nextSum = _mm256_add_pd(_mm256_sub_pd(sum, outgoing), d);
+        __m256d nextSumSq = _mm256_fmadd_pd(d, d, _mm256_fnmadd_pd(outgoing, outgoing, sumSq));
+        _mm256_storeu_pd(s.windowSum + i, _mm256_blendv_pd(sum, nextSum, valid));
+        _mm256_storeu_pd(s.windowSumSq + i, _mm256_blendv_pd(sumSq, nextSumSq, valid));
+        __m256d nextFilled = _mm256_add_pd(filled, _mm256_andnot_pd(full, one));
+        _mm256_storeu_pd(s.windowFilled + i, _mm256_blendv_pd(filled, nextFilled, valid));
+
+        // No scatter in AVX2: store the new samples and advance the heads per lane
+        alignas(32) double incoming[4];
+        alignas(16) int32_t slot[4];
+        _mm256_store_pd(incoming, d);
+        _mm_store_si128(reinterpret_cast<__m128i*>(slot), slots);
+        for (int k = 0; k < 4; ++k) {
+            if (validBits & (1 << k)) {
+                s.history[slot[k]] = incoming[k];
+                int32_t& head = s.windowHead[i + k];
+                head = head + 1 == s.window ? 0 : head + 1;
+            }
+        }
+    }
+    updateLanesScalar(s, prices, volumes, i, end);
+}
+#endif
+
+double alphaFor(int period) {
+    return 2.0 / (std::max(period, 1) + 1.0);
+}
+}
+
+IndicatorEngine::IndicatorEngine(size_t capacity, const IndicatorSettings& settings)
+    : settings(settings)
+    , fastAlpha(alphaFor(settings.fastEmaPeriod))
+    , slowAlpha(alphaFor(settings.slowEmaPeriod))
+    , spreadAlpha(alphaFor(settings.spreadEmaPeriod))
+    , window(static_cast<size_t>(std::max(settings.window, 2)))
+    , useAvx2(PortfolioAnalytics::avx2Available())
+    , pendingEnd(0) {
+    samples.resize(capacity);
+    last.resize(capacity);
+    emaFast.resize(capacity);
+    emaSlow.resize(capacity);
+    priceVolume.resize(capacity);
+    volume.resize(capacity);
+    base.resize(capacity);
+    windowSum.resize(capacity);
+    windowSumSq.resize(capacity);
+    windowFilled.resize(capacity);
+    windowHead.resize(capacity);
+    history.resize(window * capacity);
+    bid.resize(capacity);
+    ask.resize(capacity);
+    spreadMean.resize(capacity);
+    spreadVar.resize(capacity);
+    spreadSamples.resize(capacity);
+    pendingPrice.assign(capacity, std::numeric_limits<double>::quiet_NaN());
+    pendingVolume.resize(capacity);
+}
+
+void IndicatorEngine::setVectorized(bool enabled) {
+    useAvx2 = enabled && PortfolioAnalytics::avx2Available();
+}
+
+IndicatorLanes IndicatorEngine::laneState() {
+    return {samples.data(), last.data(), emaFast.data(), emaSlow.data(), priceVolume.data(), volume.data(),
+            base.data(), windowSum.data(), windowSumSq.data(), windowFilled.data(), windowHead.data(),
+            history.data(), static_cast<int32_t>(capacity()), static_cast<int32_t>(window), fastAlpha, slowAlpha};
+}
+
+void IndicatorEngine::update(size_t lane, double price, double tradedVolume) {
+    if (lane < capacity() && !std::isnan(price)) {
+        updateLane(laneState(), lane, price, tradedVolume);
+    }
+}
+
+void IndicatorEngine::updateBatch(const double* prices, const double* volumes, size_t count) {
+    count = std::min(count, capacity());
+    IndicatorLanes state = laneState();
+    BatchKernel kernel = updateLanesScalar;
+#ifdef FATTY_X86_KERNELS
+    if (useAvx2) {
+        kernel = updateLanesAvx2;
+    }
+#endif
+    kernel(state, prices, volumes, 0, count);
+}
+
+void IndicatorEngine::updateQuote(size_t lane, double bidPrice, double askPrice) {
+    if (lane >= capacity() || !(bidPrice > 0.0) || !(askPrice >= bidPrice)) {
+        return;
+    }
+    double spread = askPrice - bidPrice;
+    if (spreadSamples[lane]++ == 0) {
+        spreadMean[lane] = spread;
+        spreadVar[lane] = 0.0;
+        return;
+    }
+    // Exponentially weighted mean and variance in one pass
+    double diff = spread - spreadMean[lane];
+    double step = spreadAlpha * diff;
+    spreadMean[lane] += step;
+    spreadVar[lane] = (1.0 - spreadAlpha) * (spreadVar[lane] + diff * step);
+}
+
+void IndicatorEngine::onEvent(const ConnectorEvent& event, bool endOfBatch) {
+    if (event.type == EventType::Bar && event.bar.intervalSeconds == settings.barSeconds &&
+        inRange(event.bar.tickerId)) {
+        size_t lane = static_cast<size_t>(event.bar.tickerId);
+        if (!std::isnan(pendingPrice[lane])) {
+            flushBars();    // the lane's next bar already
+        }
+        pendingPrice[lane] = event.bar.close;
+        pendingVolume[lane] = event.bar.volume;
+        pendingEnd = std::max(pendingEnd, lane + 1);
+    } else if (event.type == EventType::TickPrice && inRange(event.tick.tickerId)) {
+        size_t lane = static_cast<size_t>(event.tick.tickerId);
+        switch (event.tick.field) {
+            case 1: case 66: bid[lane] = event.tick.value; break;
+            case 2: case 67: ask[lane] = event.tick.value; break;
+            default: break;
+        }
+        if (event.tick.field == 1 || event.tick.field == 2 || event.tick.field == 66 || event.tick.field == 67) {
+            updateQuote(lane, bid[lane], ask[lane]);
+        }
+    }
+    if (endOfBatch) {
+        flushBars();
+    }
+}
+
+void IndicatorEngine::flushBars() {
+    if (pendingEnd == 0) {
+        return;
+    }
+    updateBatch(pendingPrice.data(), pendingVolume.data(), pendingEnd);
+    std::fill(pendingPrice.begin(), pendingPrice.begin() + pendingEnd, std::numeric_limits<double>::quiet_NaN());
+    pendingEnd = 0;
+}
+
+IndicatorValues IndicatorEngine::values(size_t lane) const {
+    IndicatorValues out;
+    if (lane >= capacity() || samples[lane] == 0.0) {
+        return out;
+    }
+    out.samples = static_cast<uint64_t>(samples[lane]);
+    out.last = last[lane];
+    out.emaFast = emaFast[lane];
+    out.emaSlow = emaSlow[lane];
+    out.vwap = volume[lane] > 0.0 ? priceVolume[lane] / volume[lane] : last[lane];
+
+    double n = windowFilled[lane];
+    double meanOffset = windowSum[lane] / n;
+    out.mean = base[lane] + meanOffset;
+    if (n > 1.0) {
+        double variance = (windowSumSq[lane] - windowSum[lane] * meanOffset) / (n - 1.0);
+        out.stddev = variance > 0.0 ? std::sqrt(variance) : 0.0;
+    }
+    out.zscore = out.stddev > 0.0 ? (out.last - out.mean) / out.stddev : 0.0;
+
+    if (spreadSamples[lane] > 0) {
+        out.spreadMean = spreadMean[lane];
+        out.spreadStddev = std::sqrt(spreadVar[lane]);
+    }
+    return out;
+}
+
+void IndicatorEngine::resetVwap() {
+    std::fill(priceVolume.begin(), priceVolume.end(), 0.0);
+    std::fill(volume.begin(), volume.end(), 0.0);
+}
+
+void IndicatorEngine::clear() {
+    for (std::vector<double>* column : {&samples, &last, &emaFast, &emaSlow, &priceVolume, &volume, &base,
+                                        &windowSum, &windowSumSq, &windowFilled, &history, &bid, &ask,
+                                        &spreadMean, &spreadVar}) {
+        std::fill(column->begin(), column->end(), 0.0);
+    }
+    std::fill(windowHead.begin(), windowHead.end(), 0);
+    std::fill(spreadSamples.begin(), spreadSamples.end(), 0u);
+    std::fill(pendingPrice.begin(), pendingPrice.end(), std::numeric_limits<double>::quiet_NaN());
+    pendingEnd = 0;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "EventRing.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct IndicatorLanes;
+
+struct IndicatorSettings {
+    int fastEmaPeriod = 12;
+    int slowEmaPeriod = 26;
+    int window = 20;                    // samples in the rolling mean, standard deviation and z-score
+    int spreadEmaPeriod = 100;          // quote updates in the spread mean and deviation
+    int barSeconds = 60;                // onEvent(): bars of this interval drive the price indicators
+};
+
+// One lane's indicators, derived when read.
+struct IndicatorValues {
+    uint64_t samples = 0;
+    double last = 0.0;
+    double emaFast = 0.0;
+    double emaSlow = 0.0;
+    double vwap = 0.0;                  // since the last resetVwap(); last when there was no volume
+    double mean = 0.0;                  // rolling, over the last window samples
+    double stddev = 0.0;
+    double zscore = 0.0;                // (last - mean) / stddev, 0 while stddev is 0
+    double spreadMean = 0.0;            // exponentially weighted ask - bid
+    double spreadStddev = 0.0;
+};
+
+// Streaming indicators for every symbol, kept as parallel arrays indexed by
+// ticker id.
+//
+// Prices (trades or bar closes) update two EMAs, a running VWAP and a rolling
+// window of the last samples with its sum and sum of squares, so every
+// indicator costs O(1) per update. Window samples are stored relative to the
+// lane's first price to keep the rolling variance accurate. update() handles
+// one lane; updateBatch() updates every lane that has a value in one pass,
+// with AVX2 kernels chosen at runtime (scalar elsewhere), for bars that close
+// at the same boundary. Quotes feed exponentially weighted spread statistics.
+// Not thread-safe; run it on one event consumer (see onEvent()).
+class IndicatorEngine {
+public:
+    IndicatorEngine(size_t capacity, const IndicatorSettings& settings = IndicatorSettings());
+
+    size_t capacity() const { return last.size(); }
+    bool inRange(long lane) const { return lane >= 0 && static_cast<size_t>(lane) < last.size(); }
+    bool vectorized() const { return useAvx2; }
+
+    void update(size_t lane, double price, double tradedVolume);
+    // prices[i] and volumes[i] for lanes 0..count-1; lanes whose price is NaN are left alone.
+    void updateBatch(const double* prices, const double* volumes, size_t count);
+    void updateQuote(size_t lane, double bid, double ask);
+
+    // Feeds bars of settings.barSeconds and bid/ask ticks from the connector's
+    // event stream. Bars are staged and updated in one batch at the end of each
+    // batch of events.
+    void onEvent(const ConnectorEvent& event, bool endOfBatch);
+    void flushBars();
+
+    IndicatorValues values(size_t lane) const;
+    // Starts a new VWAP on every lane, e.g. at the session open.
+    void resetVwap();
+    void clear();
+
+    // Forces the scalar kernels, for comparison.
+    void setVectorized(bool enabled);
+
+private:
+    IndicatorSettings settings;
+    double fastAlpha;
+    double slowAlpha;
+    double spreadAlpha;
+    size_t window;
+    bool useAvx2;
+
+    // Per lane
+    std::vector<double> samples;        // as double, for the vector kernels
+    std::vector<double> last;
+    std::vector<double> emaFast;
+    std::vector<double> emaSlow;
+    std::vector<double> priceVolume;
+    std::vector<double> volume;
+    std::vector<double> base;           // first price; window samples are stored relative to it
+    std::vector<double> windowSum;
+    std::vector<double> windowSumSq;
+    std::vector<double> windowFilled;
+    std::vector<int32_t> windowHead;
+    std::vector<double> history;        // window * capacity, slot-major: history[slot * capacity + lane]
+    std::vector<double> bid;
+    std::vector<double> ask;
+    std::vector<double> spreadMean;
+    std::vector<double> spreadVar;
+    std::vector<uint32_t> spreadSamples;
+
+    // Bars staged by onEvent(), NaN where a lane has none
+    std::vector<double> pendingPrice;
+    std::vector<double> pendingVolume;
+    size_t pendingEnd;
+
+    IndicatorLanes laneState();
+};
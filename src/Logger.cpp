@@ -0,0 +1,144 @@
+#include "Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+
+namespace {
+void appendArg(std::string& out, const LogRecord& record, int i) {
+    char buf[32];
+    switch (record.argTypes[i]) {
+    case LogRecord::Int:
+        out.append(buf, std::snprintf(buf, sizeof(buf), "%lld",
+                                      static_cast<long long>(static_cast<int64_t>(record.args[i]))));
+        break;
+    case LogRecord::UInt:
+        out.append(buf, std::snprintf(buf, sizeof(buf), "%llu",
+                                      static_cast<unsigned long long>(record.args[i])));
+        break;
+    case LogRecord::Double: {
+        double d;
+        std::memcpy(&d, &record.args[i], sizeof(d));
+        out.append(buf, std::snprintf(buf, sizeof(buf), "%.10g", d));
+        break;
+    }
+    case LogRecord::Bool:
+        out += record.args[i] ? "true" : "false";
+        break;
+    case LogRecord::Text:
+        out.append(record.text + (record.args[i] >> 16), record.args[i] & 0xFFFF);
+        break;
+    }
+}
+
+void appendMessage(std::string& out, const LogRecord& record) {
+    int arg = 0;
+    for (const char* p = record.format; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}' && arg < record.argCount) {
+            appendArg(out, record, arg++);
+            ++p;
+        } else {
+            out += *p;
+        }
+    }
+}
+
+const char* levelTag(LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug: return "DEBUG ";
+    case LogLevel::Warn: return "WARN ";
+    case LogLevel::Error: return "ERROR ";
+    default: return "";
+    }
+}
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger(size_t capacity, std::ostream* sink)
+    : queue(capacity)
+    , sink(sink ? sink : &std::cout)
+    , runtimeLevel(LogLevel::Info)
+    , dropped(0)
+    , passes(0)
+    , running(true)
+    , cachedSecond(-1) {
+    cachedPrefix[0] = '\0';
+    worker = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void Logger::flush() {
+    while (queue.sizeApprox() != 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Wait for two full worker passes so the batch it may be holding reaches the sink
+    uint64_t target = passes.load(std::memory_order_acquire) + 2;
+    while (running.load(std::memory_order_relaxed) && passes.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+std::string Logger::formatRecord(const LogRecord& record) {
+    std::string out;
+    appendMessage(out, record);
+    return out;
+}
+
+void Logger::appendPrefix(std::string& buffer, int64_t timestampNs) {
+    int64_t second = timestampNs / 1000000000;
+    if (second != cachedSecond) {
+        std::time_t t = static_cast<std::time_t>(second);
+        std::tm tm;
+        localtime_r(&t, &tm);
+        std::strftime(cachedPrefix, sizeof(cachedPrefix), "[%H:%M:%S] ", &tm);
+        cachedSecond = second;
+    }
+    buffer += cachedPrefix;
+}
+
+size_t Logger::drainOnce(std::string& buffer) {
+    return queue.drain([&](const LogRecord& record) {
+        appendPrefix(buffer, record.timestampNs);
+        buffer += levelTag(record.level);
+        appendMessage(buffer, record);
+        buffer += '\n';
+    }, 1024);
+}
+
+void Logger::run() {
+    std::string buffer;
+    buffer.reserve(64 * 1024);
+    uint64_t reportedDropped = 0;
+
+    while (running.load(std::memory_order_relaxed) || queue.sizeApprox() != 0) {
+        size_t count = drainOnce(buffer);
+
+        uint64_t droppedNow = dropped.load(std::memory_order_relaxed);
+        if (droppedNow != reportedDropped) {
+            appendPrefix(buffer, wallClockNanos());
+            buffer += "WARN Logger dropped " + std::to_string(droppedNow - reportedDropped) + " records (ring full)\n";
+            reportedDropped = droppedNow;
+        }
+
+        if (!buffer.empty()) {
+            sink->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            sink->flush();
+            buffer.clear();
+        }
+        passes.fetch_add(1, std::memory_order_release);
+
+        if (count == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
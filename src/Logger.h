@@ -0,0 +1,170 @@
+#pragma once
+
+#include "MpscQueue.h"
+#include "Clock.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info = 1,
+    Warn = 2,
+    Error = 3,
+    Off = 4
+};
+
+// Records below this level are compiled out entirely (arguments are not evaluated).
+// Override with -DFATTY_LOG_MIN_LEVEL=2 to keep only warnings and errors.
+#ifndef FATTY_LOG_MIN_LEVEL
+#define FATTY_LOG_MIN_LEVEL 0
+#endif
+
+// Compact binary log record. The format string is a literal with "{}" placeholders
+// and is stored by pointer; arguments are stored raw and only formatted by the
+// background thread.
+struct LogRecord {
+    static constexpr int kMaxArgs = 8;
+    static constexpr int kTextBytes = 160;
+
+    enum ArgType : uint8_t { Int, UInt, Double, Bool, Text };
+
+    const char* format;
+    int64_t timestampNs;
+    LogLevel level;
+    uint8_t argCount;
+    uint16_t textUsed;
+    ArgType argTypes[kMaxArgs];
+    uint64_t args[kMaxArgs];    // Text args hold (offset << 16 | length) into text
+    char text[kTextBytes];
+};
+
+// Asynchronous logger shared by every connector in the process.
+//
+// Callers pack a LogRecord straight into a lock-free ring; a background thread
+// formats and writes the records in batches. When the ring is full the record is
+// dropped and counted instead of blocking the caller.
+class Logger {
+public:
+    static Logger& instance();
+
+    explicit Logger(size_t capacity = 16384, std::ostream* sink = nullptr);
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    void setLevel(LogLevel level) { runtimeLevel.store(level, std::memory_order_relaxed); }
+    LogLevel level() const { return runtimeLevel.load(std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const { return level >= runtimeLevel.load(std::memory_order_relaxed); }
+
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+    template <size_t N, typename... Args>
+    void write(LogLevel level, const char (&format)[N], const Args&... args) {
+        static_assert(sizeof...(Args) <= LogRecord::kMaxArgs, "too many log arguments");
+        if (!enabled(level)) {
+            return;
+        }
+
+        int64_t timestampNs = wallClockNanos();
+
+        bool queued = queue.tryPush([&](LogRecord& record) {
+            record.format = format;
+            record.timestampNs = timestampNs;
+            record.level = level;
+            record.argCount = 0;
+            record.textUsed = 0;
+            (encode(record, args), ...);
+        });
+
+        if (!queued) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Blocks until everything queued so far has been written.
+    void flush();
+
+    static std::string formatRecord(const LogRecord& record);
+
+private:
+    MpscQueue<LogRecord> queue;
+    std::ostream* sink;
+    std::atomic<LogLevel> runtimeLevel;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> passes;
+    std::atomic<bool> running;
+    std::thread worker;
+
+    // Timestamp prefix cache, touched only by the worker thread
+    int64_t cachedSecond;
+    char cachedPrefix[16];
+
+    void run();
+    size_t drainOnce(std::string& buffer);
+    void appendPrefix(std::string& buffer, int64_t timestampNs);
+
+    template <typename T>
+    static void encode(LogRecord& record, const T& value) {
+        uint8_t i = record.argCount++;
+        if constexpr (std::is_same<T, bool>::value) {
+            record.argTypes[i] = LogRecord::Bool;
+            record.args[i] = value ? 1 : 0;
+        } else if constexpr (std::is_floating_point<T>::value) {
+            double d = static_cast<double>(value);
+            record.argTypes[i] = LogRecord::Double;
+            std::memcpy(&record.args[i], &d, sizeof(d));
+        } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+            record.argTypes[i] = LogRecord::Int;
+            record.args[i] = static_cast<uint64_t>(static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+            record.argTypes[i] = LogRecord::UInt;
+            record.args[i] = static_cast<uint64_t>(value);
+        } else if constexpr (std::is_same<T, std::string>::value) {
+            encodeText(record, i, value.data(), value.size());
+        } else {
+            const char* str = value;
+            encodeText(record, i, str, std::strlen(str));
+        }
+    }
+
+    static void encodeText(LogRecord& record, uint8_t i, const char* data, size_t length) {
+        size_t room = LogRecord::kTextBytes - record.textUsed;
+        if (length > room) {
+            length = room;
+        }
+        std::memcpy(record.text + record.textUsed, data, length);
+        record.argTypes[i] = LogRecord::Text;
+        record.args[i] = (static_cast<uint64_t>(record.textUsed) << 16) | length;
+        record.textUsed += static_cast<uint16_t>(length);
+    }
+};
+
+// Level 0 keeps everything; spelled out so the comparison isn't flagged as
+// always true (-Wtype-limits) in default builds.
+#if FATTY_LOG_MIN_LEVEL > 0
+constexpr bool logCompiledIn(LogLevel level) {
+    return static_cast<int>(level) >= FATTY_LOG_MIN_LEVEL;
+}
+#else
+constexpr bool logCompiledIn(LogLevel) {
+    return true;
+}
+#endif
+
+#define FATTY_LOG(lvl, ...)                                                        \
+    do {                                                                           \
+        if constexpr (logCompiledIn(lvl)) {                                        \
+            Logger::instance().write(lvl, __VA_ARGS__);                            \
+        }                                                                          \
+    } while (0)
+
+#define LOG_DEBUG(...) FATTY_LOG(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) FATTY_LOG(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...) FATTY_LOG(LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) FATTY_LOG(LogLevel::Error, __VA_ARGS__)
@@ -0,0 +1,134 @@
+#include "MappedFile.h"
+#include "Logger.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile()
+    : fd(-1)
+    , base(nullptr)
+    , mappedBytes(0)
+    , writable(false) {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::openWrite(const std::string& path, size_t minBytes, bool truncate) {
+    close();
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+    if (fd < 0) {
+        LOG_ERROR("Could not open {} for writing: {}", path, std::strerror(errno));
+        return false;
+    }
+    filePath = path;
+    writable = true;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        LOG_ERROR("Could not stat {}: {}", path, std::strerror(errno));
+        close();
+        return false;
+    }
+
+    size_t bytes = static_cast<size_t>(st.st_size);
+    if (bytes < minBytes) {
+        if (ftruncate(fd, static_cast<off_t>(minBytes)) != 0) {
+            LOG_ERROR("Could not size {}: {}", path, std::strerror(errno));
+            close();
+            return false;
+        }
+        bytes = minBytes;
+    }
+
+    if (!map(bytes)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::openRead(const std::string& path) {
+    close();
+
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("Could not open {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    filePath = path;
+    writable = false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        LOG_ERROR("{} is empty or unreadable", path);
+        close();
+        return false;
+    }
+
+    if (!map(static_cast<size_t>(st.st_size))) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::map(size_t bytes) {
+    void* mapping = mmap(nullptr, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                         writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR("Could not map {}: {}", filePath, std::strerror(errno));
+        return false;
+    }
+    if (base) {
+        munmap(base, mappedBytes);
+    }
+    base = static_cast<char*>(mapping);
+    mappedBytes = bytes;
+    return true;
+}
+
+bool MappedFile::resize(size_t bytes) {
+    if (!writable || fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        LOG_ERROR("Could not resize {}: {}", filePath, std::strerror(errno));
+        return false;
+    }
+    return map(bytes);
+}
+
+void MappedFile::close(size_t finalBytes) {
+    if (base) {
+        munmap(base, mappedBytes);
+        base = nullptr;
+        mappedBytes = 0;
+    }
+    if (fd >= 0) {
+        if (writable && finalBytes != static_cast<size_t>(-1) && ftruncate(fd, static_cast<off_t>(finalBytes)) != 0) {
+            LOG_WARN("Could not trim {}: {}", filePath, std::strerror(errno));
+        }
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool makeDirectories(const std::string& path) {
+    for (size_t pos = 1; pos <= path.size(); ++pos) {
+        if (pos != path.size() && path[pos] != '/') {
+            continue;
+        }
+        std::string prefix = path.substr(0, pos);
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+            LOG_ERROR("Could not create directory {}: {}", prefix, std::strerror(errno));
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A file mapped into memory, either read-only or as a growable shared
+// read-write mapping. Used by the capture and history stores, which append
+// by writing into the mapping and growing the file in large steps.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Opens (creating if needed) for writing and maps at least minBytes.
+    // Existing contents are kept unless truncate is set.
+    bool openWrite(const std::string& path, size_t minBytes, bool truncate = false);
+    // Maps the whole file read-only.
+    bool openRead(const std::string& path);
+    // Writable mappings only: grows or shrinks the file and remaps it.
+    // Pointers into the old mapping are invalidated.
+    bool resize(size_t bytes);
+    // Unmaps; a writable file is first trimmed to finalBytes when given.
+    void close(size_t finalBytes = static_cast<size_t>(-1));
+
+    bool isOpen() const { return base != nullptr; }
+    char* data() { return base; }
+    const char* data() const { return base; }
+    size_t size() const { return mappedBytes; }
+    const std::string& path() const { return filePath; }
+
+private:
+    std::string filePath;
+    int fd;
+    char* base;
+    size_t mappedBytes;
+    bool writable;
+
+    bool map(size_t bytes);
+};
+
+// Creates a directory and any missing parents. Returns false (and logs) on failure.
+bool makeDirectories(const std::string& path);
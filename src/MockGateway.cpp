@@ -0,0 +1,570 @@
+#include "MockGateway.h"
+#include "Clock.h"
+#include "Logger.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+// Client -> server message ids
+enum IncomingMsg {
+    REQ_MKT_DATA = 1,
+    CANCEL_MKT_DATA = 2,
+    PLACE_ORDER = 3,
+    CANCEL_ORDER = 4,
+    REQ_OPEN_ORDERS = 5,
+    REQ_IDS = 8,
+    REQ_ALL_OPEN_ORDERS = 16,
+    REQ_MANAGED_ACCTS = 17,
+    REQ_POSITIONS = 61,
+    REQ_ACCOUNT_SUMMARY = 62,
+    START_API = 71
+};
+
+// Server -> client message ids
+enum OutgoingMsg {
+    TICK_PRICE = 1,
+    TICK_SIZE = 2,
+    ORDER_STATUS = 3,
+    NEXT_VALID_ID = 9,
+    MANAGED_ACCTS = 15,
+    OPEN_ORDER_END = 53,
+    POSITION_END = 62,
+    ACCOUNT_SUMMARY = 63,
+    ACCOUNT_SUMMARY_END = 64
+};
+
+// Server versions that change the layout of messages we encode or parse
+const int MIN_SERVER_VER_MARKET_CAP_PRICE = 131;
+const int MIN_SERVER_VER_ORDER_CONTAINER = 145;
+
+// Tick types
+const int TICK_BID = 1;
+const int TICK_ASK = 2;
+const int TICK_LAST = 4;
+const int TICK_VOLUME = 8;
+
+const int kPollTimeoutMs = 1;
+
+// Appends one length-prefixed frame of NUL-terminated fields to a session buffer.
+class FrameWriter {
+public:
+    explicit FrameWriter(std::string& out) : out(out), start(out.size()) {
+        out.append(4, '\0');
+    }
+
+    FrameWriter& add(const std::string& value) {
+        out += value;
+        out += '\0';
+        return *this;
+    }
+
+    FrameWriter& add(long value) {
+        char buf[24];
+        out.append(buf, std::snprintf(buf, sizeof(buf), "%ld", value));
+        out += '\0';
+        return *this;
+    }
+
+    FrameWriter& add(int value) { return add(static_cast<long>(value)); }
+
+    FrameWriter& add(double value) {
+        char buf[32];
+        out.append(buf, std::snprintf(buf, sizeof(buf), "%.10g", value));
+        out += '\0';
+        return *this;
+    }
+
+    void finish() {
+        uint32_t length = static_cast<uint32_t>(out.size() - start - 4);
+        out[start] = static_cast<char>(length >> 24);
+        out[start + 1] = static_cast<char>(length >> 16);
+        out[start + 2] = static_cast<char>(length >> 8);
+        out[start + 3] = static_cast<char>(length);
+    }
+
+private:
+    std::string& out;
+    size_t start;
+};
+
+uint32_t readBigEndian32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return (static_cast<uint32_t>(u[0]) << 24) | (static_cast<uint32_t>(u[1]) << 16) |
+           (static_cast<uint32_t>(u[2]) << 8) | static_cast<uint32_t>(u[3]);
+}
+
+std::vector<std::string> splitFields(const char* data, size_t length) {
+    std::vector<std::string> fields;
+    size_t begin = 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (data[i] == '\0') {
+            fields.emplace_back(data + begin, i - begin);
+            begin = i + 1;
+        }
+    }
+    return fields;
+}
+
+long fieldLong(const std::vector<std::string>& fields, size_t index, long fallback = 0) {
+    return index < fields.size() ? std::strtol(fields[index].c_str(), nullptr, 10) : fallback;
+}
+
+double fieldDouble(const std::vector<std::string>& fields, size_t index, double fallback = 0.0) {
+    return index < fields.size() && !fields[index].empty() ? std::strtod(fields[index].c_str(), nullptr) : fallback;
+}
+
+void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+}
+
+struct MockGateway::Session {
+    struct Ticker {
+        long id;
+        double price;
+    };
+
+    struct PendingFill {
+        int64_t dueNs;
+        long orderId;
+        double quantity;
+        double price;
+    };
+
+    int fd = -1;
+    bool handshakeDone = false;
+    int serverVersion = 0;
+    int clientId = 0;
+    long nextOrderId = 0;
+    std::string in;
+    std::string out;
+
+    std::vector<Ticker> tickers;
+    size_t nextTicker = 0;
+    uint64_t tickCounter = 0;
+    double tickCredit = 0.0;
+    int64_t lastTickNs = 0;
+    uint64_t rng = 0x9E3779B97F4A7C15ull;
+
+    std::deque<PendingFill> pendingFills;
+
+    uint64_t random() {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        return rng;
+    }
+
+    void sendOrderStatus(long orderId, const char* status, double filled, double remaining,
+                         double avgFillPrice, double lastFillPrice) {
+        FrameWriter w(out);
+        w.add(ORDER_STATUS);
+        if (serverVersion < MIN_SERVER_VER_MARKET_CAP_PRICE) {
+            w.add(6);
+        }
+        w.add(orderId).add(std::string(status)).add(filled).add(remaining).add(avgFillPrice)
+         .add(orderId + 1000000).add(0).add(lastFillPrice).add(clientId).add(std::string());
+        if (serverVersion >= MIN_SERVER_VER_MARKET_CAP_PRICE) {
+            w.add(0.0);
+        }
+        w.finish();
+    }
+};
+
+MockGateway::MockGateway(const MockGatewayConfig& config)
+    : config(config)
+    , listenFd(-1)
+    , running(false)
+    , ticks(0)
+    , throttled(0)
+    , orders(0)
+    , sessions(0)
+    , dropRequested(false) {
+}
+
+MockGateway::~MockGateway() {
+    stop();
+}
+
+int MockGateway::start() {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        LOG_ERROR("Mock gateway socket failed: {}", std::strerror(errno));
+        return -1;
+    }
+
+    int yes = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(config.port));
+
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd, 16) != 0) {
+        LOG_ERROR("Mock gateway could not listen on port {}: {}", config.port, std::strerror(errno));
+        close(listenFd);
+        listenFd = -1;
+        return -1;
+    }
+    setNonBlocking(listenFd);
+
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &len);
+    int port = ntohs(addr.sin_port);
+
+    running = true;
+    thread = std::thread(&MockGateway::run, this);
+    LOG_INFO("Mock gateway listening on 127.0.0.1:{} ({} ticks/s per session)", port, config.ticksPerSecond);
+    return port;
+}
+
+void MockGateway::stop() {
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+    for (auto& session : clients) {
+        close(session->fd);
+    }
+    clients.clear();
+    sessions = 0;
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+    }
+}
+
+void MockGateway::run() {
+    std::vector<pollfd> pollfds;
+
+    while (running.load(std::memory_order_relaxed)) {
+        pollfds.clear();
+        pollfds.push_back({listenFd, POLLIN, 0});
+        for (auto& session : clients) {
+            short events = POLLIN;
+            if (!session->out.empty()) {
+                events |= POLLOUT;
+            }
+            pollfds.push_back({session->fd, events, 0});
+        }
+
+        if (poll(pollfds.data(), pollfds.size(), kPollTimeoutMs) < 0 && errno != EINTR) {
+            LOG_ERROR("Mock gateway poll failed: {}", std::strerror(errno));
+            break;
+        }
+
+        if (pollfds[0].revents & POLLIN) {
+            acceptClients();
+        }
+
+        int64_t nowNs = monotonicNanos();
+        bool dropAll = dropRequested.exchange(false, std::memory_order_relaxed);
+        for (size_t i = 0; i < clients.size(); ++i) {
+            Session& session = *clients[i];
+            bool alive = !dropAll;
+            // Sessions accepted during this pass have no pollfd entry yet
+            if (alive && i + 1 < pollfds.size() && (pollfds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) {
+                alive = readClient(session);
+            }
+            if (alive && session.handshakeDone) {
+                sendFills(session, nowNs);
+                generateTicks(session, nowNs);
+            }
+            if (alive) {
+                alive = flush(session);
+            }
+            if (!alive) {
+                close(session.fd);
+                session.fd = -1;
+            }
+        }
+
+        size_t before = clients.size();
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                     [](const std::unique_ptr<Session>& s) { return s->fd < 0; }),
+                      clients.end());
+        if (clients.size() != before) {
+            sessions = static_cast<int>(clients.size());
+            LOG_INFO("Mock gateway: client disconnected ({} sessions)", clients.size());
+        }
+    }
+}
+
+void MockGateway::acceptClients() {
+    for (;;) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        setNonBlocking(fd);
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+        auto session = std::make_unique<Session>();
+        session->fd = fd;
+        session->nextOrderId = config.firstOrderId;
+        session->rng ^= static_cast<uint64_t>(fd) * 0x100000001B3ull;
+        clients.push_back(std::move(session));
+        sessions = static_cast<int>(clients.size());
+        LOG_INFO("Mock gateway: client connected ({} sessions)", clients.size());
+    }
+}
+
+bool MockGateway::readClient(Session& session) {
+    char buf[64 * 1024];
+    for (;;) {
+        ssize_t n = recv(session.fd, buf, sizeof(buf), 0);
+        if (n == 0) {
+            return false;
+        }
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                break;
+            }
+            return false;
+        }
+        session.in.append(buf, static_cast<size_t>(n));
+    }
+
+    if (!session.handshakeDone && !handleHandshake(session)) {
+        return true;    // need more bytes
+    }
+
+    size_t offset = 0;
+    while (session.in.size() - offset >= 4) {
+        uint32_t length = readBigEndian32(session.in.data() + offset);
+        if (session.in.size() - offset - 4 < length) {
+            break;
+        }
+        handleMessage(session, splitFields(session.in.data() + offset + 4, length));
+        offset += 4 + length;
+    }
+    session.in.erase(0, offset);
+    return true;
+}
+
+bool MockGateway::handleHandshake(Session& session) {
+    // "API\0" followed by a framed "v<min>..<max>[ options]" version range
+    if (session.in.size() < 8 || session.in.compare(0, 4, std::string("API\0", 4)) != 0) {
+        return false;
+    }
+    uint32_t length = readBigEndian32(session.in.data() + 4);
+    if (session.in.size() < 8 + length) {
+        return false;
+    }
+
+    std::string range(session.in.data() + 8, length);
+    session.in.erase(0, 8 + length);
+
+    int clientMax = 0;
+    size_t dots = range.find("..");
+    if (dots != std::string::npos) {
+        clientMax = std::atoi(range.c_str() + dots + 2);
+    } else if (!range.empty() && range[0] == 'v') {
+        clientMax = std::atoi(range.c_str() + 1);
+    }
+    session.serverVersion = clientMax < config.maxServerVersion ? clientMax : config.maxServerVersion;
+
+    char timeText[32];
+    std::time_t now = std::time(nullptr);
+    std::tm tm;
+    gmtime_r(&now, &tm);
+    std::strftime(timeText, sizeof(timeText), "%Y%m%d %H:%M:%S UTC", &tm);
+
+    FrameWriter w(session.out);
+    w.add(session.serverVersion).add(std::string(timeText));
+    w.finish();
+
+    session.handshakeDone = true;
+    LOG_INFO("Mock gateway: handshake complete, server version {}", session.serverVersion);
+    return true;
+}
+
+void MockGateway::handleMessage(Session& session, const std::vector<std::string>& fields) {
+    if (fields.empty()) {
+        return;
+    }
+
+    switch (fieldLong(fields, 0)) {
+    case START_API: {
+        session.clientId = static_cast<int>(fieldLong(fields, 2));
+        FrameWriter(session.out).add(NEXT_VALID_ID).add(1).add(session.nextOrderId).finish();
+        FrameWriter(session.out).add(MANAGED_ACCTS).add(1).add(config.accounts).finish();
+        break;
+    }
+    case REQ_IDS:
+        FrameWriter(session.out).add(NEXT_VALID_ID).add(1).add(session.nextOrderId).finish();
+        break;
+    case REQ_MANAGED_ACCTS:
+        FrameWriter(session.out).add(MANAGED_ACCTS).add(1).add(config.accounts).finish();
+        break;
+    case REQ_MKT_DATA: {
+        long tickerId = fieldLong(fields, 2);
+        for (const auto& ticker : session.tickers) {
+            if (ticker.id == tickerId) {
+                return;
+            }
+        }
+        session.tickers.push_back({tickerId, 100.0 + static_cast<double>(tickerId % 400)});
+        break;
+    }
+    case CANCEL_MKT_DATA: {
+        long tickerId = fieldLong(fields, 2);
+        for (size_t i = 0; i < session.tickers.size(); ++i) {
+            if (session.tickers[i].id == tickerId) {
+                session.tickers.erase(session.tickers.begin() + static_cast<long>(i));
+                break;
+            }
+        }
+        break;
+    }
+    case PLACE_ORDER: {
+        // The version field was dropped once orders were sent as a container
+        size_t base = session.serverVersion < MIN_SERVER_VER_ORDER_CONTAINER ? 2 : 1;
+        long orderId = fieldLong(fields, base);
+        double quantity = fieldDouble(fields, base + 16, 1.0);
+        double limit = fieldDouble(fields, base + 18, 0.0);
+        double price = limit > 0.0 && limit < 1e300 ? limit : 100.0;
+
+        orders.fetch_add(1, std::memory_order_relaxed);
+        if (orderId >= session.nextOrderId) {
+            session.nextOrderId = orderId + 1;
+        }
+        session.sendOrderStatus(orderId, "Submitted", 0.0, quantity, 0.0, 0.0);
+        session.pendingFills.push_back({monotonicNanos() + config.fillDelayMs * 1000000LL, orderId, quantity, price});
+        break;
+    }
+    case CANCEL_ORDER: {
+        long orderId = fieldLong(fields, 2);
+        for (auto it = session.pendingFills.begin(); it != session.pendingFills.end(); ++it) {
+            if (it->orderId == orderId) {
+                session.sendOrderStatus(orderId, "Cancelled", 0.0, it->quantity, 0.0, 0.0);
+                session.pendingFills.erase(it);
+                break;
+            }
+        }
+        break;
+    }
+    case REQ_POSITIONS:
+        FrameWriter(session.out).add(POSITION_END).add(1).finish();
+        break;
+    case REQ_OPEN_ORDERS:
+    case REQ_ALL_OPEN_ORDERS:
+        FrameWriter(session.out).add(OPEN_ORDER_END).add(1).finish();
+        break;
+    case REQ_ACCOUNT_SUMMARY: {
+        long reqId = fieldLong(fields, 2);
+        const char* rows[][2] = {
+            {"NetLiquidation", "1000000.00"},
+            {"TotalCashValue", "500000.00"},
+            {"BuyingPower", "4000000.00"},
+        };
+        for (const auto& row : rows) {
+            FrameWriter(session.out).add(ACCOUNT_SUMMARY).add(1).add(reqId).add(config.accounts)
+                .add(std::string(row[0])).add(std::string(row[1])).add(std::string("USD")).finish();
+        }
+        FrameWriter(session.out).add(ACCOUNT_SUMMARY_END).add(1).add(reqId).finish();
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void MockGateway::sendFills(Session& session, int64_t nowNs) {
+    while (!session.pendingFills.empty() && session.pendingFills.front().dueNs <= nowNs) {
+        const Session::PendingFill& fill = session.pendingFills.front();
+        session.sendOrderStatus(fill.orderId, "Filled", fill.quantity, 0.0, fill.price, fill.price);
+        session.pendingFills.pop_front();
+    }
+}
+
+void MockGateway::generateTicks(Session& session, int64_t nowNs) {
+    if (session.tickers.empty() || config.ticksPerSecond <= 0.0) {
+        session.lastTickNs = nowNs;
+        return;
+    }
+
+    if (session.lastTickNs == 0) {
+        session.lastTickNs = nowNs;
+    }
+    session.tickCredit += config.ticksPerSecond * static_cast<double>(nowNs - session.lastTickNs) / 1e9;
+    session.lastTickNs = nowNs;
+
+    // Never burst more than 100 ms worth of ticks after a stall
+    double maxBurst = config.ticksPerSecond / 10.0 + 1.0;
+    if (session.tickCredit > maxBurst) {
+        session.tickCredit = maxBurst;
+    }
+
+    uint64_t due = static_cast<uint64_t>(session.tickCredit);
+    session.tickCredit -= static_cast<double>(due);
+
+    if (session.out.size() > config.maxPendingOutputBytes) {
+        throttled.fetch_add(due, std::memory_order_relaxed);
+        return;
+    }
+
+    for (uint64_t i = 0; i < due; ++i) {
+        Session::Ticker& ticker = session.tickers[session.nextTicker];
+        session.nextTicker = (session.nextTicker + 1) % session.tickers.size();
+
+        uint64_t r = session.random();
+        ticker.price += (static_cast<int>(r % 3) - 1) * 0.01;
+        if (ticker.price < 1.0) {
+            ticker.price = 1.0;
+        }
+        int size = 100 * static_cast<int>(1 + (r >> 8) % 10);
+
+        switch (session.tickCounter++ % 4) {
+        case 0:
+            FrameWriter(session.out).add(TICK_PRICE).add(6).add(ticker.id).add(TICK_BID)
+                .add(ticker.price - 0.01).add(size).add(0).finish();
+            break;
+        case 1:
+            FrameWriter(session.out).add(TICK_PRICE).add(6).add(ticker.id).add(TICK_ASK)
+                .add(ticker.price + 0.01).add(size).add(0).finish();
+            break;
+        case 2:
+            FrameWriter(session.out).add(TICK_PRICE).add(6).add(ticker.id).add(TICK_LAST)
+                .add(ticker.price).add(size).add(0).finish();
+            break;
+        default:
+            FrameWriter(session.out).add(TICK_SIZE).add(6).add(ticker.id).add(TICK_VOLUME)
+                .add(static_cast<long>(session.tickCounter * 100)).finish();
+            break;
+        }
+    }
+    ticks.fetch_add(due, std::memory_order_relaxed);
+}
+
+bool MockGateway::flush(Session& session) {
+    size_t sent = 0;
+    while (sent < session.out.size()) {
+        ssize_t n = send(session.fd, session.out.data() + sent, session.out.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                break;
+            }
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    session.out.erase(0, sent);
+    return true;
+}
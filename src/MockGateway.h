@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct MockGatewayConfig {
+    int port = 7500;                    // 0 picks an ephemeral port
+    int maxServerVersion = 151;         // negotiated down to the client's maximum
+    double ticksPerSecond = 10000.0;    // per session, spread over its subscriptions
+    int fillDelayMs = 5;                // order acknowledgement -> fill
+    long firstOrderId = 1000;
+    std::string accounts = "DU1000001";
+    size_t maxPendingOutputBytes = 4 * 1024 * 1024;
+};
+
+// Local stand-in for TWS / IB Gateway that speaks the server side of the API
+// wire protocol: the v100+ handshake, nextValidId, managedAccounts, account
+// summary / position / open order end markers, tick price and size streams for
+// every reqMktData subscription, and Submitted -> Filled order status for each
+// placeOrder. It exists so the connector can be benchmarked without a live session.
+class MockGateway {
+public:
+    explicit MockGateway(const MockGatewayConfig& config);
+    ~MockGateway();
+
+    MockGateway(const MockGateway&) = delete;
+    MockGateway& operator=(const MockGateway&) = delete;
+
+    // Binds and starts the server thread. Returns the bound port, or -1 on failure.
+    int start();
+    void stop();
+
+    uint64_t ticksSent() const { return ticks.load(std::memory_order_relaxed); }
+    uint64_t ticksThrottled() const { return throttled.load(std::memory_order_relaxed); }
+    uint64_t ordersReceived() const { return orders.load(std::memory_order_relaxed); }
+    int sessionCount() const { return sessions.load(std::memory_order_relaxed); }
+    // Closes every client connection on the next pass, as a gateway restart would.
+    void dropSessions() { dropRequested.store(true, std::memory_order_relaxed); }
+
+private:
+    struct Session;
+
+    MockGatewayConfig config;
+    int listenFd;
+    std::atomic<bool> running;
+    std::thread thread;
+    std::vector<std::unique_ptr<Session>> clients;
+
+    std::atomic<uint64_t> ticks;
+    std::atomic<uint64_t> throttled;
+    std::atomic<uint64_t> orders;
+    std::atomic<int> sessions;
+    std::atomic<bool> dropRequested;
+
+    void run();
+    void acceptClients();
+    bool readClient(Session& session);
+    bool handleHandshake(Session& session);
+    void handleMessage(Session& session, const std::vector<std::string>& fields);
+    void generateTicks(Session& session, int64_t nowNs);
+    void sendFills(Session& session, int64_t nowNs);
+    bool flush(Session& session);
+};
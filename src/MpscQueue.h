@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free multi-producer / single-consumer queue.
+//
+// Cells are pre-allocated and stamped with a sequence number (Vyukov's bounded
+// queue), so producers claim a cell with one CAS and fill it in place, and the
+// consumer hands it back without any allocation. Capacity is rounded up to a
+// power of two. tryPush returns false instead of blocking when the queue is full.
+template <typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t capacity)
+        : mask(roundUpPow2(capacity) - 1)
+        , cells(std::make_unique<Cell[]>(mask + 1)) {
+        for (size_t i = 0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    // Claims a cell and calls fill(T&) on it. Safe from any number of threads.
+    template <typename Fill>
+    bool tryPush(Fill&& fill) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        fill(cell->value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(const T& value) {
+        return tryPush([&value](T& slot) { slot = value; });
+    }
+
+    // Consumer side - calls consume(T&) for up to maxItems ready entries.
+    template <typename Consume>
+    size_t drain(Consume&& consume, size_t maxItems = SIZE_MAX) {
+        size_t count = 0;
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        while (count < maxItems) {
+            Cell& cell = cells[pos & mask];
+            if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+                break;
+            }
+
+            consume(cell.value);
+            cell.sequence.store(pos + mask + 1, std::memory_order_release);
+            ++pos;
+            ++count;
+            dequeuePos.store(pos, std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    // Consumer side - the oldest entry if it has been filled, else nullptr.
+    const T* front() const {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        const Cell& cell = cells[pos & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return nullptr;
+        }
+        return &cell.value;
+    }
+
+    // Consumer side - calls visit(const T&) on the filled entries, oldest first
+    // and without consuming them, until it returns true; returns whether it
+    // did. Cells still being filled are skipped, as their pushes have not
+    // returned yet.
+    template <typename Visit>
+    bool findReady(Visit&& visit) const {
+        size_t head = enqueuePos.load(std::memory_order_acquire);
+        for (size_t pos = dequeuePos.load(std::memory_order_relaxed); pos < head; ++pos) {
+            const Cell& cell = cells[pos & mask];
+            if (cell.sequence.load(std::memory_order_acquire) == pos + 1 && visit(cell.value)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Approximate number of queued entries, safe from any thread.
+    size_t sizeApprox() const {
+        size_t tail = dequeuePos.load(std::memory_order_relaxed);
+        size_t head = enqueuePos.load(std::memory_order_relaxed);
+        return head > tail ? head - tail : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t roundUpPow2(size_t n) {
+        size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+};
@@ -0,0 +1,187 @@
+#include "OrderBook.h"
+#include "ThreadTuning.h"
+#include <algorithm>
+
+namespace {
+// updateMktDepth operations
+enum : int {
+    DEPTH_INSERT = 0,
+    DEPTH_UPDATE = 1,
+    DEPTH_DELETE = 2
+};
+}
+
+// BookSnapshot
+
+int64_t BookSnapshot::cumulativeSize(BookSide side, int n) const {
+    const BookLevel* book = levels(side);
+    int count = std::min(n, levelCount(side));
+    int64_t total = 0;
+    for (int i = 0; i < count; ++i) {
+        total += book[i].size;
+    }
+    return total;
+}
+
+double BookSnapshot::microprice() const {
+    if (bidCount == 0 || askCount == 0) {
+        return 0.0;
+    }
+    const BookLevel& bid = bids[0];
+    const BookLevel& ask = asks[0];
+    int64_t total = bid.size + ask.size;
+    if (total <= 0) {
+        return (bid.price + ask.price) / 2.0;
+    }
+    // Weight each side's price by the opposite side's size
+    return (bid.price * ask.size + ask.price * bid.size) / static_cast<double>(total);
+}
+
+double BookSnapshot::spread() const {
+    if (bidCount == 0 || askCount == 0) {
+        return 0.0;
+    }
+    return asks[0].price - bids[0].price;
+}
+
+// OrderBookStore
+
+OrderBookStore::OrderBookStore(size_t capacity)
+    : bookCount(capacity)
+    , books(std::make_unique<Book[]>(capacity)) {
+}
+
+void OrderBookStore::beginWrite(Book& book) {
+    uint64_t seq = book.seq.load(std::memory_order_relaxed);
+    book.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void OrderBookStore::endWrite(Book& book) {
+    uint64_t seq = book.seq.load(std::memory_order_relaxed);
+    book.seq.store(seq + 1, std::memory_order_release);
+}
+
+void OrderBookStore::moveLevel(Level& to, const Level& from) {
+    to.price.store(from.price.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    to.size.store(from.size.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+bool OrderBookStore::update(long tickerId, int position, int operation, int side, double price,
+                            int64_t size, int64_t timestampNs) {
+    if (!inRange(tickerId) || position < 0 || position >= kMaxLevels) {
+        return false;
+    }
+
+    Book& book = books[tickerId];
+    Level* levels = side == static_cast<int>(BookSide::Bid) ? book.bids : book.asks;
+    std::atomic<int>& countRef = side == static_cast<int>(BookSide::Bid) ? book.bidCount : book.askCount;
+    int count = countRef.load(std::memory_order_relaxed);
+
+    beginWrite(book);
+    switch (operation) {
+    case DEPTH_INSERT: {
+        // Shift worse levels down one; the worst falls off a full book
+        int pos = std::min(position, count);
+        int last = std::min(count, kMaxLevels - 1);
+        for (int i = last; i > pos; --i) {
+            moveLevel(levels[i], levels[i - 1]);
+        }
+        levels[pos].price.store(price, std::memory_order_relaxed);
+        levels[pos].size.store(size, std::memory_order_relaxed);
+        countRef.store(std::min(count + 1, kMaxLevels), std::memory_order_relaxed);
+        break;
+    }
+    case DEPTH_UPDATE:
+        if (position >= count) {
+            // Update past the end: the level is new to us (e.g. after a reset)
+            countRef.store(position + 1, std::memory_order_relaxed);
+        }
+        levels[position].price.store(price, std::memory_order_relaxed);
+        levels[position].size.store(size, std::memory_order_relaxed);
+        break;
+    case DEPTH_DELETE:
+        if (position < count) {
+            for (int i = position; i < count - 1; ++i) {
+                moveLevel(levels[i], levels[i + 1]);
+            }
+            levels[count - 1].price.store(0.0, std::memory_order_relaxed);
+            levels[count - 1].size.store(0, std::memory_order_relaxed);
+            countRef.store(count - 1, std::memory_order_relaxed);
+        }
+        break;
+    default:
+        endWrite(book);
+        return false;
+    }
+    book.updateTimeNs.store(timestampNs, std::memory_order_relaxed);
+    endWrite(book);
+    return true;
+}
+
+void OrderBookStore::reset(long tickerId) {
+    if (!inRange(tickerId)) {
+        return;
+    }
+
+    Book& book = books[tickerId];
+    if (book.seq.load(std::memory_order_relaxed) == book.resetSeq.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    beginWrite(book);
+    for (int i = 0; i < kMaxLevels; ++i) {
+        book.bids[i].price.store(0.0, std::memory_order_relaxed);
+        book.bids[i].size.store(0, std::memory_order_relaxed);
+        book.asks[i].price.store(0.0, std::memory_order_relaxed);
+        book.asks[i].size.store(0, std::memory_order_relaxed);
+    }
+    book.bidCount.store(0, std::memory_order_relaxed);
+    book.askCount.store(0, std::memory_order_relaxed);
+    book.updateTimeNs.store(0, std::memory_order_relaxed);
+    // Sequences count from here, so an emptied book reads as "no data yet"
+    // while seq itself keeps growing
+    book.resetSeq.store(book.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    endWrite(book);
+}
+
+void OrderBookStore::clear() {
+    for (size_t i = 0; i < bookCount; ++i) {
+        reset(static_cast<long>(i));
+    }
+}
+
+bool OrderBookStore::snapshot(long tickerId, BookSnapshot& out, int maxLevels) const {
+    if (!inRange(tickerId)) {
+        return false;
+    }
+
+    const Book& book = books[tickerId];
+    int limit = std::max(0, std::min(maxLevels, kMaxLevels));
+    for (;;) {
+        uint64_t before = book.seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            cpuRelax();
+            continue;
+        }
+
+        out.bidCount = std::min(book.bidCount.load(std::memory_order_relaxed), limit);
+        out.askCount = std::min(book.askCount.load(std::memory_order_relaxed), limit);
+        for (int i = 0; i < out.bidCount; ++i) {
+            out.bids[i].price = book.bids[i].price.load(std::memory_order_relaxed);
+            out.bids[i].size = book.bids[i].size.load(std::memory_order_relaxed);
+        }
+        for (int i = 0; i < out.askCount; ++i) {
+            out.asks[i].price = book.asks[i].price.load(std::memory_order_relaxed);
+            out.asks[i].size = book.asks[i].size.load(std::memory_order_relaxed);
+        }
+        out.updateTimeNs = book.updateTimeNs.load(std::memory_order_relaxed);
+        uint64_t emptiedAt = book.resetSeq.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (book.seq.load(std::memory_order_relaxed) == before) {
+            out.sequence = (before - emptiedAt) / 2;
+            return out.valid();
+        }
+    }
+}
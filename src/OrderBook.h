@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+enum class BookSide {
+    Ask = 0,    // IB depth side 0
+    Bid = 1     // IB depth side 1
+};
+
+struct BookLevel {
+    double price = 0.0;
+    int64_t size = 0;
+};
+
+// Consistent copy of one book (or its top levels) returned to readers.
+struct BookSnapshot {
+    static constexpr int kMaxLevels = 32;
+
+    BookLevel bids[kMaxLevels];
+    BookLevel asks[kMaxLevels];
+    int bidCount = 0;
+    int askCount = 0;
+    int64_t updateTimeNs = 0;   // system_clock nanoseconds of the last depth update
+    uint64_t sequence = 0;      // updates applied since the book was last reset; 0 means no data yet
+
+    bool valid() const { return sequence != 0; }
+
+    const BookLevel* levels(BookSide side) const { return side == BookSide::Bid ? bids : asks; }
+    int levelCount(BookSide side) const { return side == BookSide::Bid ? bidCount : askCount; }
+
+    // Total size over the best n levels of a side.
+    int64_t cumulativeSize(BookSide side, int n) const;
+    // Size-weighted mid of the top of book; 0 if either side is empty.
+    double microprice() const;
+    double spread() const;
+};
+
+// Level-2 books indexed directly by market depth request id.
+//
+// Each side is a fixed array of price levels in IB position order (best first),
+// so updateMktDepth's insert/update/delete-at-position map to an indexed store
+// plus a shift of at most kMaxLevels entries - no allocation and no node-based
+// maps on the callback path. Books are seqlocked like QuoteStore slots: the
+// message processing thread is the only writer and readers copy without locking.
+class OrderBookStore {
+public:
+    static constexpr int kMaxLevels = BookSnapshot::kMaxLevels;
+
+    explicit OrderBookStore(size_t capacity = 512);
+
+    OrderBookStore(const OrderBookStore&) = delete;
+    OrderBookStore& operator=(const OrderBookStore&) = delete;
+
+    size_t capacity() const { return bookCount; }
+    bool inRange(long tickerId) const { return tickerId >= 0 && static_cast<size_t>(tickerId) < bookCount; }
+
+    // Writer side - must only be called from one thread at a time.
+    // operation is IB's 0 = insert, 1 = update, 2 = delete; side is 0 = ask, 1 = bid.
+    bool update(long tickerId, int position, int operation, int side, double price, int64_t size, int64_t timestampNs);
+    void reset(long tickerId);
+    void clear();
+
+    // Reader side - safe from any thread. Copies at most maxLevels per side.
+    bool snapshot(long tickerId, BookSnapshot& out, int maxLevels = kMaxLevels) const;
+
+private:
+    struct Level {
+        std::atomic<double> price{0.0};
+        std::atomic<int64_t> size{0};
+    };
+
+    struct alignas(64) Book {
+        std::atomic<uint64_t> seq{0};               // only ever grows, so a reader can't see it come back
+        std::atomic<uint64_t> resetSeq{0};          // seq when the book was last emptied
+        std::atomic<int> bidCount{0};
+        std::atomic<int> askCount{0};
+        std::atomic<int64_t> updateTimeNs{0};
+        Level bids[kMaxLevels];
+        Level asks[kMaxLevels];
+    };
+
+    size_t bookCount;
+    std::unique_ptr<Book[]> books;
+
+    static void beginWrite(Book& book);
+    static void endWrite(Book& book);
+    static void moveLevel(Level& to, const Level& from);
+};
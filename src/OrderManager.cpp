@@ -0,0 +1,80 @@
+#include "OrderManager.h"
+#include "Logger.h"
+
+OrderManager::OrderManager(std::shared_ptr<IBConnector> connector)
+    : ibConnector(std::move(connector)) {
+}
+
+OrderManager::~OrderManager() {
+}
+
+int OrderManager::placeMarketOrder(const std::string& symbol, const std::string& action, double quantity) {
+    return submit(createStockContract(symbol), createMarketOrder(action, quantity));
+}
+
+int OrderManager::placeLimitOrder(const std::string& symbol, const std::string& action, double quantity, double price) {
+    return submit(createStockContract(symbol), createLimitOrder(action, quantity, price));
+}
+
+int OrderManager::submit(const Contract& contract, const Order& order) {
+    if (!ibConnector->isConnected()) {
+        LOG_WARN("Not connected - cannot place order for {}", contract.symbol);
+        return -1;
+    }
+    
+    int orderId = static_cast<int>(ibConnector->allocateOrderId());
+    if (ibConnector->placeOrder(orderId, contract, order) != OrderReject::None) {
+        return -1;
+    }
+    return orderId;
+}
+
+void OrderManager::cancelOrder(int orderId) {
+    ibConnector->cancelOrder(orderId);
+}
+
+void OrderManager::cancelAllOrders() {
+    auto orders = ibConnector->getOpenOrders();
+    for (const auto& info : orders) {
+        ibConnector->cancelOrder(static_cast<int>(info.orderId));
+    }
+    LOG_INFO("Requested cancel of {} open orders", orders.size());
+}
+
+std::vector<IBConnector::OrderInfo> OrderManager::getOpenOrders() {
+    return ibConnector->getOpenOrders();
+}
+
+std::string OrderManager::getOrderStatus(int orderId) {
+    IBConnector::OrderInfo info;
+    if (!ibConnector->getOrder(orderId, info)) {
+        return "Unknown";
+    }
+    return orderStageName(info.stage);
+}
+
+Contract OrderManager::createStockContract(const std::string& symbol) {
+    Contract contract;
+    contract.symbol = symbol;
+    contract.secType = "STK";
+    contract.exchange = "SMART";
+    contract.currency = "USD";
+    return contract;
+}
+
+Order OrderManager::createMarketOrder(const std::string& action, double quantity) {
+    Order order;
+    order.action = action;
+    order.orderType = "MKT";
+    order.totalQuantity = quantity;
+    return order;
+}
+
+Order OrderManager::createLimitOrder(const std::string& action, double quantity, double price) {
+    Order order;
+    order.action = action;
+    order.orderType = "LMT";
+    order.totalQuantity = quantity;
+    order.lmtPrice = price;
+    return order;
+}
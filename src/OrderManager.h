@@ -3,15 +3,18 @@
 
 #include "IBConnector.h"
 #include <memory>
-#include <map>
-#include <mutex>
+#include <string>
+#include <vector>
+
+// Convenience layer for stock orders. Order records and their state machine
+// live in the connector's OrderTable, which the order callbacks update in O(1).
 
 class OrderManager {
 public:
     OrderManager(std::shared_ptr<IBConnector> connector);
     ~OrderManager();
     
-    // Order management functions
+    // Order management functions - return the order id, or -1 if not connected
     int placeMarketOrder(const std::string& symbol, const std::string& action, double quantity);
     int placeLimitOrder(const std::string& symbol, const std::string& action, double quantity, double price);
     void cancelOrder(int orderId);
@@ -23,8 +26,8 @@ public:
     
 private:
     std::shared_ptr<IBConnector> ibConnector;
-    std::map<int, IBConnector::OrderInfo> orderCache;
-    mutable std::mutex orderMutex;
+    
+    int submit(const Contract& contract, const Order& order);
     
     Contract createStockContract(const std::string& symbol);
     Order createMarketOrder(const std::string& action, double quantity);
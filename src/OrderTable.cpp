@@ -0,0 +1,216 @@
+#include "OrderTable.h"
+#include <algorithm>
+
+namespace {
+size_t roundUpPow2(size_t n) {
+    size_t p = 16;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+// Forward progress only: terminal stages are final and partial fills never go back to Submitted
+int stageRank(OrderStage stage) {
+    switch (stage) {
+    case OrderStage::PendingSubmit: return 0;
+    case OrderStage::Submitted: return 1;
+    case OrderStage::PartiallyFilled: return 2;
+    default: return 3;
+    }
+}
+}
+
+const char* orderStageName(OrderStage stage) {
+    switch (stage) {
+    case OrderStage::PendingSubmit: return "PendingSubmit";
+    case OrderStage::Submitted: return "Submitted";
+    case OrderStage::PartiallyFilled: return "PartiallyFilled";
+    case OrderStage::Filled: return "Filled";
+    case OrderStage::Cancelled: return "Cancelled";
+    case OrderStage::Rejected: return "Rejected";
+    default: return "Unknown";
+    }
+}
+
+bool isTerminal(OrderStage stage) {
+    return stage == OrderStage::Filled || stage == OrderStage::Cancelled || stage == OrderStage::Rejected;
+}
+
+OrderStage orderStageFromStatus(const std::string& status, double filled, double remaining) {
+    if (status == "Filled") {
+        return OrderStage::Filled;
+    }
+    if (status == "Cancelled" || status == "ApiCancelled") {
+        return OrderStage::Cancelled;
+    }
+    if (status == "Inactive") {
+        // IB reports rejected and otherwise dead orders as Inactive
+        return OrderStage::Rejected;
+    }
+    if (status == "PendingSubmit" || status == "ApiPending") {
+        return OrderStage::PendingSubmit;
+    }
+    // PreSubmitted, Submitted, PendingCancel
+    return filled > 0.0 && remaining > 0.0 ? OrderStage::PartiallyFilled : OrderStage::Submitted;
+}
+
+OrderTable::OrderTable(size_t capacity)
+    : pool(capacity)
+    , inUse(capacity, 0)
+    , buckets(roundUpPow2(capacity * 2), kEmpty)
+    , bucketMask(buckets.size() - 1)
+    , bucketShift(64)
+    , highWater(0)
+    , liveCount(0)
+    , terminalCount(0) {
+    for (size_t n = buckets.size(); n > 1; n >>= 1) {
+        --bucketShift;
+    }
+    freeSlots.reserve(capacity);
+}
+
+size_t OrderTable::home(OrderId orderId) const {
+    // Fibonacci hashing spreads the sequential ids IB hands out across the table
+    return static_cast<size_t>((static_cast<uint64_t>(orderId) * 0x9E3779B97F4A7C15ull) >> bucketShift);
+}
+
+size_t OrderTable::findBucket(OrderId orderId) const {
+    for (size_t b = home(orderId);; b = (b + 1) & bucketMask) {
+        int32_t slot = buckets[b];
+        if (slot == kEmpty || pool[slot].orderId == orderId) {
+            return b;
+        }
+    }
+}
+
+OrderRecord* OrderTable::find(OrderId orderId) {
+    int32_t slot = buckets[findBucket(orderId)];
+    return slot == kEmpty ? nullptr : &pool[slot];
+}
+
+const OrderRecord* OrderTable::find(OrderId orderId) const {
+    int32_t slot = buckets[findBucket(orderId)];
+    return slot == kEmpty ? nullptr : &pool[slot];
+}
+
+OrderRecord* OrderTable::insert(OrderId orderId) {
+    size_t b = findBucket(orderId);
+    if (buckets[b] != kEmpty) {
+        return &pool[buckets[b]];
+    }
+
+    if (freeSlots.empty() && highWater == pool.size()) {
+        if (terminalCount == 0 || purgeTerminal() == 0) {
+            return nullptr;
+        }
+        b = findBucket(orderId);
+    }
+
+    int32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<int32_t>(highWater++);
+    }
+
+    pool[slot] = OrderRecord();
+    pool[slot].orderId = orderId;
+    inUse[slot] = 1;
+    buckets[b] = slot;
+    ++liveCount;
+    return &pool[slot];
+}
+
+bool OrderTable::applyStatus(OrderRecord& record, const std::string& status, double filled, double remaining,
+                             double avgFillPrice, double lastFillPrice, int permId, int64_t nowNs) {
+    OrderStage next = orderStageFromStatus(status, filled, remaining);
+    if (isTerminal(record.stage) || stageRank(next) < stageRank(record.stage)) {
+        return false;
+    }
+
+    setStage(record, next);
+    record.status = status;
+    record.filled = filled;
+    record.remaining = remaining;
+    record.avgFillPrice = avgFillPrice;
+    record.lastFillPrice = lastFillPrice;
+    record.permId = permId;
+    record.updateTimeNs = nowNs;
+    return true;
+}
+
+bool OrderTable::transition(OrderRecord& record, OrderStage stage, int64_t nowNs) {
+    if (isTerminal(record.stage) || stageRank(stage) < stageRank(record.stage)) {
+        return false;
+    }
+    setStage(record, stage);
+    record.status = orderStageName(stage);
+    record.updateTimeNs = nowNs;
+    return true;
+}
+
+void OrderTable::setStage(OrderRecord& record, OrderStage stage) {
+    if (isTerminal(stage) && !isTerminal(record.stage)) {
+        ++terminalCount;
+    }
+    record.stage = stage;
+}
+
+bool OrderTable::erase(OrderId orderId) {
+    size_t b = findBucket(orderId);
+    int32_t slot = buckets[b];
+    if (slot == kEmpty) {
+        return false;
+    }
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    size_t hole = b;
+    for (size_t next = (hole + 1) & bucketMask; buckets[next] != kEmpty; next = (next + 1) & bucketMask) {
+        size_t want = home(pool[buckets[next]].orderId);
+        // Move the entry back if its home is not cyclically within (hole, next]
+        bool inRange = hole <= next ? (want > hole && want <= next) : (want > hole || want <= next);
+        if (!inRange) {
+            buckets[hole] = buckets[next];
+            hole = next;
+        }
+    }
+    buckets[hole] = kEmpty;
+
+    if (isTerminal(pool[slot].stage)) {
+        --terminalCount;
+    }
+    inUse[slot] = 0;
+    pool[slot] = OrderRecord();
+    freeSlots.push_back(slot);
+    --liveCount;
+    return true;
+}
+
+size_t OrderTable::purgeTerminal() {
+    std::vector<OrderId> finished;
+    forEach([&finished](const OrderRecord& record) {
+        if (isTerminal(record.stage)) {
+            finished.push_back(record.orderId);
+        }
+    });
+    for (OrderId id : finished) {
+        erase(id);
+    }
+    return finished.size();
+}
+
+void OrderTable::clear() {
+    for (size_t i = 0; i < highWater; ++i) {
+        if (inUse[i]) {
+            pool[i] = OrderRecord();
+            inUse[i] = 0;
+        }
+    }
+    std::fill(buckets.begin(), buckets.end(), kEmpty);
+    freeSlots.clear();
+    highWater = 0;
+    liveCount = 0;
+    terminalCount = 0;
+}
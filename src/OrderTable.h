@@ -0,0 +1,123 @@
+#pragma once
+
+#include "CommonDefs.h"
+#include "Contract.h"
+#include "Order.h"
+#include "OrderState.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Lifecycle of an order as tracked by the connector. Stages only move forward;
+// Filled, Cancelled and Rejected are terminal.
+enum class OrderStage {
+    PendingSubmit,
+    Submitted,
+    PartiallyFilled,
+    Filled,
+    Cancelled,
+    Rejected
+};
+
+const char* orderStageName(OrderStage stage);
+bool isTerminal(OrderStage stage);
+// Maps an IB orderStatus string (plus fill counts) onto a stage.
+OrderStage orderStageFromStatus(const std::string& status, double filled, double remaining);
+
+// Contract and order terms, set when an order is placed or reported by openOrder.
+struct OrderDetails {
+    Contract contract;
+    Order order;
+    OrderState orderState;
+};
+
+// One pool slot. The hot fields touched by every orderStatus stay small and
+// inline; the (large) IB contract/order objects live behind details, which
+// open-order snapshots share rather than copy.
+struct OrderRecord {
+    OrderId orderId = 0;
+    OrderStage stage = OrderStage::PendingSubmit;
+    std::string status;         // last raw IB status string
+    double filled = 0.0;
+    double remaining = 0.0;
+    double avgFillPrice = 0.0;
+    double lastFillPrice = 0.0;
+    int permId = 0;
+    int64_t updateTimeNs = 0;   // system_clock nanoseconds of the last change
+    bool riskReserved = false;  // quantity is held by the RiskGate until the order ends
+    double riskQuantity = 0.0;  // totalQuantity it was reserved for; still held: less filled
+    std::shared_ptr<OrderDetails> details;
+
+    // Copy on write: details still referenced by a published snapshot are
+    // copied before they change. Snapshots only ever take a reference from the
+    // record, under the connector's data mutex, so a count of one means nobody
+    // else can be reading them.
+    OrderDetails& mutableDetails() {
+        if (!details) {
+            details = std::make_shared<OrderDetails>();
+        } else if (details.use_count() > 1) {
+            details = std::make_shared<OrderDetails>(*details);
+        }
+        return *details;
+    }
+};
+
+// Order records in a pre-allocated slot pool, found by orderId through an
+// open-addressing (linear probing) hash, so lookups and status updates are
+// O(1) no matter how many orders a session has seen. Not thread-safe; the
+// connector guards it with its data mutex.
+class OrderTable {
+public:
+    explicit OrderTable(size_t capacity = 65536);
+
+    OrderTable(const OrderTable&) = delete;
+    OrderTable& operator=(const OrderTable&) = delete;
+
+    size_t capacity() const { return pool.size(); }
+    size_t size() const { return liveCount; }
+
+    OrderRecord* find(OrderId orderId);
+    const OrderRecord* find(OrderId orderId) const;
+    // Returns the existing record or claims a new PendingSubmit one. When the
+    // pool is full, terminal orders are purged first; nullptr if still full.
+    OrderRecord* insert(OrderId orderId);
+
+    // Applies an orderStatus update. Returns false if it would move the order
+    // backwards (late or duplicate messages) and leaves the record unchanged.
+    bool applyStatus(OrderRecord& record, const std::string& status, double filled, double remaining,
+                     double avgFillPrice, double lastFillPrice, int permId, int64_t nowNs);
+    // Forces a stage change, e.g. a rejection reported through error().
+    bool transition(OrderRecord& record, OrderStage stage, int64_t nowNs);
+
+    bool erase(OrderId orderId);
+    size_t purgeTerminal();
+    void clear();
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (size_t i = 0; i < highWater; ++i) {
+            if (inUse[i]) {
+                fn(pool[i]);
+            }
+        }
+    }
+
+private:
+    static constexpr int32_t kEmpty = -1;
+
+    std::vector<OrderRecord> pool;
+    std::vector<uint8_t> inUse;
+    std::vector<int32_t> freeSlots;
+    std::vector<int32_t> buckets;   // slot index per bucket, kEmpty if unused
+    size_t bucketMask;
+    int bucketShift;
+    size_t highWater;
+    size_t liveCount;
+    size_t terminalCount;       // purge candidates, so a full table of live orders fails fast
+
+    void setStage(OrderRecord& record, OrderStage stage);
+    size_t home(OrderId orderId) const;
+    size_t findBucket(OrderId orderId) const;
+};
@@ -0,0 +1,379 @@
+#include "OutboundScheduler.h"
+#include "Clock.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+namespace {
+// Longest the sender parks before re-checking the queues
+const auto kParkTimeout = std::chrono::milliseconds(100);
+// Wait for socket buffer space before re-checking for shutdown
+const int kWritablePollMs = 100;
+// Messages per sendmsg(), well under IOV_MAX
+const size_t kMaxBatch = 64;
+}
+
+OutboundScheduler::OutboundScheduler(const OutboundSettings& settings)
+    : settings(settings)
+    , cancelCommands(settings.commandQueue)
+    , orderCommands(settings.commandQueue)
+    , nextSequence(0)
+    , senderParked(false)
+    , queuedCount(0)
+    , running(false)
+    , tokens(settings.burst > 0 ? settings.burst : 1)
+    , lastRefillNs(0)
+    , client(nullptr)
+    , fd(-1)
+    , sentCount(0)
+    , writeCount(0)
+    , coalescedCount(0)
+    , throttledCount(0)
+    , rejectedCount(0) {
+}
+
+OutboundScheduler::~OutboundScheduler() {
+    stop();
+}
+
+void OutboundScheduler::start(CapturingClientSocket& socketClient) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return;
+    }
+    client = &socketClient;
+    fd = socketClient.fd();
+
+    // Requests are batched here already; Nagle would only add a round trip of delay
+    int noDelay = 1;
+    if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay)) != 0) {
+        LOG_WARN("Could not set TCP_NODELAY on the API socket: {}", std::strerror(errno));
+    }
+
+    // Orders submitted while no session was up must not reach the next one
+    size_t stale = discardCommands();
+    if (stale > 0) {
+        LOG_WARN("Dropped {} order and cancel commands submitted while disconnected", stale);
+    }
+
+    running = true;
+    tokens = settings.burst > 0 ? settings.burst : 1;
+    lastRefillNs = monotonicNanos();
+    sender = std::thread(&OutboundScheduler::run, this);
+}
+
+void OutboundScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wakeup.notify_all();
+    if (sender.joinable()) {
+        sender.join();
+    }
+
+    // Nothing survives a session: streams are replayed and orders reconciled by the caller
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Queue& queue : queues) {
+        queue.clear();
+    }
+    pending.clear();
+    liveStreams.clear();
+    queuedCount = 0;
+    discardCommands();
+}
+
+size_t OutboundScheduler::discardCommands() {
+    auto discard = [](Command& command) {
+        command.overflow.clear();
+    };
+    return cancelCommands.drain(discard) + orderCommands.drain(discard);
+}
+
+size_t OutboundScheduler::pendingCommands() const {
+    return cancelCommands.sizeApprox() + orderCommands.sizeApprox();
+}
+
+uint64_t OutboundScheduler::streamKey(OutboundStream stream, int id) {
+    return (static_cast<uint64_t>(stream) + 1) << 32 | static_cast<uint32_t>(id);
+}
+
+int64_t OutboundScheduler::submit(OutboundPriority priority, int orderId, const std::string& encoded) {
+    int64_t submitNs = monotonicNanos();
+    MpscQueue<Command>& lane = priority == OutboundPriority::Cancel ? cancelCommands : orderCommands;
+    bool pushed = lane.tryPush([&](Command& command) {
+        command.submitNs = submitNs;
+        command.sequence = nextSequence.fetch_add(1, std::memory_order_relaxed);
+        command.orderId = orderId;
+        command.priority = priority;
+        command.length = static_cast<uint32_t>(encoded.size());
+        if (encoded.size() <= kInlineCommandBytes) {
+            std::memcpy(command.bytes, encoded.data(), encoded.size());
+        } else {
+            command.overflow = encoded;
+        }
+    });
+    if (!pushed) {
+        rejectedCount.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    // Same handshake as FrameQueue: the sender is only woken when it is parked
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (senderParked.load(std::memory_order_relaxed)) {
+        notifySender();
+    }
+    return submitNs;
+}
+
+void OutboundScheduler::notifySender() {
+    std::lock_guard<std::mutex> lock(mutex);
+    wakeup.notify_one();
+}
+
+OutboundScheduler::Queue::iterator OutboundScheduler::push(OutboundPriority priority, Send send, uint64_t key, Kind kind) {
+    Queue& queue = queues[static_cast<size_t>(priority)];
+    queue.push_back({std::move(send), monotonicNanos(), key, kind});
+    ++queuedCount;
+    return std::prev(queue.end());
+}
+
+void OutboundScheduler::enqueue(OutboundPriority priority, Send send) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        push(priority, std::move(send), 0, Kind::Plain);
+    }
+    wakeup.notify_one();
+}
+
+void OutboundScheduler::subscribe(OutboundStream stream, int id, Send send) {
+    uint64_t key = streamKey(stream, id);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto queued = pending.find(key);
+        if (queued != pending.end()) {
+            // Only the latest contract for the id matters
+            queued->second->send = std::move(send);
+            coalescedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        pending[key] = push(OutboundPriority::Subscription, std::move(send), key, Kind::Subscribe);
+    }
+    wakeup.notify_one();
+}
+
+void OutboundScheduler::unsubscribe(OutboundStream stream, int id, Send send) {
+    uint64_t key = streamKey(stream, id);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto queued = pending.find(key);
+        if (queued != pending.end()) {
+            queues[static_cast<size_t>(OutboundPriority::Subscription)].erase(queued->second);
+            --queuedCount;
+            pending.erase(queued);
+            coalescedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (liveStreams.erase(key) == 0) {
+            // Never reached the gateway, or its cancel is already queued
+            coalescedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        push(OutboundPriority::Subscription, std::move(send), key, Kind::Unsubscribe);
+    }
+    wakeup.notify_one();
+}
+
+OutboundScheduler::Outgoing& OutboundScheduler::nextOutgoing(size_t& used) {
+    if (used == batch.size()) {
+        batch.emplace_back();
+    }
+    return batch[used++];
+}
+
+void OutboundScheduler::run() {
+    applyThreadTuning(settings.senderThread, "ib-send");
+
+    const bool paced = settings.messagesPerSecond > 0.0;
+    const double burst = settings.burst > 0 ? settings.burst : 1;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        if (queuedCount == 0 && pendingCommands() == 0) {
+            // submit() only takes the mutex to wake us once it has seen this flag
+            senderParked.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            wakeup.wait_for(lock, kParkTimeout, [this] {
+                return !running || queuedCount > 0 || pendingCommands() > 0;
+            });
+            senderParked.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        int64_t nowNs = monotonicNanos();
+        if (paced) {
+            tokens = std::min(burst, tokens + (nowNs - lastRefillNs) * settings.messagesPerSecond / 1e9);
+            lastRefillNs = nowNs;
+            if (tokens < 1.0) {
+                throttledCount.fetch_add(1, std::memory_order_relaxed);
+                auto waitNs = static_cast<int64_t>((1.0 - tokens) * 1e9 / settings.messagesPerSecond);
+                wakeup.wait_for(lock, std::chrono::nanoseconds(waitNs), [this] { return !running; });
+                continue;
+            }
+        }
+        size_t allowed = std::min(paced ? static_cast<size_t>(tokens) : kMaxBatch, kMaxBatch);
+
+        // Cancels, then orders, each in the order they were submitted
+        size_t used = 0;
+        takeCommands(used, allowed);
+
+        // Then the queued requests, most urgent class first
+        for (size_t cls = 0; cls < kClasses && used + closures.size() < allowed; ++cls) {
+            Queue& queue = queues[cls];
+            while (!queue.empty() && used + closures.size() < allowed) {
+                Entry& entry = queue.front();
+                if (entry.kind == Kind::Subscribe) {
+                    pending.erase(entry.key);
+                    liveStreams.insert(entry.key);
+                }
+                closures.emplace_back(std::move(entry), cls);
+                queue.pop_front();
+                --queuedCount;
+            }
+        }
+
+        size_t taken = used + closures.size();
+        if (taken == 0) {
+            // A producer has claimed a cell but not filled it yet
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+            continue;
+        }
+        if (paced) {
+            tokens -= static_cast<double>(taken);
+        }
+        lock.unlock();
+
+        // Encoded on this thread, the only one writing to the socket
+        for (auto& closure : closures) {
+            Outgoing& out = nextOutgoing(used);
+            out.bytes.clear();
+            client->capture(out.bytes, closure.first.send);
+            out.enqueueNs = closure.first.enqueueNs;
+            out.priority = closure.second;
+        }
+        closures.clear();
+
+        writeBatch(used);
+        int64_t doneNs = monotonicNanos();
+        for (size_t i = 0; i < used; ++i) {
+            queueDelay[batch[i].priority].record(doneNs - batch[i].enqueueNs);
+        }
+        sentCount.fetch_add(used, std::memory_order_relaxed);
+        lock.lock();
+    }
+}
+
+bool OutboundScheduler::orderQueuedBefore(const Command& cancel) const {
+    return orderCommands.findReady([&cancel](const Command& order) {
+        return order.orderId == cancel.orderId && order.sequence < cancel.sequence;
+    });
+}
+
+void OutboundScheduler::takeCommands(size_t& used, size_t allowed) {
+    while (used < allowed) {
+        // A cancel waits for its own order, which goes out with the orders ahead of it
+        const Command* cancel = cancelCommands.front();
+        if (cancel && !orderQueuedBefore(*cancel)) {
+            takeCommand(cancelCommands, used);
+        } else if (!takeCommand(orderCommands, used)) {
+            return;
+        }
+    }
+}
+
+bool OutboundScheduler::takeCommand(MpscQueue<Command>& lane, size_t& used) {
+    return lane.drain([this, &used](Command& command) {
+        Outgoing& out = nextOutgoing(used);
+        if (command.length <= kInlineCommandBytes) {
+            out.bytes.assign(command.bytes, command.length);
+        } else {
+            out.bytes.swap(command.overflow);
+            command.overflow.clear();
+        }
+        out.enqueueNs = command.submitNs;
+        out.priority = static_cast<size_t>(command.priority);
+    }, 1) == 1;
+}
+
+bool OutboundScheduler::writeBatch(size_t count) {
+    iov.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (!batch[i].bytes.empty()) {
+            iov.push_back({&batch[i].bytes[0], batch[i].bytes.size()});
+        }
+    }
+
+    size_t first = 0;
+    while (first < iov.size()) {
+        msghdr message{};
+        message.msg_iov = iov.data() + first;
+        message.msg_iovlen = iov.size() - first;
+        ssize_t n = sendmsg(fd, &message, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // The socket is non-blocking; wait for the gateway to catch up
+                pollfd pfd{fd, POLLOUT, 0};
+                poll(&pfd, 1, kWritablePollMs);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!running) {
+                    return false;
+                }
+                continue;
+            }
+            // The reader sees the same failure and the connection is re-established
+            LOG_ERROR("Outbound write failed: {}", std::strerror(errno));
+            return false;
+        }
+        writeCount.fetch_add(1, std::memory_order_relaxed);
+
+        // Skip what went out, trimming a partially written message
+        size_t written = static_cast<size_t>(n);
+        while (first < iov.size() && written >= iov[first].iov_len) {
+            written -= iov[first].iov_len;
+            ++first;
+        }
+        if (written > 0) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + written;
+            iov[first].iov_len -= written;
+        }
+    }
+    return true;
+}
+
+OutboundStats OutboundScheduler::stats() const {
+    OutboundStats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.queued = queuedCount;
+    }
+    stats.queued += pendingCommands();
+    stats.sent = sentCount.load(std::memory_order_relaxed);
+    stats.writes = writeCount.load(std::memory_order_relaxed);
+    stats.coalesced = coalescedCount.load(std::memory_order_relaxed);
+    stats.throttled = throttledCount.load(std::memory_order_relaxed);
+    stats.rejected = rejectedCount.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kClasses; ++i) {
+        stats.queueDelay[i] = summarize(queueDelay[i]);
+    }
+    return stats;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "CapturingClientSocket.h"
+#include "ConnectorStats.h"
+#include "MpscQueue.h"
+#include "Settings.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sys/uio.h>
+
+// Streams that can be subscribed and cancelled by id.
+enum class OutboundStream : uint8_t {
+    MarketData,
+    Depth,
+    RealTimeBars,
+    TickByTick
+};
+
+// Single writer for every outbound API request.
+//
+// The "ib-send" thread owns the socket for writing once the handshake is done.
+// Orders and cancels arrive pre-encoded through lock-free MPSC queues, one
+// each, so the calling thread only encodes and claims a cell; everything else
+// is queued as a closure that performs the EClient call and is encoded on the
+// sender. Each pass takes as many requests as the token bucket allows -
+// cancels, then orders, each in submission order, then subscriptions, then
+// bulk lookups - and writes
+// them with one gathering sendmsg() on a TCP_NODELAY socket, so bursts never
+// exceed the gateway's message pacing and a subscription sweep can't hold up an
+// order. A cancel overtakes queued orders for other ids only: orders for its
+// own id that were submitted before it are sent first, so the gateway never
+// sees a cancel ahead of the order it cancels. A subscribe followed by its
+// cancel, or a repeated subscribe, is coalesced while still queued.
+class OutboundScheduler {
+public:
+    using Send = std::function<void()>;
+
+    explicit OutboundScheduler(const OutboundSettings& settings);
+    ~OutboundScheduler();
+
+    OutboundScheduler(const OutboundScheduler&) = delete;
+    OutboundScheduler& operator=(const OutboundScheduler&) = delete;
+
+    // Starts writing to client's socket. Commands left over from an earlier
+    // session are dropped.
+    void start(CapturingClientSocket& client);
+    // Stops the sender and drops whatever is still queued.
+    void stop();
+
+    // Pre-encoded order or cancel (framed wire bytes) for orderId. Lock-free
+    // and safe from any thread; returns the monotonicNanos() submission time,
+    // or 0 if the queue is full and nothing will be sent.
+    int64_t submit(OutboundPriority priority, int orderId, const std::string& encoded);
+
+    void enqueue(OutboundPriority priority, Send send);
+
+    void subscribe(OutboundStream stream, int id, Send send);
+    // Dropped together with a queued subscribe when the stream was never sent,
+    // and dropped when the stream's cancel is already queued or sent.
+    void unsubscribe(OutboundStream stream, int id, Send send);
+
+    OutboundStats stats() const;
+
+private:
+    static constexpr size_t kInlineCommandBytes = 1024;     // a typical placeOrder is a few hundred
+    static constexpr size_t kClasses = static_cast<size_t>(OutboundPriority::Count);
+
+    struct Command {
+        int64_t submitNs;
+        uint64_t sequence;              // submission order across both lanes
+        int orderId;
+        OutboundPriority priority;
+        uint32_t length;
+        char bytes[kInlineCommandBytes];
+        std::string overflow;           // encodings longer than bytes
+    };
+
+    enum class Kind : uint8_t {
+        Plain,
+        Subscribe,
+        Unsubscribe
+    };
+
+    struct Entry {
+        Send send;
+        int64_t enqueueNs;
+        uint64_t key;
+        Kind kind;
+    };
+    using Queue = std::list<Entry>;
+
+    // One message of the batch being written; the buffers keep their capacity
+    struct Outgoing {
+        std::string bytes;
+        int64_t enqueueNs;
+        size_t priority;
+    };
+
+    OutboundSettings settings;
+    MpscQueue<Command> cancelCommands;
+    MpscQueue<Command> orderCommands;
+    std::atomic<uint64_t> nextSequence;
+    std::atomic<bool> senderParked;
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    std::array<Queue, kClasses> queues;
+    std::unordered_map<uint64_t, Queue::iterator> pending;     // queued subscribes
+    std::unordered_set<uint64_t> liveStreams;                   // subscribes sent, no cancel queued
+    size_t queuedCount;
+    bool running;
+    double tokens;
+    int64_t lastRefillNs;
+    std::thread sender;
+    CapturingClientSocket* client;
+    int fd;
+
+    // Sender thread only
+    std::vector<Outgoing> batch;
+    std::vector<std::pair<Entry, size_t>> closures;
+    std::vector<iovec> iov;
+    std::array<LatencyHistogram, kClasses> queueDelay;
+    std::atomic<uint64_t> sentCount;
+    std::atomic<uint64_t> writeCount;
+    std::atomic<uint64_t> coalescedCount;
+    std::atomic<uint64_t> throttledCount;
+    std::atomic<uint64_t> rejectedCount;
+
+    static uint64_t streamKey(OutboundStream stream, int id);
+    Queue::iterator push(OutboundPriority priority, Send send, uint64_t key, Kind kind);
+    void notifySender();
+    size_t discardCommands();
+    size_t pendingCommands() const;
+    bool orderQueuedBefore(const Command& cancel) const;
+    void takeCommands(size_t& used, size_t allowed);
+    bool takeCommand(MpscQueue<Command>& lane, size_t& used);
+    Outgoing& nextOutgoing(size_t& used);
+    bool writeBatch(size_t count);
+    void run();
+};
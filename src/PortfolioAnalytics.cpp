@@ -0,0 +1,367 @@
+#include "PortfolioAnalytics.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FATTY_X86_KERNELS 1
+#endif
+
+namespace {
+struct LaneArrays {
+    const double* quantity;
+    const double* multiplier;
+    const double* price;
+    const double* avgCost;
+    const double* delta;
+    const double* underlying;
+    const double* beta;
+    const double* gammaUnit;
+    const double* vegaUnit;
+    const double* thetaUnit;
+    double* marketValue;
+    double* grossValue;
+    double* deltaDollars;
+    double* betaDollars;
+    double* unrealized;
+    double* gamma;
+    double* vega;
+    double* theta;
+};
+
+using LaneKernel = void (*)(const LaneArrays&, size_t, size_t);
+using SumKernel = double (*)(const double*, size_t);
+
+void computeLanesScalar(const LaneArrays& a, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        double units = a.quantity[i] * a.multiplier[i];
+        double notional = units * a.price[i];
+        double deltaShares = units * a.delta[i];
+        a.marketValue[i] = notional;
+        a.grossValue[i] = std::fabs(notional);
+        a.deltaDollars[i] = deltaShares * a.underlying[i];
+        a.betaDollars[i] = a.deltaDollars[i] * a.beta[i];
+        a.unrealized[i] = notional - a.quantity[i] * a.avgCost[i];
+        a.gamma[i] = units * a.gammaUnit[i];
+        a.vega[i] = units * a.vegaUnit[i];
+        a.theta[i] = units * a.thetaUnit[i];
+    }
+}
+
+double sumScalar(const double* values, size_t count) {
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+#ifdef FATTY_X86_KERNELS
+__attribute__((target("avx2,fma")))
+void computeLanesAvx2(const LaneArrays& a, size_t begin, size_t end) {
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256d quantity = _mm256_loadu_pd(a.quantity + i);
+        __m256d units = _mm256_mul_pd(quantity, _mm256_loadu_pd(a.multiplier + i));
+        __m256d notional = _mm256_mul_pd(units, _mm256_loadu_pd(a.price + i));
+        __m256d deltaDollars = _mm256_mul_pd(_mm256_mul_pd(units, _mm256_loadu_pd(a.delta + i)),
+                                             _mm256_loadu_pd(a.underlying + i));
+        _mm256_storeu_pd(a.marketValue + i, notional);
+        _mm256_storeu_pd(a.grossValue + i, _mm256_andnot_pd(signBit, notional));
+        _mm256_storeu_pd(a.deltaDollars + i, deltaDollars);
+        _mm256_storeu_pd(a.betaDollars + i, _mm256_mul_pd(deltaDollars, _mm256_loadu_pd(a.beta + i)));
+        _mm256_storeu_pd(a.unrealized + i, _mm256_fnmadd_pd(quantity, _mm256_loadu_pd(a.avgCost + i), notional));
+        _mm256_storeu_pd(a.gamma + i, _mm256_mul_pd(units, _mm256_loadu_pd(a.gammaUnit + i)));
+        _mm256_storeu_pd(a.vega + i, _mm256_mul_pd(units, _mm256_loadu_pd(a.vegaUnit + i)));
+        _mm256_storeu_pd(a.theta + i, _mm256_mul_pd(units, _mm256_loadu_pd(a.thetaUnit + i)));
+    }
+    computeLanesScalar(a, i, end);
+}
+
+__attribute__((target("avx2,fma")))
+double sumAvx2(const double* values, size_t count) {
+    // Four independent accumulators hide the add latency
+    __m256d s0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd();
+    __m256d s3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        s0 = _mm256_add_pd(s0, _mm256_loadu_pd(values + i));
+        s1 = _mm256_add_pd(s1, _mm256_loadu_pd(values + i + 4));
+        s2 = _mm256_add_pd(s2, _mm256_loadu_pd(values + i + 8));
+        s3 = _mm256_add_pd(s3, _mm256_loadu_pd(values + i + 12));
+    }
+    for (; i + 4 <= count; i += 4) {
+        s0 = _mm256_add_pd(s0, _mm256_loadu_pd(values + i));
+    }
+    __m256d s = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+    double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    return sum + sumScalar(values + i, count - i);
+}
+#endif
+
+void addTotals(RiskTotals& into, const RiskTotals& lane, double sign) {
+    into.marketValue += sign * lane.marketValue;
+    into.grossValue += sign * lane.grossValue;
+    into.deltaDollars += sign * lane.deltaDollars;
+    into.betaDollars += sign * lane.betaDollars;
+    into.unrealizedPnl += sign * lane.unrealizedPnl;
+    into.gamma += sign * lane.gamma;
+    into.vega += sign * lane.vega;
+    into.theta += sign * lane.theta;
+}
+}
+
+bool PortfolioAnalytics::avx2Available() {
+#ifdef FATTY_X86_KERNELS
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+PortfolioAnalytics::PortfolioAnalytics()
+    : fullRefresh(false)
+    , useAvx2(avx2Available()) {
+    sectorNames.push_back("Unassigned");
+    sectorIds[sectorNames.front()] = 0;
+    sectorTotals.resize(1);
+}
+
+void PortfolioAnalytics::ensureLane(size_t lane) {
+    if (lane < quantity.size()) {
+        return;
+    }
+
+    size_t n = lane + 1;
+    for (std::vector<double>* column : {&quantity, &price, &avgCost, &gammaUnit, &vegaUnit, &thetaUnit, &underlying,
+                                        &marketValue, &grossValue, &deltaDollars, &betaDollars, &unrealized,
+                                        &gamma, &vega, &theta}) {
+        column->resize(n, 0.0);
+    }
+    multiplier.resize(n, 1.0);
+    delta.resize(n, 1.0);
+    beta.resize(n, 1.0);
+    accountOf.resize(n, 0);
+    sectorOf.resize(n, 0);
+    symbolOf.resize(n);
+    isOptionLane.resize(n, 0);
+    dirty.resize(n, 0);
+}
+
+void PortfolioAnalytics::markDirty(size_t lane) {
+    if (!dirty[lane]) {
+        dirty[lane] = 1;
+        dirtyLanes.push_back(static_cast<uint32_t>(lane));
+    }
+}
+
+uint32_t PortfolioAnalytics::accountId(const std::string& account) {
+    auto it = accountIds.find(account);
+    if (it != accountIds.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(accountNames.size());
+    accountNames.push_back(account);
+    accountIds.emplace(account, id);
+    accountTotals.emplace_back();
+    return id;
+}
+
+uint32_t PortfolioAnalytics::sectorId(const std::string& sector) {
+    auto it = sectorIds.find(sector);
+    if (it != sectorIds.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(sectorNames.size());
+    sectorNames.push_back(sector);
+    sectorIds.emplace(sector, id);
+    sectorTotals.emplace_back();
+    return id;
+}
+
+void PortfolioAnalytics::setPosition(size_t lane, const std::string& account, const std::string& symbol, bool isOption,
+                                     double qty, double mult, double cost) {
+    bool created = lane >= quantity.size() || symbolOf[lane].empty();
+    ensureLane(lane);
+
+    uint32_t account_ = accountId(account);
+    if (created) {
+        symbolOf[lane] = symbol;
+        isOptionLane[lane] = isOption ? 1 : 0;
+        delta[lane] = isOption ? 0.0 : 1.0;
+        auto f = factors.find(symbol);
+        if (f != factors.end()) {
+            beta[lane] = f->second.beta;
+            sectorOf[lane] = f->second.sector;
+        }
+    } else if (accountOf[lane] != account_) {
+        fullRefresh = true;     // moves between account groups
+    }
+    accountOf[lane] = account_;
+    quantity[lane] = qty;
+    multiplier[lane] = mult > 0.0 ? mult : 1.0;
+    avgCost[lane] = cost;
+    markDirty(lane);
+}
+
+void PortfolioAnalytics::setPrice(size_t lane, double value) {
+    if (lane >= quantity.size()) {
+        return;
+    }
+    price[lane] = value;
+    if (!isOptionLane[lane]) {
+        underlying[lane] = value;
+    }
+    markDirty(lane);
+}
+
+void PortfolioAnalytics::setGreeks(size_t lane, double d, double g, double v, double t, double underlyingPrice) {
+    if (lane >= quantity.size()) {
+        return;
+    }
+    delta[lane] = d;
+    gammaUnit[lane] = g;
+    vegaUnit[lane] = v;
+    thetaUnit[lane] = t;
+    if (underlyingPrice > 0.0) {
+        underlying[lane] = underlyingPrice;
+    }
+    markDirty(lane);
+}
+
+void PortfolioAnalytics::setRiskFactors(const std::string& symbol, double betaValue, const std::string& sector) {
+    Factors& f = factors[symbol];
+    f.beta = betaValue;
+    f.sector = sectorId(sector);
+
+    for (size_t lane = 0; lane < symbolOf.size(); ++lane) {
+        if (symbolOf[lane] == symbol) {
+            beta[lane] = f.beta;
+            sectorOf[lane] = f.sector;
+            markDirty(lane);
+        }
+    }
+    fullRefresh = true;     // lanes may have changed sector
+}
+
+RiskTotals PortfolioAnalytics::laneTotals(size_t lane) const {
+    RiskTotals t;
+    t.marketValue = marketValue[lane];
+    t.grossValue = grossValue[lane];
+    t.deltaDollars = deltaDollars[lane];
+    t.betaDollars = betaDollars[lane];
+    t.unrealizedPnl = unrealized[lane];
+    t.gamma = gamma[lane];
+    t.vega = vega[lane];
+    t.theta = theta[lane];
+    return t;
+}
+
+void PortfolioAnalytics::computeLanes(size_t begin, size_t end) {
+    LaneArrays a = {quantity.data(), multiplier.data(), price.data(), avgCost.data(), delta.data(),
+                    underlying.data(), beta.data(), gammaUnit.data(), vegaUnit.data(), thetaUnit.data(),
+                    marketValue.data(), grossValue.data(), deltaDollars.data(), betaDollars.data(),
+                    unrealized.data(), gamma.data(), vega.data(), theta.data()};
+#ifdef FATTY_X86_KERNELS
+    if (useAvx2) {
+        computeLanesAvx2(a, begin, end);
+        return;
+    }
+#endif
+    computeLanesScalar(a, begin, end);
+}
+
+void PortfolioAnalytics::rebuildGroups() {
+    for (RiskTotals& t : accountTotals) {
+        t = RiskTotals();
+    }
+    for (RiskTotals& t : sectorTotals) {
+        t = RiskTotals();
+    }
+    for (size_t lane = 0; lane < quantity.size(); ++lane) {
+        RiskTotals t = laneTotals(lane);
+        addTotals(accountTotals[accountOf[lane]], t, 1.0);
+        addTotals(sectorTotals[sectorOf[lane]], t, 1.0);
+    }
+}
+
+const PortfolioRisk& PortfolioAnalytics::refresh() {
+    size_t n = quantity.size();
+
+    // Many dirty lanes: one vectorized pass over everything beats a scattered update
+    if (fullRefresh || dirtyLanes.size() * 8 > n) {
+        computeLanes(0, n);
+        rebuildGroups();
+        result.lanesRecomputed = n;
+    } else {
+        for (uint32_t lane : dirtyLanes) {
+            RiskTotals before = laneTotals(lane);
+            computeLanes(lane, lane + 1);
+            RiskTotals after = laneTotals(lane);
+            addTotals(accountTotals[accountOf[lane]], before, -1.0);
+            addTotals(accountTotals[accountOf[lane]], after, 1.0);
+            addTotals(sectorTotals[sectorOf[lane]], before, -1.0);
+            addTotals(sectorTotals[sectorOf[lane]], after, 1.0);
+        }
+        result.lanesRecomputed = dirtyLanes.size();
+    }
+    for (uint32_t lane : dirtyLanes) {
+        dirty[lane] = 0;
+    }
+    dirtyLanes.clear();
+    fullRefresh = false;
+
+    // Portfolio totals are re-summed every time, so they never accumulate drift
+    SumKernel sum = sumScalar;
+#ifdef FATTY_X86_KERNELS
+    if (useAvx2) {
+        sum = sumAvx2;
+    }
+#endif
+    result.total.marketValue = sum(marketValue.data(), n);
+    result.total.grossValue = sum(grossValue.data(), n);
+    result.total.deltaDollars = sum(deltaDollars.data(), n);
+    result.total.betaDollars = sum(betaDollars.data(), n);
+    result.total.unrealizedPnl = sum(unrealized.data(), n);
+    result.total.gamma = sum(gamma.data(), n);
+    result.total.vega = sum(vega.data(), n);
+    result.total.theta = sum(theta.data(), n);
+
+    result.byAccount.resize(accountNames.size());
+    for (size_t i = 0; i < accountNames.size(); ++i) {
+        result.byAccount[i] = {accountNames[i], accountTotals[i]};
+    }
+    result.bySector.resize(sectorNames.size());
+    for (size_t i = 0; i < sectorNames.size(); ++i) {
+        result.bySector[i] = {sectorNames[i], sectorTotals[i]};
+    }
+    result.positions = n;
+    result.vectorized = useAvx2;
+    return result;
+}
+
+void PortfolioAnalytics::clear() {
+    for (std::vector<double>* column : {&quantity, &multiplier, &price, &avgCost, &delta, &underlying, &beta,
+                                        &gammaUnit, &vegaUnit, &thetaUnit, &marketValue, &grossValue,
+                                        &deltaDollars, &betaDollars, &unrealized, &gamma, &vega, &theta}) {
+        column->clear();
+    }
+    accountOf.clear();
+    sectorOf.clear();
+    symbolOf.clear();
+    isOptionLane.clear();
+    dirty.clear();
+    dirtyLanes.clear();
+    accountNames.clear();
+    accountIds.clear();
+    accountTotals.clear();
+    for (RiskTotals& t : sectorTotals) {
+        t = RiskTotals();
+    }
+    fullRefresh = false;
+    result = PortfolioRisk();
+}
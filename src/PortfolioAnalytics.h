@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Aggregated exposure and Greeks for a set of positions.
+struct RiskTotals {
+    double marketValue = 0.0;       // net: sum of quantity * multiplier * price
+    double grossValue = 0.0;        // sum of |market value|
+    double deltaDollars = 0.0;      // delta * underlying price, in currency
+    double betaDollars = 0.0;       // beta-weighted delta dollars
+    double unrealizedPnl = 0.0;
+    double gamma = 0.0;             // in shares of the underlying per 1.0 move
+    double vega = 0.0;
+    double theta = 0.0;
+};
+
+struct PortfolioRisk {
+    RiskTotals total;
+    std::vector<std::pair<std::string, RiskTotals>> byAccount;
+    std::vector<std::pair<std::string, RiskTotals>> bySector;
+    size_t positions = 0;
+    size_t lanesRecomputed = 0;     // lanes refreshed by the refresh that produced this
+    bool vectorized = false;        // AVX2 kernels were used
+};
+
+// Structure-of-arrays risk engine over the connector's positions.
+//
+// Every position is a lane; its inputs (quantity, multiplier, price, Greeks,
+// beta) and derived exposures live in contiguous per-field arrays. Price and
+// Greek updates only store the new input and mark the lane dirty; refresh()
+// recomputes the dirty lanes (one vectorized pass when many are dirty), keeps
+// the account and sector totals up to date from the lanes' old and new values,
+// and reduces the portfolio totals with vector sums. The AVX2 kernels are
+// chosen at runtime and fall back to scalar code on other CPUs.
+// Not thread-safe; the connector guards it with its data mutex.
+class PortfolioAnalytics {
+public:
+    PortfolioAnalytics();
+
+    // Lane numbers are the caller's stable position indices.
+    void setPosition(size_t lane, const std::string& account, const std::string& symbol, bool isOption,
+                     double quantity, double multiplier, double avgCost);
+    void setPrice(size_t lane, double price);
+    // Per-unit option Greeks with the underlying price they were computed at.
+    void setGreeks(size_t lane, double delta, double gamma, double vega, double theta, double underlyingPrice);
+    // Beta against the benchmark and sector label, by underlying symbol; applies
+    // to current and future lanes on that symbol.
+    void setRiskFactors(const std::string& symbol, double beta, const std::string& sector);
+
+    // Recomputes dirty lanes and returns the aggregated risk.
+    const PortfolioRisk& refresh();
+    void clear();
+
+    size_t laneCount() const { return quantity.size(); }
+    static bool avx2Available();
+
+private:
+    struct Factors {
+        double beta = 1.0;
+        uint32_t sector = 0;
+    };
+
+    // Inputs
+    std::vector<double> quantity;
+    std::vector<double> multiplier;
+    std::vector<double> price;
+    std::vector<double> avgCost;
+    std::vector<double> delta;          // per unit; 1 for stocks
+    std::vector<double> underlying;     // underlying price; the price itself for stocks
+    std::vector<double> beta;
+    std::vector<double> gammaUnit;
+    std::vector<double> vegaUnit;
+    std::vector<double> thetaUnit;
+
+    // Outputs, one array per RiskTotals field
+    std::vector<double> marketValue;
+    std::vector<double> grossValue;
+    std::vector<double> deltaDollars;
+    std::vector<double> betaDollars;
+    std::vector<double> unrealized;
+    std::vector<double> gamma;
+    std::vector<double> vega;
+    std::vector<double> theta;
+
+    // Lane bookkeeping
+    std::vector<uint32_t> accountOf;
+    std::vector<uint32_t> sectorOf;
+    std::vector<std::string> symbolOf;
+    std::vector<uint8_t> isOptionLane;
+    std::vector<uint8_t> dirty;
+    std::vector<uint32_t> dirtyLanes;
+    bool fullRefresh;
+
+    std::vector<std::string> accountNames;
+    std::unordered_map<std::string, uint32_t> accountIds;
+    std::vector<std::string> sectorNames;       // 0 = "Unassigned"
+    std::unordered_map<std::string, uint32_t> sectorIds;
+    std::unordered_map<std::string, Factors> factors;
+
+    std::vector<RiskTotals> accountTotals;
+    std::vector<RiskTotals> sectorTotals;
+    PortfolioRisk result;
+    bool useAvx2;
+
+    void ensureLane(size_t lane);
+    void markDirty(size_t lane);
+    uint32_t accountId(const std::string& account);
+    uint32_t sectorId(const std::string& sector);
+    RiskTotals laneTotals(size_t lane) const;
+    void computeLanes(size_t begin, size_t end);
+    void rebuildGroups();
+};
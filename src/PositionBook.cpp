@@ -0,0 +1,217 @@
+#include "PositionBook.h"
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+std::string positionKey(const std::string& account, const Contract& contract) {
+    return account + '|' + std::to_string(contract.conId);
+}
+
+std::string conIdKey(long conId) {
+    return "c:" + std::to_string(conId);
+}
+
+std::string symbolKey(const Contract& contract) {
+    return "s:" + contract.symbol + '|' + (contract.secType.empty() ? std::string("STK") : contract.secType);
+}
+
+// IB reports unset doubles as DBL_MAX
+bool isSet(double value) {
+    return std::isfinite(value) && std::fabs(value) < 1e300;
+}
+}
+
+PositionBook::PositionBook(size_t tickerCapacity)
+    : byTicker(tickerCapacity)
+    , tracked(std::make_unique<std::atomic<bool>[]>(tickerCapacity)) {
+    for (size_t i = 0; i < tickerCapacity; ++i) {
+        tracked[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+size_t PositionBook::update(const std::string& account, const Contract& contract, double position, double avgCost,
+                            bool& created) {
+    std::string key = positionKey(account, contract);
+    auto it = index.find(key);
+    created = it == index.end();
+
+    size_t entry;
+    if (created) {
+        entry = entries.size();
+        index.emplace(std::move(key), entry);
+        entries.emplace_back();
+        links.emplace_back();
+        entries[entry].account = account;
+        entries[entry].contract = contract;
+
+        double multiplier = std::atof(contract.multiplier.c_str());
+        links[entry].multiplier = multiplier > 0.0 ? multiplier : 1.0;
+
+        auto ticker = quoteTickers.find(conIdKey(contract.conId));
+        if (ticker == quoteTickers.end()) {
+            ticker = quoteTickers.find(symbolKey(contract));
+        }
+        if (ticker != quoteTickers.end()) {
+            attach(entry, ticker->second);
+        }
+    } else {
+        entry = it->second;
+    }
+
+    Position& p = entries[entry];
+    p.position = position;
+    p.avgCost = avgCost;
+    links[entry].seenGeneration = syncGeneration;
+    revalue(entry);
+    return entry;
+}
+
+std::vector<size_t> PositionBook::endSync() {
+    std::vector<size_t> closed;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (links[i].seenGeneration != syncGeneration && entries[i].position != 0.0) {
+            entries[i].position = 0.0;
+            entries[i].marketValue = 0.0;
+            setUnrealized(entries[i], 0.0);
+            closed.push_back(i);
+        }
+    }
+    return closed;
+}
+
+void PositionBook::linkQuote(const Contract& contract, long tickerId) {
+    if (tickerId < 0 || static_cast<size_t>(tickerId) >= byTicker.size()) {
+        return;
+    }
+
+    std::string key = contract.conId != 0 ? conIdKey(contract.conId) : symbolKey(contract);
+    quoteTickers[key] = tickerId;
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Contract& held = entries[i].contract;
+        bool matches = contract.conId != 0 ? held.conId == contract.conId : symbolKey(held) == key;
+        if (matches && links[i].tickerId != tickerId) {
+            attach(i, tickerId);
+        }
+    }
+}
+
+void PositionBook::unlinkQuote(long tickerId) {
+    for (auto it = quoteTickers.begin(); it != quoteTickers.end();) {
+        it = it->second == tickerId ? quoteTickers.erase(it) : std::next(it);
+    }
+    if (tickerId >= 0 && static_cast<size_t>(tickerId) < byTicker.size()) {
+        for (uint32_t entry : byTicker[tickerId]) {
+            links[entry].tickerId = -1;
+        }
+        byTicker[tickerId].clear();
+        tracked[tickerId].store(false, std::memory_order_relaxed);
+    }
+}
+
+void PositionBook::attach(size_t entry, long tickerId) {
+    long previous = links[entry].tickerId;
+    if (previous >= 0) {
+        std::vector<uint32_t>& list = byTicker[previous];
+        for (size_t i = 0; i < list.size(); ++i) {
+            if (list[i] == entry) {
+                list[i] = list.back();
+                list.pop_back();
+                break;
+            }
+        }
+        tracked[previous].store(!list.empty(), std::memory_order_relaxed);
+    }
+    links[entry].tickerId = tickerId;
+    byTicker[tickerId].push_back(static_cast<uint32_t>(entry));
+    tracked[tickerId].store(true, std::memory_order_relaxed);
+}
+
+bool PositionBook::mark(long tickerId, double price) {
+    if (!tracksTicker(tickerId) || !(price > 0.0)) {
+        return false;
+    }
+
+    for (uint32_t entry : byTicker[tickerId]) {
+        Position& p = entries[entry];
+        p.marketPrice = price;
+        p.liveMark = true;
+        revalue(entry);
+    }
+    return true;
+}
+
+void PositionBook::revalue(size_t entry) {
+    Position& p = entries[entry];
+    if (!p.liveMark) {
+        return;
+    }
+    p.marketValue = p.position * p.marketPrice * links[entry].multiplier;
+    setUnrealized(p, p.marketValue - p.position * p.avgCost);
+}
+
+void PositionBook::setUnrealized(Position& p, double unrealized) {
+    running.unrealized += unrealized - p.unrealizedPnl;
+    p.unrealizedPnl = unrealized;
+}
+
+void PositionBook::setPnlRequest(size_t entry, int reqId) {
+    links[entry].pnlReqId = reqId;
+    byPnlRequest[reqId] = entry;
+}
+
+bool PositionBook::applyPnlSingle(int reqId, double dailyPnl, double unrealizedPnl, double realizedPnl, double value,
+                                  size_t* entry) {
+    auto it = byPnlRequest.find(reqId);
+    if (it == byPnlRequest.end()) {
+        return false;
+    }
+    if (entry) {
+        *entry = it->second;
+    }
+
+    Position& p = entries[it->second];
+    if (isSet(realizedPnl)) {
+        running.realized += realizedPnl - p.realizedPnl;
+        p.realizedPnl = realizedPnl;
+    }
+    if (isSet(dailyPnl)) {
+        running.daily += dailyPnl - p.dailyPnl;
+        p.dailyPnl = dailyPnl;
+    }
+    // IB's marks only stand in until a live quote is available
+    if (!p.liveMark) {
+        if (isSet(unrealizedPnl)) {
+            setUnrealized(p, unrealizedPnl);
+        }
+        if (isSet(value)) {
+            p.marketValue = value;
+            double units = p.position * links[it->second].multiplier;
+            p.marketPrice = units != 0.0 ? value / units : p.marketPrice;
+        }
+    }
+    return true;
+}
+
+bool PositionBook::getAccountPnl(const std::string& account, PnlTotals& out) const {
+    auto it = accountPnl.find(account);
+    if (it == accountPnl.end()) {
+        return false;
+    }
+    out = it->second;
+    return true;
+}
+
+void PositionBook::clear() {
+    entries.clear();
+    links.clear();
+    index.clear();
+    for (size_t i = 0; i < byTicker.size(); ++i) {
+        byTicker[i].clear();
+        tracked[i].store(false, std::memory_order_relaxed);
+    }
+    quoteTickers.clear();
+    byPnlRequest.clear();
+    accountPnl.clear();
+    running = PnlTotals();
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Contract.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One (account, contract) holding with its marks and P&L.
+struct Position {
+    std::string account;
+    Contract contract;
+    double position = 0.0;
+    double avgCost = 0.0;           // per unit, multiplier included (as IB reports it)
+    double marketPrice = 0.0;       // last mark, 0 until a quote or P&L update arrives
+    double marketValue = 0.0;
+    double unrealizedPnl = 0.0;
+    double realizedPnl = 0.0;       // from reqPnLSingle
+    double dailyPnl = 0.0;          // from reqPnLSingle
+    bool liveMark = false;          // marked from the quote store rather than IB's P&L stream
+};
+
+struct PnlTotals {
+    double unrealized = 0.0;
+    double realized = 0.0;
+    double daily = 0.0;
+};
+
+// Positions keyed by (account, conId), updated in place.
+//
+// Each position is linked to the QuoteStore ticker of its contract. A price
+// tick re-marks only the positions on that ticker and applies the change in
+// their unrealized P&L to the running totals, so a tick costs O(positions on
+// the ticker) and the totals never need a rescan. Realized and daily P&L come
+// from IB's reqPnLSingle stream, whose unrealized figure is used until a live
+// quote exists. Not thread-safe apart from tracksTicker(); the connector guards
+// it with its data mutex.
+class PositionBook {
+public:
+    explicit PositionBook(size_t tickerCapacity);
+
+    // Inserts or updates; returns the position's index and sets created for new ones.
+    size_t update(const std::string& account, const Contract& contract, double position, double avgCost, bool& created);
+
+    // Associates a market data ticker with a contract (by conId, else symbol),
+    // including positions that arrive later.
+    void linkQuote(const Contract& contract, long tickerId);
+    void unlinkQuote(long tickerId);
+    // Lock-free, so the tick path can skip tickers without positions cheaply
+    bool tracksTicker(long tickerId) const {
+        return tickerId >= 0 && static_cast<size_t>(tickerId) < byTicker.size() &&
+               tracked[tickerId].load(std::memory_order_relaxed);
+    }
+    // Re-marks every position on the ticker. Returns true if any P&L changed.
+    bool mark(long tickerId, double price);
+    // Indices of the positions marked by the ticker (see tracksTicker()).
+    const std::vector<uint32_t>& entriesOnTicker(long tickerId) const { return byTicker[tickerId]; }
+
+    void setPnlRequest(size_t index, int reqId);
+    // pnlSingle update for the position subscribed under reqId; false for unknown ids.
+    // Stores the position's index in entry when given.
+    bool applyPnlSingle(int reqId, double dailyPnl, double unrealizedPnl, double realizedPnl, double value,
+                        size_t* entry = nullptr);
+    // Account level reqPnL figures, as reported by IB.
+    void setAccountPnl(const std::string& account, const PnlTotals& pnl) { accountPnl[account] = pnl; }
+    bool getAccountPnl(const std::string& account, PnlTotals& out) const;
+
+    // Reconciliation after a reconnect: positions not reported between
+    // beginSync() and endSync() were closed meanwhile and are set to zero.
+    // endSync() returns their indices.
+    void beginSync() { ++syncGeneration; }
+    std::vector<size_t> endSync();
+
+    template <typename Fn>
+    void forEachPnlRequest(Fn&& fn) const {
+        for (const auto& request : byPnlRequest) {
+            fn(request.first, entries[request.second]);
+        }
+    }
+
+    const std::vector<Position>& positions() const { return entries; }
+    const PnlTotals& totals() const { return running; }
+    void clear();
+
+private:
+    struct Link {
+        long tickerId = -1;
+        int pnlReqId = 0;
+        double multiplier = 1.0;
+        uint32_t seenGeneration = 0;
+    };
+
+    std::vector<Position> entries;
+    std::vector<Link> links;                                // parallel to entries
+    std::unordered_map<std::string, size_t> index;          // account|conId -> entry
+    std::vector<std::vector<uint32_t>> byTicker;            // tickerId -> entries marked by it
+    std::unique_ptr<std::atomic<bool>[]> tracked;           // byTicker[tickerId] is non-empty
+    std::unordered_map<std::string, long> quoteTickers;     // conId or symbol -> tickerId
+    std::unordered_map<int, size_t> byPnlRequest;
+    std::unordered_map<std::string, PnlTotals> accountPnl;
+    PnlTotals running;
+    uint32_t syncGeneration = 0;
+
+    void attach(size_t entry, long tickerId);
+    void setUnrealized(Position& p, double unrealized);
+    void revalue(size_t entry);
+};
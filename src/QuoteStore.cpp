@@ -0,0 +1,160 @@
+#include "QuoteStore.h"
+#include "ThreadTuning.h"
+
+namespace {
+// IB tick types we keep on the book (live and delayed variants)
+enum : int {
+    FIELD_BID_SIZE = 0,
+    FIELD_BID = 1,
+    FIELD_ASK = 2,
+    FIELD_ASK_SIZE = 3,
+    FIELD_LAST = 4,
+    FIELD_LAST_SIZE = 5,
+    FIELD_DELAYED_BID = 66,
+    FIELD_DELAYED_ASK = 67,
+    FIELD_DELAYED_LAST = 68,
+    FIELD_DELAYED_BID_SIZE = 69,
+    FIELD_DELAYED_ASK_SIZE = 70,
+    FIELD_DELAYED_LAST_SIZE = 71
+};
+}
+
+QuoteStore::QuoteStore(size_t capacity)
+    : slotCount(capacity)
+    , slots(std::make_unique<Slot[]>(capacity)) {
+}
+
+void QuoteStore::beginWrite(Slot& slot) {
+    uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void QuoteStore::endWrite(Slot& slot) {
+    uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_release);
+}
+
+bool QuoteStore::updatePrice(long tickerId, int field, double price, int64_t timestampNs) {
+    if (!inRange(tickerId)) {
+        return false;
+    }
+
+    Slot& slot = slots[tickerId];
+    switch (field) {
+    case FIELD_BID:
+    case FIELD_DELAYED_BID:
+        beginWrite(slot);
+        slot.bid.store(price, std::memory_order_relaxed);
+        slot.bidTimeNs.store(timestampNs, std::memory_order_relaxed);
+        endWrite(slot);
+        return true;
+    case FIELD_ASK:
+    case FIELD_DELAYED_ASK:
+        beginWrite(slot);
+        slot.ask.store(price, std::memory_order_relaxed);
+        slot.askTimeNs.store(timestampNs, std::memory_order_relaxed);
+        endWrite(slot);
+        return true;
+    case FIELD_LAST:
+    case FIELD_DELAYED_LAST:
+        beginWrite(slot);
+        slot.last.store(price, std::memory_order_relaxed);
+        slot.lastTimeNs.store(timestampNs, std::memory_order_relaxed);
+        endWrite(slot);
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool QuoteStore::updateSize(long tickerId, int field, int size, int64_t timestampNs) {
+    if (!inRange(tickerId)) {
+        return false;
+    }
+
+    Slot& slot = slots[tickerId];
+    switch (field) {
+    case FIELD_BID_SIZE:
+    case FIELD_DELAYED_BID_SIZE:
+        beginWrite(slot);
+        slot.bidSize.store(size, std::memory_order_relaxed);
+        slot.bidTimeNs.store(timestampNs, std::memory_order_relaxed);
+        endWrite(slot);
+        return true;
+    case FIELD_ASK_SIZE:
+    case FIELD_DELAYED_ASK_SIZE:
+        beginWrite(slot);
+        slot.askSize.store(size, std::memory_order_relaxed);
+        slot.askTimeNs.store(timestampNs, std::memory_order_relaxed);
+        endWrite(slot);
+        return true;
+    case FIELD_LAST_SIZE:
+    case FIELD_DELAYED_LAST_SIZE:
+        beginWrite(slot);
+        slot.lastSize.store(size, std::memory_order_relaxed);
+        slot.lastTimeNs.store(timestampNs, std::memory_order_relaxed);
+        endWrite(slot);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void QuoteStore::clear() {
+    for (size_t i = 0; i < slotCount; ++i) {
+        Slot& slot = slots[i];
+        if (slot.seq.load(std::memory_order_relaxed) == slot.clearSeq.load(std::memory_order_relaxed)) {
+            continue;
+        }
+
+        beginWrite(slot);
+        slot.bid.store(0.0, std::memory_order_relaxed);
+        slot.ask.store(0.0, std::memory_order_relaxed);
+        slot.last.store(0.0, std::memory_order_relaxed);
+        slot.bidSize.store(0, std::memory_order_relaxed);
+        slot.askSize.store(0, std::memory_order_relaxed);
+        slot.lastSize.store(0, std::memory_order_relaxed);
+        slot.bidTimeNs.store(0, std::memory_order_relaxed);
+        slot.askTimeNs.store(0, std::memory_order_relaxed);
+        slot.lastTimeNs.store(0, std::memory_order_relaxed);
+        // Sequences count from here, so a cleared slot reads as "no data yet"
+        // while seq itself keeps growing
+        slot.clearSeq.store(slot.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        endWrite(slot);
+    }
+}
+
+Quote QuoteStore::get(long tickerId) const {
+    Quote quote;
+    if (!inRange(tickerId)) {
+        return quote;
+    }
+
+    const Slot& slot = slots[tickerId];
+    for (;;) {
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            cpuRelax();
+            continue;
+        }
+
+        quote.bid = slot.bid.load(std::memory_order_relaxed);
+        quote.ask = slot.ask.load(std::memory_order_relaxed);
+        quote.last = slot.last.load(std::memory_order_relaxed);
+        quote.bidSize = slot.bidSize.load(std::memory_order_relaxed);
+        quote.askSize = slot.askSize.load(std::memory_order_relaxed);
+        quote.lastSize = slot.lastSize.load(std::memory_order_relaxed);
+        quote.bidTimeNs = slot.bidTimeNs.load(std::memory_order_relaxed);
+        quote.askTimeNs = slot.askTimeNs.load(std::memory_order_relaxed);
+        quote.lastTimeNs = slot.lastTimeNs.load(std::memory_order_relaxed);
+
+        uint64_t clearedAt = slot.clearSeq.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == before) {
+            quote.sequence = (before - clearedAt) / 2;
+            return quote;
+        }
+    }
+}
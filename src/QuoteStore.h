@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Top-of-book snapshot for a single ticker, returned by value to readers.
+// sequence counts the updates applied to the ticker since the store was last
+// cleared; 0 means no data yet.
+struct Quote {
+    double bid = 0.0;
+    double ask = 0.0;
+    double last = 0.0;
+    int bidSize = 0;
+    int askSize = 0;
+    int lastSize = 0;
+    int64_t bidTimeNs = 0;   // system_clock nanoseconds of the last bid update
+    int64_t askTimeNs = 0;
+    int64_t lastTimeNs = 0;
+    uint64_t sequence = 0;
+
+    bool valid() const { return sequence != 0; }
+};
+
+// Flat quote table indexed directly by tickerId.
+//
+// Every slot is a seqlock: the single writer (the message processing thread)
+// bumps the slot sequence to odd, stores the fields and bumps it back to even.
+// Readers copy the fields and retry only if the sequence moved underneath them,
+// so they never block the writer and the tick path never allocates or locks.
+class QuoteStore {
+public:
+    explicit QuoteStore(size_t capacity = 8192);
+
+    QuoteStore(const QuoteStore&) = delete;
+    QuoteStore& operator=(const QuoteStore&) = delete;
+
+    size_t capacity() const { return slotCount; }
+    bool inRange(long tickerId) const { return tickerId >= 0 && static_cast<size_t>(tickerId) < slotCount; }
+
+    // Writer side - must only be called from one thread at a time.
+    // Return false when the tickerId or tick field is not tracked.
+    bool updatePrice(long tickerId, int field, double price, int64_t timestampNs);
+    bool updateSize(long tickerId, int field, int size, int64_t timestampNs);
+    void clear();
+
+    // Reader side - safe from any thread.
+    Quote get(long tickerId) const;
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> seq{0};               // only ever grows, so a reader can't see it come back
+        std::atomic<uint64_t> clearSeq{0};          // seq when the slot was last cleared
+        std::atomic<double> bid{0.0};
+        std::atomic<double> ask{0.0};
+        std::atomic<double> last{0.0};
+        std::atomic<int> bidSize{0};
+        std::atomic<int> askSize{0};
+        std::atomic<int> lastSize{0};
+        std::atomic<int64_t> bidTimeNs{0};
+        std::atomic<int64_t> askTimeNs{0};
+        std::atomic<int64_t> lastTimeNs{0};
+    };
+
+    size_t slotCount;
+    std::unique_ptr<Slot[]> slots;
+
+    static void beginWrite(Slot& slot);
+    static void endWrite(Slot& slot);
+};
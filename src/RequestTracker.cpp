@@ -0,0 +1,128 @@
+#include "RequestTracker.h"
+#include <limits>
+
+namespace {
+const int64_t kNoDeadline = std::numeric_limits<int64_t>::max();
+}
+
+const char* requestStatusName(RequestStatus status) {
+    switch (status) {
+    case RequestStatus::Complete: return "Complete";
+    case RequestStatus::Failed: return "Failed";
+    case RequestStatus::TimedOut: return "TimedOut";
+    case RequestStatus::Disconnected: return "Disconnected";
+    case RequestStatus::NotConnected: return "NotConnected";
+    default: return "Unknown";
+    }
+}
+
+RequestTracker::RequestTracker()
+    : nextDeadline(kNoDeadline) {
+}
+
+RequestFuture RequestTracker::add(int reqId, RequestKind kind, int64_t deadlineNs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Pending& entry = pending[reqId];
+    entry.kind = kind;
+    entry.deadlineNs = deadlineNs;
+    entry.promise = std::promise<RequestResult>();
+    if (deadlineNs < nextDeadline.load(std::memory_order_relaxed)) {
+        nextDeadline.store(deadlineNs, std::memory_order_relaxed);
+    }
+    return entry.promise.get_future().share();
+}
+
+bool RequestTracker::complete(int reqId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pending.find(reqId);
+    if (it == pending.end()) {
+        return false;
+    }
+    it->second.promise.set_value(RequestResult());
+    pending.erase(it);
+    updateNextDeadline();
+    return true;
+}
+
+size_t RequestTracker::complete(RequestKind kind) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (it->second.kind == kind) {
+            it->second.promise.set_value(RequestResult());
+            it = pending.erase(it);
+            ++count;
+        } else {
+            ++it;
+        }
+    }
+    updateNextDeadline();
+    return count;
+}
+
+bool RequestTracker::fail(int reqId, int errorCode, const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pending.find(reqId);
+    if (it == pending.end()) {
+        return false;
+    }
+    RequestResult result;
+    result.status = RequestStatus::Failed;
+    result.errorCode = errorCode;
+    result.errorMessage = message;
+    it->second.promise.set_value(result);
+    pending.erase(it);
+    updateNextDeadline();
+    return true;
+}
+
+size_t RequestTracker::expire(int64_t nowNs) {
+    if (nowNs < nextDeadline.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (it->second.deadlineNs <= nowNs) {
+            RequestResult result;
+            result.status = RequestStatus::TimedOut;
+            it->second.promise.set_value(result);
+            it = pending.erase(it);
+            ++count;
+        } else {
+            ++it;
+        }
+    }
+    updateNextDeadline();
+    return count;
+}
+
+void RequestTracker::failAll(RequestStatus status) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : pending) {
+        RequestResult result;
+        result.status = status;
+        entry.second.promise.set_value(result);
+    }
+    pending.clear();
+    nextDeadline.store(kNoDeadline, std::memory_order_relaxed);
+}
+
+RequestFuture RequestTracker::settled(RequestStatus status) {
+    std::promise<RequestResult> promise;
+    RequestResult result;
+    result.status = status;
+    promise.set_value(result);
+    return promise.get_future().share();
+}
+
+void RequestTracker::updateNextDeadline() {
+    int64_t earliest = kNoDeadline;
+    for (const auto& entry : pending) {
+        if (entry.second.deadlineNs < earliest) {
+            earliest = entry.second.deadlineNs;
+        }
+    }
+    nextDeadline.store(earliest, std::memory_order_relaxed);
+}
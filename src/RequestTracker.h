@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+enum class RequestStatus {
+    Complete,
+    Failed,             // the gateway answered with an error for the request id
+    TimedOut,
+    Disconnected,       // the connection went away before the request completed
+    NotConnected
+};
+
+const char* requestStatusName(RequestStatus status);
+
+struct RequestResult {
+    RequestStatus status = RequestStatus::Complete;
+    int errorCode = 0;
+    std::string errorMessage;
+
+    bool ok() const { return status == RequestStatus::Complete; }
+};
+
+using RequestFuture = std::shared_future<RequestResult>;
+
+// The end callback that completes a request
+enum class RequestKind {
+    AccountSummary,     // accountSummaryEnd(reqId)
+    Positions,          // positionEnd(), no id
+    OpenOrders,         // openOrderEnd(), no id
+    ContractDetails,    // contractDetailsEnd(reqId)
+    HistoricalData,     // historicalDataEnd(reqId)
+    Executions          // execDetailsEnd(reqId)
+};
+
+// Outstanding request/response calls and the promises behind their futures.
+//
+// Requests are keyed by reqId; kinds whose end callback carries no id complete
+// every outstanding request of that kind. Deadlines are enforced by the message
+// processing thread calling expire(), which is one relaxed load while nothing is due.
+class RequestTracker {
+public:
+    RequestTracker();
+
+    RequestTracker(const RequestTracker&) = delete;
+    RequestTracker& operator=(const RequestTracker&) = delete;
+
+    RequestFuture add(int reqId, RequestKind kind, int64_t deadlineNs);
+
+    bool complete(int reqId);
+    size_t complete(RequestKind kind);
+    bool fail(int reqId, int errorCode, const std::string& message);
+    size_t expire(int64_t nowNs);
+    // Settles everything still outstanding with the given status.
+    void failAll(RequestStatus status);
+
+    // Earliest deadline of any outstanding request, INT64_MAX when there is none.
+    int64_t nextDeadlineNs() const { return nextDeadline.load(std::memory_order_relaxed); }
+
+    // An already settled future, for requests that could not be sent.
+    static RequestFuture settled(RequestStatus status);
+
+private:
+    struct Pending {
+        RequestKind kind;
+        int64_t deadlineNs;
+        std::promise<RequestResult> promise;
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<int, Pending> pending;
+    std::atomic<int64_t> nextDeadline;
+
+    void updateNextDeadline();
+};
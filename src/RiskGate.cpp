@@ -0,0 +1,299 @@
+#include "RiskGate.h"
+#include "Clock.h"
+#include "Logger.h"
+#include <cmath>
+
+namespace {
+// Slot namespaces within the shared table
+const char kPositionKey = 'P';
+const char kAccountKey = 'A';
+const char kSymbolKey = 'S';
+
+uint64_t hashKey(char kind, const std::string& a, const std::string& b = std::string()) {
+    // FNV-1a over kind, a, separator, b
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](unsigned char c) {
+        h ^= c;
+        h *= 1099511628211ull;
+    };
+    mix(static_cast<unsigned char>(kind));
+    for (char c : a) {
+        mix(static_cast<unsigned char>(c));
+    }
+    mix(0);
+    for (char c : b) {
+        mix(static_cast<unsigned char>(c));
+    }
+    return h == 0 ? 1 : h;    // 0 marks an empty slot
+}
+
+size_t roundUpPow2(size_t n) {
+    size_t p = 64;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+bool hasLimitPrice(const Order& order) {
+    return order.lmtPrice > 0.0 && order.lmtPrice < 1e300;     // unset is DBL_MAX
+}
+}
+
+const char* orderRejectName(OrderReject reject) {
+    switch (reject) {
+    case OrderReject::None: return "None";
+    case OrderReject::NotConnected: return "NotConnected";
+    case OrderReject::InvalidOrder: return "InvalidOrder";
+    case OrderReject::NoAccount: return "NoAccount";
+    case OrderReject::MaxOrderSize: return "MaxOrderSize";
+    case OrderReject::MaxNotional: return "MaxNotional";
+    case OrderReject::PriceCollar: return "PriceCollar";
+    case OrderReject::NoReferencePrice: return "NoReferencePrice";
+    case OrderReject::RateLimited: return "RateLimited";
+    case OrderReject::OpenOrderLimit: return "OpenOrderLimit";
+    case OrderReject::SymbolPositionLimit: return "SymbolPositionLimit";
+    case OrderReject::AccountPositionLimit: return "AccountPositionLimit";
+    case OrderReject::RiskCapacity: return "RiskCapacity";
+    case OrderReject::OrderEnded: return "OrderEnded";
+    case OrderReject::QueueFull: return "QueueFull";
+    default: return "Unknown";
+    }
+}
+
+RiskGate::RiskGate(const RiskLimits& limits, const QuoteStore& quotes, size_t capacity)
+    : limits(limits)
+    , quotes(quotes)
+    , slotMask(roundUpPow2(capacity) - 1)
+    , slots(std::make_unique<Slot[]>(slotMask + 1))
+    , openOrderCount(0)
+    , rateTatNs(0)
+    , rateIntervalNs(limits.maxOrdersPerSecond > 0 ? static_cast<int64_t>(1e9 / limits.maxOrdersPerSecond) : 0)
+    , rateToleranceNs(rateIntervalNs * (limits.orderBurst > 1 ? limits.orderBurst - 1 : 0)) {
+}
+
+int64_t RiskGate::toFixed(double quantity) {
+    return static_cast<int64_t>(std::llround(quantity * kQuantityScale));
+}
+
+RiskGate::Slot* RiskGate::findSlot(uint64_t key, bool create) {
+    size_t index = key & slotMask;
+    for (size_t probes = 0; probes <= slotMask; ++probes, index = (index + 1) & slotMask) {
+        Slot& slot = slots[index];
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+        if (current == key) {
+            return &slot;
+        }
+        if (current == 0) {
+            if (!create) {
+                return nullptr;
+            }
+            // Claim the empty slot; if another thread won it, it may have claimed it for our key
+            if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel) || current == key) {
+                return &slot;
+            }
+        }
+    }
+    return nullptr;
+}
+
+RiskGate::Slot* RiskGate::positionSlot(const std::string& account, const std::string& symbol, bool create) {
+    return findSlot(hashKey(kPositionKey, account, symbol), create);
+}
+
+RiskGate::Slot* RiskGate::accountSlot(const std::string& account, bool create) {
+    return findSlot(hashKey(kAccountKey, account), create);
+}
+
+void RiskGate::registerQuote(const std::string& symbol, long tickerId) {
+    Slot* slot = findSlot(hashKey(kSymbolKey, symbol), true);
+    if (slot) {
+        slot->quoteTicker.store(tickerId, std::memory_order_release);
+    }
+}
+
+double RiskGate::referencePrice(const std::string& symbol) {
+    Slot* slot = findSlot(hashKey(kSymbolKey, symbol), false);
+    long tickerId = slot ? slot->quoteTicker.load(std::memory_order_acquire) : -1;
+    if (tickerId < 0) {
+        return 0.0;
+    }
+
+    Quote quote = quotes.get(tickerId);
+    if (quote.last > 0.0) {
+        return quote.last;
+    }
+    if (quote.bid > 0.0 && quote.ask > 0.0) {
+        return (quote.bid + quote.ask) / 2.0;
+    }
+    return 0.0;
+}
+
+bool RiskGate::takeRateToken(int64_t nowNs) {
+    int64_t tat = rateTatNs.load(std::memory_order_relaxed);
+    for (;;) {
+        int64_t start = tat > nowNs ? tat : nowNs;
+        if (start - nowNs > rateToleranceNs) {
+            return false;
+        }
+        if (rateTatNs.compare_exchange_weak(tat, start + rateIntervalNs, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+OrderReject RiskGate::check(const std::string& account, const Contract& contract, const Order& order,
+                            double heldQuantity, bool holdsSlot) {
+    if (!limits.enabled) {
+        return OrderReject::None;
+    }
+
+    bool buy = order.action == "BUY";
+    if (!buy && order.action != "SELL" && order.action != "SSHORT") {
+        return OrderReject::InvalidOrder;
+    }
+    double quantity = order.totalQuantity;
+    if (!(quantity > 0.0)) {
+        return OrderReject::InvalidOrder;
+    }
+    if (limits.maxOrderQuantity > 0 && quantity > limits.maxOrderQuantity) {
+        return OrderReject::MaxOrderSize;
+    }
+
+    // Stateless price checks
+    double reference = referencePrice(contract.symbol);
+    if (reference <= 0.0 && limits.requireQuote) {
+        return OrderReject::NoReferencePrice;
+    }
+    bool limit = hasLimitPrice(order);
+    double price = limit ? order.lmtPrice : reference;
+    if (limits.maxOrderNotional > 0 && price > 0.0 && quantity * price > limits.maxOrderNotional) {
+        return OrderReject::MaxNotional;
+    }
+    if (limit && reference > 0.0 && limits.priceCollarPercent > 0) {
+        double band = reference * limits.priceCollarPercent / 100.0;
+        if ((buy && order.lmtPrice > reference + band) || (!buy && order.lmtPrice < reference - band)) {
+            return OrderReject::PriceCollar;
+        }
+    }
+
+    // Reservations: add first, then verify, and roll back on failure. A
+    // modify reserves only the change in quantity, which may be negative, and
+    // keeps the order's open-order slot.
+    int slot = holdsSlot ? 0 : 1;
+    int open = openOrderCount.fetch_add(slot, std::memory_order_relaxed) + slot;
+    if (slot > 0 && limits.maxOpenOrders > 0 && open > limits.maxOpenOrders) {
+        openOrderCount.fetch_sub(slot, std::memory_order_relaxed);
+        return OrderReject::OpenOrderLimit;
+    }
+
+    Slot* position = positionSlot(account, contract.symbol, true);
+    Slot* total = accountSlot(account, true);
+    if (!position || !total) {
+        openOrderCount.fetch_sub(slot, std::memory_order_relaxed);
+        LOG_ERROR("Risk gate slot table full - increase its capacity");
+        return OrderReject::RiskCapacity;
+    }
+
+    int64_t q = toFixed(quantity - heldQuantity);
+    std::atomic<int64_t>& pending = buy ? position->pendingBuy : position->pendingSell;
+    int64_t pendingNow = pending.fetch_add(q, std::memory_order_relaxed) + q;
+    int64_t net = position->position.load(std::memory_order_relaxed);
+    int64_t worstCase = buy ? net + pendingNow : pendingNow - net;
+    if (q > 0 && limits.maxSymbolPosition > 0 && worstCase > toFixed(limits.maxSymbolPosition)) {
+        pending.fetch_sub(q, std::memory_order_relaxed);
+        openOrderCount.fetch_sub(slot, std::memory_order_relaxed);
+        return OrderReject::SymbolPositionLimit;
+    }
+
+    int64_t gross = total->gross.fetch_add(q, std::memory_order_relaxed) + q;
+    if (q > 0 && limits.maxAccountPosition > 0 && gross > toFixed(limits.maxAccountPosition)) {
+        total->gross.fetch_sub(q, std::memory_order_relaxed);
+        pending.fetch_sub(q, std::memory_order_relaxed);
+        openOrderCount.fetch_sub(slot, std::memory_order_relaxed);
+        return OrderReject::AccountPositionLimit;
+    }
+
+    // Last, so orders rejected above do not use up the rate for the ones that pass
+    if (rateIntervalNs > 0 && !takeRateToken(monotonicNanos())) {
+        total->gross.fetch_sub(q, std::memory_order_relaxed);
+        pending.fetch_sub(q, std::memory_order_relaxed);
+        openOrderCount.fetch_sub(slot, std::memory_order_relaxed);
+        return OrderReject::RateLimited;
+    }
+
+    return OrderReject::None;
+}
+
+void RiskGate::undoCheck(const std::string& account, const std::string& symbol, const Order& order,
+                         double heldQuantity, bool holdsSlot) {
+    if (!limits.enabled) {
+        return;
+    }
+    if (!holdsSlot) {
+        openOrderCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    Slot* position = positionSlot(account, symbol, false);
+    Slot* total = accountSlot(account, false);
+    if (!position || !total) {
+        return;
+    }
+
+    int64_t q = toFixed(order.totalQuantity - heldQuantity);
+    (order.action == "BUY" ? position->pendingBuy : position->pendingSell).fetch_sub(q, std::memory_order_relaxed);
+    total->gross.fetch_sub(q, std::memory_order_relaxed);
+}
+
+void RiskGate::onFill(const std::string& account, const std::string& symbol, bool buy, double quantity) {
+    Slot* position = positionSlot(account, symbol, true);
+    Slot* total = accountSlot(account, true);
+    if (!position || !total) {
+        return;
+    }
+
+    int64_t q = toFixed(quantity);
+    (buy ? position->pendingBuy : position->pendingSell).fetch_sub(q, std::memory_order_relaxed);
+    int64_t before = position->position.fetch_add(buy ? q : -q, std::memory_order_relaxed);
+    int64_t after = before + (buy ? q : -q);
+    // Pending turns into position: gross moves by the change in |position| minus the released quantity
+    total->gross.fetch_add(std::llabs(after) - std::llabs(before) - q, std::memory_order_relaxed);
+}
+
+void RiskGate::onOrderClosed(const std::string& account, const std::string& symbol, bool buy, double unfilledQuantity) {
+    openOrderCount.fetch_sub(1, std::memory_order_relaxed);
+
+    Slot* position = positionSlot(account, symbol, false);
+    Slot* total = accountSlot(account, false);
+    if (!position || !total || unfilledQuantity <= 0.0) {
+        return;
+    }
+
+    int64_t q = toFixed(unfilledQuantity);
+    (buy ? position->pendingBuy : position->pendingSell).fetch_sub(q, std::memory_order_relaxed);
+    total->gross.fetch_sub(q, std::memory_order_relaxed);
+}
+
+void RiskGate::setPosition(const std::string& account, const std::string& symbol, double quantity) {
+    Slot* position = positionSlot(account, symbol, true);
+    Slot* total = accountSlot(account, true);
+    if (!position || !total) {
+        return;
+    }
+
+    int64_t after = toFixed(quantity);
+    int64_t before = position->position.exchange(after, std::memory_order_relaxed);
+    total->gross.fetch_add(std::llabs(after) - std::llabs(before), std::memory_order_relaxed);
+}
+
+void RiskGate::reset() {
+    for (size_t i = 0; i <= slotMask; ++i) {
+        Slot& slot = slots[i];
+        slot.position.store(0, std::memory_order_relaxed);
+        slot.pendingBuy.store(0, std::memory_order_relaxed);
+        slot.pendingSell.store(0, std::memory_order_relaxed);
+        slot.gross.store(0, std::memory_order_relaxed);
+    }
+    openOrderCount.store(0, std::memory_order_relaxed);
+    rateTatNs.store(0, std::memory_order_relaxed);
+}
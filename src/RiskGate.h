@@ -0,0 +1,104 @@
+#pragma once
+
+#include "QuoteStore.h"
+#include "Settings.h"
+#include "Contract.h"
+#include "Order.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Synchronous result of IBConnector::placeOrder.
+enum class OrderReject {
+    None,
+    NotConnected,
+    InvalidOrder,           // non-positive quantity, unknown action
+    NoAccount,              // no order.account and not exactly one managed account
+    MaxOrderSize,
+    MaxNotional,
+    PriceCollar,            // limit price too aggressive against the reference price
+    NoReferencePrice,       // require_quote is set and the symbol has no quote
+    RateLimited,
+    OpenOrderLimit,
+    SymbolPositionLimit,
+    AccountPositionLimit,
+    RiskCapacity,           // too many distinct symbols/accounts, or open orders, to track
+    OrderEnded,             // the orderId belongs to an order that was filled, cancelled or rejected
+    QueueFull               // passed the checks, but the outbound command queue was full
+};
+
+const char* orderRejectName(OrderReject reject);
+
+// Pre-trade checks in front of placeOrder.
+//
+// All state is kept in pre-computed atomic counters: one slot per account,
+// per account+symbol and per symbol, found through a lock-free open-addressing
+// table keyed by a 64-bit hash. Limits that accumulate (positions, open orders)
+// are reserved with fetch_add first and rolled back if the result is over the
+// limit, so concurrent callers can never jointly overshoot. The rate limit is a
+// single-CAS GCRA token bucket and the collar reads the seqlocked QuoteStore.
+class RiskGate {
+public:
+    RiskGate(const RiskLimits& limits, const QuoteStore& quotes, size_t capacity = 4096);
+
+    RiskGate(const RiskGate&) = delete;
+    RiskGate& operator=(const RiskGate&) = delete;
+
+    bool enabled() const { return limits.enabled; }
+
+    // Associates a symbol with the tickerId its quotes are stored under.
+    void registerQuote(const std::string& symbol, long tickerId);
+
+    // Runs every check and, on success, reserves the order's quantity against
+    // the position limits and one open-order slot. Safe from any thread.
+    // For a modify of an order that already holds heldQuantity (and, with
+    // holdsSlot, an open-order slot) only the difference is reserved, or
+    // released when the order shrinks.
+    OrderReject check(const std::string& account, const Contract& contract, const Order& order,
+                      double heldQuantity = 0.0, bool holdsSlot = false);
+    // Takes back what a successful check() reserved, for an order that was not sent.
+    void undoCheck(const std::string& account, const std::string& symbol, const Order& order,
+                   double heldQuantity = 0.0, bool holdsSlot = false);
+
+    // Order lifecycle feedback for orders that passed check() (processing thread).
+    void onFill(const std::string& account, const std::string& symbol, bool buy, double quantity);
+    void onOrderClosed(const std::string& account, const std::string& symbol, bool buy, double unfilledQuantity);
+    // Authoritative position from the position() callback.
+    void setPosition(const std::string& account, const std::string& symbol, double position);
+    void reset();
+
+    int openOrders() const { return openOrderCount.load(std::memory_order_relaxed); }
+
+private:
+    // Quantities are fixed point so they can live in atomic integers
+    static constexpr int64_t kQuantityScale = 10000;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> key{0};
+        std::atomic<int64_t> position{0};       // account+symbol: net filled position
+        std::atomic<int64_t> pendingBuy{0};     // account+symbol: open buy quantity
+        std::atomic<int64_t> pendingSell{0};    // account+symbol: open sell quantity
+        std::atomic<int64_t> gross{0};          // account: sum of |position| + pending over its symbols
+        std::atomic<long> quoteTicker{-1};      // symbol: QuoteStore tickerId
+    };
+
+    RiskLimits limits;
+    const QuoteStore& quotes;
+    size_t slotMask;
+    std::unique_ptr<Slot[]> slots;
+
+    std::atomic<int> openOrderCount;
+    std::atomic<int64_t> rateTatNs;             // GCRA theoretical arrival time
+    int64_t rateIntervalNs;
+    int64_t rateToleranceNs;
+
+    Slot* findSlot(uint64_t key, bool create);
+    Slot* positionSlot(const std::string& account, const std::string& symbol, bool create);
+    Slot* accountSlot(const std::string& account, bool create);
+    double referencePrice(const std::string& symbol);
+    bool takeRateToken(int64_t nowNs);
+
+    static int64_t toFixed(double quantity);
+};
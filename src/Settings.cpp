@@ -0,0 +1,333 @@
+#include "Settings.h"
+#include "Logger.h"
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+namespace {
+// Just enough JSON for settings.json: objects, arrays, strings, numbers, bools, null.
+struct JsonValue {
+    enum Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::map<std::string, JsonValue> object;
+
+    const JsonValue* find(const std::string& key) const {
+        if (type != Object) {
+            return nullptr;
+        }
+        auto it = object.find(key);
+        return it == object.end() ? nullptr : &it->second;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text(text), pos(0) {}
+
+    bool parse(JsonValue& out, std::string& error) {
+        if (!parseValue(out) || (skipWhitespace(), pos != text.size())) {
+            error = "invalid JSON near offset " + std::to_string(pos);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    const std::string& text;
+    size_t pos;
+
+    void skipWhitespace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            ++pos;
+        }
+    }
+
+    bool consume(char c) {
+        skipWhitespace();
+        if (pos < text.size() && text[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseLiteral(const char* literal) {
+        size_t len = std::char_traits<char>::length(literal);
+        if (text.compare(pos, len, literal) != 0) {
+            return false;
+        }
+        pos += len;
+        return true;
+    }
+
+    bool parseValue(JsonValue& out) {
+        skipWhitespace();
+        if (pos >= text.size()) {
+            return false;
+        }
+
+        char c = text[pos];
+        if (c == '{') {
+            return parseObject(out);
+        }
+        if (c == '[') {
+            return parseArray(out);
+        }
+        if (c == '"') {
+            out.type = JsonValue::String;
+            return parseString(out.string);
+        }
+        if (c == 't' || c == 'f') {
+            out.type = JsonValue::Bool;
+            out.boolean = (c == 't');
+            return parseLiteral(out.boolean ? "true" : "false");
+        }
+        if (c == 'n') {
+            out.type = JsonValue::Null;
+            return parseLiteral("null");
+        }
+
+        const char* begin = text.c_str() + pos;
+        char* end = nullptr;
+        out.number = std::strtod(begin, &end);
+        if (end == begin) {
+            return false;
+        }
+        out.type = JsonValue::Number;
+        pos += static_cast<size_t>(end - begin);
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        if (!consume('"')) {
+            return false;
+        }
+        while (pos < text.size()) {
+            char c = text[pos++];
+            if (c == '"') {
+                return true;
+            }
+            if (c == '\\' && pos < text.size()) {
+                char esc = text[pos++];
+                switch (esc) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                default: out += esc; break;
+                }
+            } else {
+                out += c;
+            }
+        }
+        return false;
+    }
+
+    bool parseArray(JsonValue& out) {
+        out.type = JsonValue::Array;
+        consume('[');
+        if (consume(']')) {
+            return true;
+        }
+        do {
+            out.array.emplace_back();
+            if (!parseValue(out.array.back())) {
+                return false;
+            }
+        } while (consume(','));
+        return consume(']');
+    }
+
+    bool parseObject(JsonValue& out) {
+        out.type = JsonValue::Object;
+        consume('{');
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            skipWhitespace();
+            std::string key;
+            if (!parseString(key) || !consume(':')) {
+                return false;
+            }
+            if (!parseValue(out.object[key])) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+};
+
+void readString(const JsonValue* section, const char* key, std::string& out) {
+    const JsonValue* v = section ? section->find(key) : nullptr;
+    if (v && v->type == JsonValue::String) {
+        out = v->string;
+    }
+}
+
+template <typename T>
+void readNumber(const JsonValue* section, const char* key, T& out) {
+    const JsonValue* v = section ? section->find(key) : nullptr;
+    if (v && v->type == JsonValue::Number) {
+        out = static_cast<T>(v->number);
+    }
+}
+
+template <typename T>
+void readNumbers(const JsonValue* section, const char* key, std::vector<T>& out) {
+    const JsonValue* v = section ? section->find(key) : nullptr;
+    if (v && v->type == JsonValue::Array) {
+        out.clear();
+        for (const JsonValue& item : v->array) {
+            if (item.type == JsonValue::Number) {
+                out.push_back(static_cast<T>(item.number));
+            }
+        }
+    }
+}
+
+void readBool(const JsonValue* section, const char* key, bool& out) {
+    const JsonValue* v = section ? section->find(key) : nullptr;
+    if (v && v->type == JsonValue::Bool) {
+        out = v->boolean;
+    }
+}
+
+void readThreadTuning(const JsonValue* section, const char* key, ThreadTuning& out) {
+    const JsonValue* v = section ? section->find(key) : nullptr;
+    readNumber(v, "cpu", out.cpu);
+    readNumber(v, "realtime_priority", out.realtimePriority);
+}
+}
+
+const char* processingModeName(ProcessingMode mode) {
+    switch (mode) {
+    case ProcessingMode::Spin: return "spin";
+    case ProcessingMode::Hybrid: return "hybrid";
+    default: return "blocking";
+    }
+}
+
+bool loadSettings(const std::string& path, ConnectorSettings& settings) {
+    std::ifstream file(path);
+    if (!file) {
+        LOG_WARN("Settings file {} not found - using defaults", path);
+        return false;
+    }
+
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string text = contents.str();
+
+    JsonValue root;
+    std::string error;
+    if (!JsonParser(text).parse(root, error)) {
+        LOG_ERROR("Failed to parse {}: {}", path, error);
+        return false;
+    }
+
+    const JsonValue* gateway = root.find("ib_gateway");
+    readString(gateway, "host", settings.host);
+    readNumber(gateway, "port", settings.port);
+    readNumber(gateway, "client_id", settings.clientId);
+
+    const JsonValue* connector = root.find("connector");
+    std::string mode = processingModeName(settings.processingMode);
+    readString(connector, "processing_mode", mode);
+    if (mode == "spin") {
+        settings.processingMode = ProcessingMode::Spin;
+    } else if (mode == "hybrid") {
+        settings.processingMode = ProcessingMode::Hybrid;
+    } else if (mode == "blocking") {
+        settings.processingMode = ProcessingMode::Blocking;
+    } else {
+        LOG_WARN("Unknown processing_mode '{}' - using blocking", mode);
+        settings.processingMode = ProcessingMode::Blocking;
+    }
+    readNumber(connector, "spin_microseconds", settings.spinMicros);
+    readNumber(connector, "park_timeout_ms", settings.parkTimeoutMs);
+    readNumber(connector, "frame_queue_bytes", settings.frameQueueBytes);
+    readThreadTuning(connector, "reader_thread", settings.readerThread);
+    readThreadTuning(connector, "processing_thread", settings.processingThread);
+    readNumber(connector, "stats_interval_seconds", settings.statsIntervalSeconds);
+    readString(connector, "capture_directory", settings.captureDirectory);
+    readString(connector, "tick_history_directory", settings.tickHistoryDirectory);
+    readNumber(connector, "tick_history_queue", settings.tickHistoryQueue);
+    readNumber(connector, "tick_by_tick_ring", settings.tickByTickRing);
+    readString(connector, "contract_index_file", settings.contractIndexFile);
+    readNumber(connector, "contract_requests_per_second", settings.contractRequestsPerSecond);
+    readNumber(connector, "contract_requests_in_flight", settings.contractRequestsInFlight);
+    readBool(connector, "subscribe_pnl", settings.subscribePnl);
+    readNumber(connector, "position_mark_publish_ms", settings.positionMarkPublishMs);
+
+    const JsonValue* risk = root.find("risk");
+    readBool(risk, "enabled", settings.risk.enabled);
+    readNumber(risk, "max_order_quantity", settings.risk.maxOrderQuantity);
+    readNumber(risk, "max_order_notional", settings.risk.maxOrderNotional);
+    readNumber(risk, "max_symbol_position", settings.risk.maxSymbolPosition);
+    readNumber(risk, "max_account_position", settings.risk.maxAccountPosition);
+    readNumber(risk, "max_open_orders", settings.risk.maxOpenOrders);
+    readNumber(risk, "max_orders_per_second", settings.risk.maxOrdersPerSecond);
+    readNumber(risk, "order_burst", settings.risk.orderBurst);
+    readNumber(risk, "price_collar_percent", settings.risk.priceCollarPercent);
+    readBool(risk, "require_quote", settings.risk.requireQuote);
+
+    const JsonValue* reconnect = root.find("reconnect");
+    readBool(reconnect, "enabled", settings.reconnect.enabled);
+    readNumber(reconnect, "initial_delay_ms", settings.reconnect.initialDelayMs);
+    readNumber(reconnect, "max_delay_ms", settings.reconnect.maxDelayMs);
+    readNumber(reconnect, "jitter", settings.reconnect.jitter);
+    readNumber(reconnect, "max_attempts", settings.reconnect.maxAttempts);
+
+    const JsonValue* outbound = root.find("outbound");
+    readNumber(outbound, "messages_per_second", settings.outbound.messagesPerSecond);
+    readNumber(outbound, "burst", settings.outbound.burst);
+    readNumber(outbound, "command_queue", settings.outbound.commandQueue);
+    readThreadTuning(outbound, "sender_thread", settings.outbound.senderThread);
+
+    const JsonValue* events = root.find("events");
+    readNumber(events, "capacity", settings.events.capacity);
+
+    const JsonValue* bars = root.find("bars");
+    readNumbers(bars, "intervals_seconds", settings.bars.intervalsSeconds);
+
+    const JsonValue* historical = root.find("historical");
+    readString(historical, "directory", settings.historical.directory);
+    readNumber(historical, "max_in_flight", settings.historical.maxInFlight);
+    readNumber(historical, "requests_per_10_minutes", settings.historical.requestsPer10Minutes);
+    readNumber(historical, "same_contract_gap_ms", settings.historical.sameContractGapMs);
+    readNumber(historical, "retry_delay_seconds", settings.historical.retryDelaySeconds);
+    readNumber(historical, "pacing_backoff_seconds", settings.historical.pacingBackoffSeconds);
+    readNumber(historical, "timeout_seconds", settings.historical.timeoutSeconds);
+    readNumber(historical, "max_attempts", settings.historical.maxAttempts);
+    readNumber(historical, "progress_interval_seconds", settings.historical.progressIntervalSeconds);
+
+    const JsonValue* rotation = root.find("rotation");
+    readNumber(rotation, "lines", settings.rotation.lines);
+    readNumber(rotation, "first_ticker_id", settings.rotation.firstTickerId);
+    readNumber(rotation, "slice_ms", settings.rotation.sliceMs);
+    readNumber(rotation, "min_dwell_ms", settings.rotation.minDwellMs);
+    readNumber(rotation, "max_dwell_ms", settings.rotation.maxDwellMs);
+    readNumber(rotation, "changes_per_second", settings.rotation.changesPerSecond);
+    readNumber(rotation, "stale_after_ms", settings.rotation.staleAfterMs);
+    readBool(rotation, "pin_positions", settings.rotation.pinPositions);
+    readBool(rotation, "pin_open_orders", settings.rotation.pinOpenOrders);
+    readNumber(rotation, "max_pinned_lines", settings.rotation.maxPinnedLines);
+    readNumber(rotation, "position_weight", settings.rotation.positionWeight);
+    readNumber(rotation, "open_order_weight", settings.rotation.openOrderWeight);
+    readNumber(rotation, "volatility_weight", settings.rotation.volatilityWeight);
+    readNumber(rotation, "log_interval_seconds", settings.rotation.logIntervalSeconds);
+
+    const JsonValue* pool = root.find("pool");
+    readNumber(pool, "market_data_connections", settings.pool.marketDataConnections);
+    readNumber(pool, "first_market_data_client_id", settings.pool.firstMarketDataClientId);
+
+    return true;
+}
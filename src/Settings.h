@@ -0,0 +1,148 @@
+#pragma once
+
+#include "ThreadTuning.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// How the message processing thread waits for inbound frames.
+enum class ProcessingMode {
+    Blocking,   // park until the reader signals a new frame
+    Spin,       // busy-poll the frame queue continuously (burns one core)
+    Hybrid      // spin for spinMicros after the last frame, then park
+};
+
+// Pre-trade limits enforced by RiskGate. A limit of 0 disables that check.
+struct RiskLimits {
+    bool enabled = true;
+    double maxOrderQuantity = 10000;
+    double maxOrderNotional = 1000000;
+    double maxSymbolPosition = 50000;       // per account and symbol, worst case incl. open orders
+    double maxAccountPosition = 500000;     // per account, gross over all symbols incl. open orders
+    int maxOpenOrders = 500;
+    double maxOrdersPerSecond = 50;
+    int orderBurst = 10;
+    double priceCollarPercent = 5.0;        // limit price vs last/mid, aggressive side only
+    bool requireQuote = false;              // reject when there is no reference price
+};
+
+// Automatic reconnection after the gateway connection drops.
+struct ReconnectSettings {
+    bool enabled = true;
+    int initialDelayMs = 250;           // first retry, doubled per failed attempt
+    int maxDelayMs = 30000;
+    double jitter = 0.5;                // each delay is drawn from [delay * (1 - jitter), delay]
+    int maxAttempts = 0;                // 0 retries until disconnect()
+};
+
+// Pacing of outbound requests (OutboundScheduler).
+struct OutboundSettings {
+    double messagesPerSecond = 45;      // the gateway disconnects clients above 50/s; 0 disables pacing
+    int burst = 10;                     // messages that may go out back to back
+    size_t commandQueue = 1024;         // per lane: orders, and cancels, awaiting the sender
+    ThreadTuning senderThread;
+};
+
+// Callback event fan-out (EventRing).
+struct EventSettings {
+    size_t capacity = 65536;            // events in the ring, rounded up to a power of two
+};
+
+// OHLCV bars built from trades (BarEngine).
+struct BarSettings {
+    std::vector<int> intervalsSeconds = {1, 60};    // bar lengths; empty disables bars
+};
+
+// Historical bar downloads (HistoricalDownloader). IB applies its historical
+// limits per gateway session, so they hold across all of the downloader's connections.
+struct HistoricalSettings {
+    std::string directory = "history";  // root of the columnar bar series
+    int maxInFlight = 40;               // open requests; IB allows 50
+    int requestsPer10Minutes = 60;      // for bars of 30 seconds or less; 0 disables
+    int sameContractGapMs = 500;        // IB: fewer than 6 requests for one contract in 2 s
+    int retryDelaySeconds = 15;         // IB: no identical request within 15 s
+    int pacingBackoffSeconds = 60;      // pause of a connection after a pacing violation
+    int timeoutSeconds = 120;           // per request
+    int maxAttempts = 4;                // failed attempts at one chunk before the series is given up
+    int progressIntervalSeconds = 10;   // progress log, 0 disables
+};
+
+// Time-sliced market data over a universe larger than the account's lines
+// (SubscriptionRotator). Subscribes and cancels count against outbound pacing too.
+struct RotationSettings {
+    int lines = 90;                     // market data lines to use; keep below the account's limit
+    int firstTickerId = 2048;           // universe symbol i is quoted under firstTickerId + i
+    int sliceMs = 250;                  // how often subscriptions are reviewed
+    int minDwellMs = 2000;              // a rotating line is kept this long after its first update
+    int maxDwellMs = 10000;             // and given up after this long without one
+    double changesPerSecond = 8;        // subscribes plus cancels
+    int staleAfterMs = 60000;           // snapshots older than this are reported stale
+    bool pinPositions = true;           // held symbols keep a line
+    bool pinOpenOrders = true;          // symbols with working orders keep a line
+    int maxPinnedLines = 45;            // pinned symbols beyond this rotate like the rest
+    double positionWeight = 4;          // priority added for a held position
+    double openOrderWeight = 4;         // for working orders
+    double volatilityWeight = 0.1;      // per basis point of recent price moves
+    int logIntervalSeconds = 60;        // refresh age summary, 0 disables
+};
+
+// Extra API connections opened by ConnectionPool.
+struct PoolSettings {
+    int marketDataConnections = 0;      // 0: market data shares the order connection
+    int firstMarketDataClientId = 0;    // 0: the order connection's clientId + 1
+};
+
+struct ConnectorSettings {
+    // ib_gateway
+    std::string host = "127.0.0.1";
+    int port = 4001;
+    int clientId = 1;
+
+    // connector
+    ProcessingMode processingMode = ProcessingMode::Blocking;
+    int spinMicros = 50;
+    int parkTimeoutMs = 2000;
+    size_t frameQueueBytes = 8 * 1024 * 1024;
+    ThreadTuning readerThread;
+    ThreadTuning processingThread;
+    int statsIntervalSeconds = 60;      // periodic stats dump, 0 disables
+    std::string captureDirectory;       // record inbound frames per session, empty disables
+    std::string tickHistoryDirectory;   // columnar tick history root, empty disables
+    size_t tickHistoryQueue = 262144;   // ticks buffered between callbacks and the writer
+    size_t tickByTickRing = 8192;       // prints kept per tick-by-tick ticker, rounded up to a power of two
+    std::string contractIndexFile = "contracts.idx";    // persisted contract registry, empty keeps it in memory only
+    double contractRequestsPerSecond = 40;
+    int contractRequestsInFlight = 40;
+    bool subscribePnl = true;           // reqPnL/reqPnLSingle for every account and position
+    int positionMarkPublishMs = 100;    // republish positions for new marks and P&L at most this often
+
+    // risk
+    RiskLimits risk;
+
+    // reconnect
+    ReconnectSettings reconnect;
+
+    // outbound
+    OutboundSettings outbound;
+
+    // events
+    EventSettings events;
+
+    // bars
+    BarSettings bars;
+
+    // historical
+    HistoricalSettings historical;
+
+    // rotation
+    RotationSettings rotation;
+
+    // pool
+    PoolSettings pool;
+};
+
+// Loads settings.json. Missing keys keep their defaults; returns false (and logs)
+// if the file cannot be read or parsed.
+bool loadSettings(const std::string& path, ConnectorSettings& settings);
+
+const char* processingModeName(ProcessingMode mode);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// An immutable value with the version it was published under.
+template <typename T>
+struct Versioned {
+    uint64_t version = 0;       // 0 until the first publish
+    T value;
+};
+
+template <typename T>
+using SnapshotHandle = std::shared_ptr<const Versioned<T>>;
+
+// Single-slot RCU-style publication of an immutable, reference-counted value.
+//
+// The writer builds a new value off to the side and swaps the pointer in;
+// readers take a handle (one atomic shared_ptr load and a reference count
+// increment) and keep reading it for as long as they like while newer versions
+// are published. Nothing is copied on the read side, and changedSince() lets
+// pollers skip work with a single load when nothing was published.
+template <typename T>
+class SnapshotCell {
+public:
+    SnapshotCell()
+        : current(std::make_shared<const Versioned<T>>())
+        , latestVersion(0) {
+    }
+
+    SnapshotCell(const SnapshotCell&) = delete;
+    SnapshotCell& operator=(const SnapshotCell&) = delete;
+
+    SnapshotHandle<T> load() const {
+        return std::atomic_load_explicit(&current, std::memory_order_acquire);
+    }
+
+    uint64_t version() const { return latestVersion.load(std::memory_order_acquire); }
+    bool changedSince(uint64_t seenVersion) const { return version() != seenVersion; }
+
+    // Writers must be serialized by the caller.
+    void publish(T value) {
+        auto next = std::make_shared<Versioned<T>>();
+        next->version = latestVersion.load(std::memory_order_relaxed) + 1;
+        next->value = std::move(value);
+        uint64_t published = next->version;
+        std::atomic_store_explicit(&current, SnapshotHandle<T>(std::move(next)), std::memory_order_release);
+        latestVersion.store(published, std::memory_order_release);
+    }
+
+private:
+    SnapshotHandle<T> current;
+    std::atomic<uint64_t> latestVersion;
+};
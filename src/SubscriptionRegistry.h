@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Contract.h"
+#include "TickByTickStore.h"
+#include <map>
+
+struct DepthSubscription {
+    Contract contract;
+    int numRows = 10;
+    bool smartDepth = true;
+};
+
+struct TickByTickSubscription {
+    int tickerId = 0;
+    TickByTickType type = TickByTickType::Last;
+    Contract contract;
+};
+
+// Streaming subscriptions the application asked for, by ticker id (tick-by-tick
+// streams by request id, one per ticker and type), so they can
+// be sent again after the session to the gateway is re-established. Not
+// thread-safe; the connector guards it with its subscription mutex.
+class SubscriptionRegistry {
+public:
+    void addMarketData(int tickerId, const Contract& contract) { marketDataById[tickerId] = contract; }
+    bool removeMarketData(int tickerId) { return marketDataById.erase(tickerId) > 0; }
+    void addDepth(int tickerId, const DepthSubscription& depth) { depthById[tickerId] = depth; }
+    bool removeDepth(int tickerId) { return depthById.erase(tickerId) > 0; }
+    void addRealTimeBars(int tickerId, const Contract& contract) { realTimeBarsById[tickerId] = contract; }
+    bool removeRealTimeBars(int tickerId) { return realTimeBarsById.erase(tickerId) > 0; }
+    void addTickByTick(int reqId, const TickByTickSubscription& stream) { tickByTickByReqId[reqId] = stream; }
+    bool removeTickByTick(int reqId) { return tickByTickByReqId.erase(reqId) > 0; }
+
+    const std::map<int, Contract>& marketData() const { return marketDataById; }
+    const std::map<int, DepthSubscription>& depth() const { return depthById; }
+    const std::map<int, Contract>& realTimeBars() const { return realTimeBarsById; }
+    const std::map<int, TickByTickSubscription>& tickByTick() const { return tickByTickByReqId; }
+    size_t size() const {
+        return marketDataById.size() + depthById.size() + realTimeBarsById.size() + tickByTickByReqId.size();
+    }
+
+    void clear() {
+        marketDataById.clear();
+        depthById.clear();
+        realTimeBarsById.clear();
+        tickByTickByReqId.clear();
+    }
+
+private:
+    std::map<int, Contract> marketDataById;
+    std::map<int, DepthSubscription> depthById;
+    std::map<int, Contract> realTimeBarsById;
+    std::map<int, TickByTickSubscription> tickByTickByReqId;
+};
@@ -0,0 +1,389 @@
+#include "SubscriptionRotator.h"
+#include "Logger.h"
+#include "Clock.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+const int64_t kMillisNs = 1000000;
+const int64_t kSecondNs = 1000000000LL;
+const double kVolatilityAlpha = 0.2;            // weight of the newest move in volatilityBps
+const double kNeverRefreshedSeconds = 1e6;      // ranks never-quoted symbols ahead of any stale one
+}
+
+SubscriptionRotator::SubscriptionRotator(ConnectionPool& pool, std::vector<Contract> universe,
+                                         const RotationSettings& settings)
+    : pool(pool)
+    , settings(settings)
+    , running(false)
+    , startNs(0)
+    , tokens(0.0)
+    , lastRefillNs(0)
+    , lastLogNs(0)
+    , positionsVersion(~0ull)
+    , ordersVersion(~0ull)
+    , subscribes(0)
+    , cancels(0)
+    , deferredSlices(0) {
+    size_t capacity = pool.quoteCapacity();
+    size_t room = settings.firstTickerId >= 0 && static_cast<size_t>(settings.firstTickerId) < capacity
+        ? capacity - static_cast<size_t>(settings.firstTickerId) : 0;
+    if (universe.size() > room) {
+        LOG_ERROR("Rotation universe of {} symbols does not fit the quote store above ticker id {} - keeping {}",
+                  universe.size(), settings.firstTickerId, room);
+        universe.resize(room);
+    }
+
+    entries.reserve(universe.size());
+    for (Contract& contract : universe) {
+        Entry entry;
+        entry.tickerId = settings.firstTickerId + static_cast<int>(entries.size());
+        entry.contract = std::move(contract);
+        if (!bySymbol.emplace(entry.contract.symbol, entries.size()).second) {
+            LOG_WARN("{} is in the rotation universe twice - skipped", entry.contract.symbol);
+            continue;
+        }
+        entries.push_back(std::move(entry));
+    }
+}
+
+SubscriptionRotator::~SubscriptionRotator() {
+    stop();
+}
+
+void SubscriptionRotator::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return;
+    }
+    running = true;
+    worker = std::thread(&SubscriptionRotator::run, this);
+    LOG_INFO("Rotating {} market data lines over {} symbols", settings.lines, entries.size());
+}
+
+void SubscriptionRotator::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wakeup.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Entry& entry : entries) {
+        if (entry.live) {
+            cancel(entry);
+        }
+    }
+}
+
+void SubscriptionRotator::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        lock.unlock();
+        rotate(wallClockNanos());
+        lock.lock();
+        wakeup.wait_for(lock, std::chrono::milliseconds(std::max(1, settings.sliceMs)), [this] { return !running; });
+    }
+}
+
+void SubscriptionRotator::rotate(int64_t nowNs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (startNs == 0) {
+        startNs = nowNs;
+        lastRefillNs = nowNs;
+        lastLogNs = nowNs;
+        tokens = settings.changesPerSecond;
+    }
+
+    // Churn budget: a token bucket holding one second of changes
+    if (settings.changesPerSecond > 0) {
+        double refill = static_cast<double>(nowNs - lastRefillNs) / kSecondNs * settings.changesPerSecond;
+        tokens = std::min(std::max(2.0, settings.changesPerSecond), tokens + refill);
+        lastRefillNs = nowNs;
+    }
+
+    refreshFlags();
+    size_t live = 0;
+    for (Entry& entry : entries) {
+        if (entry.live) {
+            observe(entry, nowNs);
+            ++live;
+        }
+    }
+
+    // Pinned symbols by priority, up to their share of the lines
+    pinQueue.clear();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        Entry& entry = entries[i];
+        entry.pinned = false;
+        if ((entry.held && settings.pinPositions) || (entry.ordered && settings.pinOpenOrders)) {
+            pinQueue.push_back(i);
+        }
+    }
+    std::sort(pinQueue.begin(), pinQueue.end(),
+              [this](size_t a, size_t b) { return priority(entries[a]) > priority(entries[b]); });
+    size_t pinLimit = static_cast<size_t>(std::max(0, std::min(settings.maxPinnedLines, settings.lines)));
+    if (pinQueue.size() > pinLimit) {
+        pinQueue.resize(pinLimit);
+    }
+    for (size_t i : pinQueue) {
+        entries[i].pinned = true;
+    }
+
+    // Rotating lines, those done with their turn first, then oldest first
+    auto done = [&](const Entry& entry) {
+        int64_t heldNs = nowNs - entry.subscribedNs;
+        return (entry.updated && heldNs >= settings.minDwellMs * kMillisNs) || heldNs >= settings.maxDwellMs * kMillisNs;
+    };
+    evictable.clear();
+    idle.clear();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        if (entry.live && !entry.pinned) {
+            evictable.push_back(i);
+        } else if (!entry.live && !entry.pinned) {
+            idle.push_back(i);
+        }
+    }
+    std::sort(evictable.begin(), evictable.end(), [&](size_t a, size_t b) {
+        bool doneA = done(entries[a]);
+        bool doneB = done(entries[b]);
+        return doneA != doneB ? doneA : entries[a].subscribedNs < entries[b].subscribedNs;
+    });
+    size_t nextEviction = 0;
+    const size_t lines = static_cast<size_t>(std::max(0, settings.lines));
+    bool deferred = false;
+
+    // A line for symbol i: a free one, or the next rotating one (any, for a
+    // pinned symbol). Cancel and subscribe go out on the same connection.
+    auto assign = [&](size_t i, bool preempt) {
+        int shard = -1;
+        if (live >= lines) {
+            if (nextEviction >= evictable.size() || (!preempt && !done(entries[evictable[nextEviction]]))) {
+                return false;
+            }
+            if (!take(2)) {
+                deferred = true;
+                return false;
+            }
+            Entry& evicted = entries[evictable[nextEviction++]];
+            shard = pool.quoteShard(evicted.tickerId);
+            cancel(evicted);
+            --live;
+        } else if (!take(1)) {
+            deferred = true;
+            return false;
+        }
+        if (!subscribe(entries[i], shard, nowNs)) {
+            return false;
+        }
+        ++live;
+        return true;
+    };
+
+    for (size_t i : pinQueue) {
+        if (!entries[i].live && !assign(i, true)) {
+            break;
+        }
+    }
+
+    size_t wanted = std::min(idle.size(), lines + evictable.size());
+    std::partial_sort(idle.begin(), idle.begin() + wanted, idle.end(), [&](size_t a, size_t b) {
+        return urgency(entries[a], nowNs) > urgency(entries[b], nowNs);
+    });
+    for (size_t k = 0; k < wanted && !deferred; ++k) {
+        if (!assign(idle[k], false)) {
+            break;
+        }
+    }
+    if (deferred) {
+        ++deferredSlices;
+    }
+
+    if (settings.logIntervalSeconds > 0 && nowNs - lastLogNs >= settings.logIntervalSeconds * kSecondNs) {
+        lastLogNs = nowNs;
+        RotationStats summary = statsLocked(nowNs);
+        LOG_INFO("Rotation: {} of {} symbols live ({} pinned), {} stale, {} never quoted", summary.live,
+                 summary.universe, summary.pinned, summary.stale, summary.neverRefreshed);
+        LOG_INFO("Rotation: refresh age median {} s, p90 {} s, max {} s; {} subscribes, {} cancels",
+                 summary.medianAgeSeconds, summary.p90AgeSeconds, summary.maxAgeSeconds, summary.subscribes,
+                 summary.cancels);
+    }
+}
+
+// Held symbols and symbols with working orders, taken again only when the
+// order connection publishes new snapshots
+void SubscriptionRotator::refreshFlags() {
+    IBConnector& orders = *pool.orders();
+    if (orders.positionsVersion() != positionsVersion) {
+        IBConnector::PositionsSnapshot positions = orders.positionsSnapshot();
+        positionsVersion = positions->version;
+        for (Entry& entry : entries) {
+            entry.held = false;
+        }
+        for (const IBConnector::PositionItem& position : positions->value) {
+            auto it = bySymbol.find(position.contract.symbol);
+            if (it != bySymbol.end() && position.position != 0.0) {
+                entries[it->second].held = true;
+            }
+        }
+    }
+    if (orders.openOrdersVersion() != ordersVersion) {
+        IBConnector::OrdersSnapshot open = orders.openOrdersSnapshot();
+        ordersVersion = open->version;
+        for (Entry& entry : entries) {
+            entry.ordered = false;
+        }
+        for (const IBConnector::OrderInfo& order : open->value) {
+            auto it = bySymbol.find(order.contract().symbol);
+            if (it != bySymbol.end()) {
+                entries[it->second].ordered = true;
+            }
+        }
+    }
+}
+
+void SubscriptionRotator::observe(Entry& entry, int64_t nowNs) {
+    Quote quote = pool.getQuote(entry.tickerId);
+    if (!quote.valid()) {
+        entry.sequence = 0;         // store cleared by a reconnect
+        return;
+    }
+    if (quote.sequence == entry.sequence) {
+        return;
+    }
+    entry.sequence = quote.sequence;
+    entry.updated = true;
+    int64_t newestNs = std::max(quote.bidTimeNs, std::max(quote.askTimeNs, quote.lastTimeNs));
+    entry.refreshedNs = newestNs > 0 ? newestNs : nowNs;
+
+    double price = quote.bid > 0.0 && quote.ask > 0.0 ? (quote.bid + quote.ask) / 2 : quote.last;
+    if (price <= 0.0) {
+        return;
+    }
+    if (entry.lastPrice > 0.0) {
+        double moveBps = std::fabs(price / entry.lastPrice - 1.0) * 1e4;
+        entry.volatilityBps += kVolatilityAlpha * (moveBps - entry.volatilityBps);
+    }
+    entry.lastPrice = price;
+}
+
+double SubscriptionRotator::priority(const Entry& entry) const {
+    return 1.0 + (entry.held ? settings.positionWeight : 0.0) + (entry.ordered ? settings.openOrderWeight : 0.0) +
+           settings.volatilityWeight * entry.volatilityBps;
+}
+
+double SubscriptionRotator::urgency(const Entry& entry, int64_t nowNs) const {
+    double ageSeconds = entry.refreshedNs > 0 ? static_cast<double>(nowNs - entry.refreshedNs) / kSecondNs
+                                              : kNeverRefreshedSeconds;
+    return priority(entry) * std::max(0.0, ageSeconds);
+}
+
+bool SubscriptionRotator::subscribe(Entry& entry, int shard, int64_t nowNs) {
+    if (pool.requestMarketData(entry.tickerId, entry.contract, shard) < 0) {
+        return false;
+    }
+    entry.live = true;
+    entry.updated = false;
+    entry.subscribedNs = nowNs;
+    ++subscribes;
+    return true;
+}
+
+void SubscriptionRotator::cancel(Entry& entry) {
+    pool.cancelMarketData(entry.tickerId);
+    entry.live = false;
+    ++cancels;
+}
+
+bool SubscriptionRotator::take(int count) {
+    if (settings.changesPerSecond <= 0) {
+        return true;
+    }
+    if (tokens < count) {
+        return false;
+    }
+    tokens -= count;
+    return true;
+}
+
+int SubscriptionRotator::tickerId(const std::string& symbol) const {
+    auto it = bySymbol.find(symbol);
+    return it != bySymbol.end() ? entries[it->second].tickerId : -1;
+}
+
+bool SubscriptionRotator::snapshot(const std::string& symbol, RotatedQuote& out) const {
+    auto it = bySymbol.find(symbol);
+    if (it == bySymbol.end()) {
+        return false;
+    }
+    int64_t nowNs = wallClockNanos();
+    std::lock_guard<std::mutex> lock(mutex);
+    const Entry& entry = entries[it->second];
+    out.quote = pool.getQuote(entry.tickerId);
+    out.tickerId = entry.tickerId;
+    out.live = entry.live;
+    out.refreshedNs = entry.refreshedNs;
+    out.ageNs = entry.refreshedNs > 0 ? nowNs - entry.refreshedNs : -1;
+    out.stale = out.ageNs < 0 || out.ageNs > settings.staleAfterMs * kMillisNs;
+    return true;
+}
+
+RotationStats SubscriptionRotator::stats() const {
+    int64_t nowNs = wallClockNanos();
+    std::lock_guard<std::mutex> lock(mutex);
+    return statsLocked(nowNs);
+}
+
+RotationStats SubscriptionRotator::statsLocked(int64_t nowNs) const {
+    RotationStats summary;
+    summary.universe = entries.size();
+    summary.subscribes = subscribes;
+    summary.cancels = cancels;
+    summary.deferredSlices = deferredSlices;
+
+    std::vector<double> ages;
+    ages.reserve(entries.size());
+    for (const Entry& entry : entries) {
+        summary.live += entry.live ? 1 : 0;
+        summary.pinned += entry.pinned ? 1 : 0;
+        if (entry.refreshedNs == 0) {
+            ++summary.neverRefreshed;
+            ++summary.stale;
+            continue;
+        }
+        int64_t ageNs = nowNs - entry.refreshedNs;
+        summary.stale += ageNs > settings.staleAfterMs * kMillisNs ? 1 : 0;
+        ages.push_back(static_cast<double>(ageNs) / kSecondNs);
+    }
+    if (!ages.empty()) {
+        std::sort(ages.begin(), ages.end());
+        summary.medianAgeSeconds = ages[ages.size() / 2];
+        summary.p90AgeSeconds = ages[std::min(ages.size() - 1, ages.size() * 9 / 10)];
+        summary.maxAgeSeconds = ages.back();
+    }
+    return summary;
+}
+
+std::vector<SymbolRefresh> SubscriptionRotator::refreshAges() const {
+    int64_t nowNs = wallClockNanos();
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<SymbolRefresh> out;
+    out.reserve(entries.size());
+    for (const Entry& entry : entries) {
+        SymbolRefresh refresh;
+        refresh.symbol = entry.contract.symbol;
+        refresh.tickerId = entry.tickerId;
+        refresh.live = entry.live;
+        refresh.pinned = entry.pinned;
+        refresh.priority = priority(entry);
+        refresh.volatilityBps = entry.volatilityBps;
+        refresh.ageNs = entry.refreshedNs > 0 ? nowNs - entry.refreshedNs : -1;
+        out.push_back(std::move(refresh));
+    }
+    return out;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "ConnectionPool.h"
+#include "Settings.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// A universe symbol's last quote and how fresh it is. The quote stays in the
+// quote store while the symbol is rotated out, so it is the newest data seen,
+// not necessarily current.
+struct RotatedQuote {
+    Quote quote;
+    int tickerId = 0;
+    bool live = false;                  // subscribed right now
+    bool stale = true;                  // never refreshed, or not within staleAfterMs
+    int64_t refreshedNs = 0;            // wall clock of the newest update seen, 0 if none
+    int64_t ageNs = -1;                 // since refreshedNs; -1 if never refreshed
+};
+
+// Refresh state of one symbol, for stats.
+struct SymbolRefresh {
+    std::string symbol;
+    int tickerId = 0;
+    bool live = false;
+    bool pinned = false;
+    double priority = 0.0;
+    double volatilityBps = 0.0;
+    int64_t ageNs = -1;                 // -1 if never refreshed
+};
+
+struct RotationStats {
+    size_t universe = 0;
+    size_t live = 0;
+    size_t pinned = 0;
+    size_t neverRefreshed = 0;
+    size_t stale = 0;
+    uint64_t subscribes = 0;
+    uint64_t cancels = 0;
+    uint64_t deferredSlices = 0;        // reviews that ran out of churn budget with swaps left to do
+    double medianAgeSeconds = 0.0;      // over symbols refreshed at least once
+    double p90AgeSeconds = 0.0;
+    double maxAgeSeconds = 0.0;
+};
+
+// Time-slices market data lines over a universe larger than the account's
+// line limit.
+//
+// Universe symbol i is always quoted under ticker id firstTickerId + i, so its
+// slot in the pool's quote store keeps the last quote while the symbol is not
+// subscribed. Symbols with held positions or working orders keep a line
+// (pinned, up to maxPinnedLines); the remaining lines rotate. Every sliceMs a
+// rotating line that has been updated and held for minDwellMs (or has waited
+// maxDwellMs without an update) is handed to the idle symbol with the highest
+// priority times seconds since its last refresh, so a symbol of priority 2 is
+// refreshed about twice as often as one of priority 1. Priority is 1 plus the
+// position, open order and volatility weights that apply; volatility is an
+// average of the price moves seen between refreshes. A swap cancels and
+// subscribes on the same connection, cancel first, so the line count never
+// goes over, and swaps are held to changesPerSecond.
+class SubscriptionRotator {
+public:
+    SubscriptionRotator(ConnectionPool& pool, std::vector<Contract> universe, const RotationSettings& settings);
+    ~SubscriptionRotator();
+
+    SubscriptionRotator(const SubscriptionRotator&) = delete;
+    SubscriptionRotator& operator=(const SubscriptionRotator&) = delete;
+
+    // Reviews subscriptions on a background thread every sliceMs. stop()
+    // cancels everything the rotator subscribed.
+    void start();
+    void stop();
+
+    // One review; start() calls this, but it can also be driven directly.
+    void rotate(int64_t nowNs);
+
+    size_t universeSize() const { return entries.size(); }
+    // Ticker id of a universe symbol, -1 if not in the universe
+    int tickerId(const std::string& symbol) const;
+    bool snapshot(const std::string& symbol, RotatedQuote& out) const;
+
+    RotationStats stats() const;
+    // Every symbol of the universe, in universe order
+    std::vector<SymbolRefresh> refreshAges() const;
+
+private:
+    struct Entry {
+        Contract contract;
+        int tickerId;
+        bool live = false;
+        bool pinned = false;
+        bool held = false;
+        bool ordered = false;
+        bool updated = false;           // since the current subscribe
+        uint64_t sequence = 0;          // quote sequence last seen
+        int64_t subscribedNs = 0;
+        int64_t refreshedNs = 0;
+        double lastPrice = 0.0;
+        double volatilityBps = 0.0;
+    };
+
+    ConnectionPool& pool;
+    RotationSettings settings;
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, size_t> bySymbol;
+
+    mutable std::mutex mutex;           // entries' state and the counters
+    std::condition_variable wakeup;
+    bool running;
+    std::thread worker;
+    int64_t startNs;
+    double tokens;
+    int64_t lastRefillNs;
+    int64_t lastLogNs;
+    uint64_t positionsVersion;
+    uint64_t ordersVersion;
+    uint64_t subscribes;
+    uint64_t cancels;
+    uint64_t deferredSlices;
+
+    // Scratch, reused by rotate()
+    std::vector<size_t> pinQueue;
+    std::vector<size_t> idle;
+    std::vector<size_t> evictable;
+
+    void run();
+    void refreshFlags();
+    void observe(Entry& entry, int64_t nowNs);
+    double priority(const Entry& entry) const;
+    double urgency(const Entry& entry, int64_t nowNs) const;
+    bool subscribe(Entry& entry, int shard, int64_t nowNs);
+    void cancel(Entry& entry);
+    bool take(int count);
+    RotationStats statsLocked(int64_t nowNs) const;
+};
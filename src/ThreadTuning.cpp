@@ -0,0 +1,50 @@
+#include "ThreadTuning.h"
+#include "Logger.h"
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+
+bool applyThreadTuning(const ThreadTuning& tuning, const std::string& name) {
+    bool ok = true;
+
+#if defined(__linux__)
+    // Linux limits thread names to 15 characters
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+    if (tuning.cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(tuning.cpu, &cpus);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (rc != 0) {
+            LOG_WARN("Could not pin thread {} to CPU {}: {}", name, tuning.cpu, std::strerror(rc));
+            ok = false;
+        } else {
+            LOG_INFO("Pinned thread {} to CPU {}", name, tuning.cpu);
+        }
+    }
+#elif defined(__APPLE__)
+    pthread_setname_np(name.c_str());
+
+    if (tuning.cpu >= 0) {
+        LOG_WARN("CPU pinning is not supported on macOS (thread {})", name);
+        ok = false;
+    }
+#endif
+
+    if (tuning.realtimePriority > 0) {
+        sched_param param;
+        std::memset(&param, 0, sizeof(param));
+        param.sched_priority = tuning.realtimePriority;
+        int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (rc != 0) {
+            LOG_WARN("Could not set SCHED_FIFO priority {} on thread {}: {}",
+                     tuning.realtimePriority, name, std::strerror(rc));
+            ok = false;
+        } else {
+            LOG_INFO("Thread {} running SCHED_FIFO at priority {}", name, tuning.realtimePriority);
+        }
+    }
+
+    return ok;
+}
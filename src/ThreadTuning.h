@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+// Placement and scheduling for a latency-sensitive thread.
+// cpu < 0 leaves affinity alone; realtimePriority 0 keeps the default scheduler.
+struct ThreadTuning {
+    int cpu = -1;
+    int realtimePriority = 0;   // 1-99 selects SCHED_FIFO at that priority
+};
+
+// Applies tuning and a debugger-visible name to the calling thread.
+// Returns false if any part could not be applied (e.g. missing CAP_SYS_NICE).
+bool applyThreadTuning(const ThreadTuning& tuning, const std::string& name);
+
+// Busy-wait hint for spin loops.
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
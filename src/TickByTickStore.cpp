@@ -0,0 +1,120 @@
+#include "TickByTickStore.h"
+#include <algorithm>
+#include <cstring>
+
+const char* tickByTickTypeName(TickByTickType type) {
+    switch (type) {
+    case TickByTickType::Last: return "Last";
+    case TickByTickType::AllLast: return "AllLast";
+    case TickByTickType::BidAsk: return "BidAsk";
+    case TickByTickType::MidPoint: return "MidPoint";
+    default: return "Unknown";
+    }
+}
+
+TickByTickStore::Ring::Ring(size_t size)
+    : published(0)
+    , slots(std::make_unique<Slot[]>(size)) {
+}
+
+TickByTickStore::TickByTickStore(size_t capacity, size_t ringSize)
+    : ringCount(capacity)
+    , slotsPerRing(1)
+    , rings(new std::atomic<Ring*>[capacity]) {
+    while (slotsPerRing < ringSize) {
+        slotsPerRing <<= 1;
+    }
+    mask = slotsPerRing - 1;
+    for (size_t i = 0; i < capacity; ++i) {
+        rings[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+TickByTickStore::~TickByTickStore() = default;
+
+bool TickByTickStore::reserve(long tickerId) {
+    if (!inRange(tickerId)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(reserveMutex);
+    if (rings[tickerId].load(std::memory_order_relaxed) == nullptr) {
+        owned.push_back(std::make_unique<Ring>(slotsPerRing));
+        rings[tickerId].store(owned.back().get(), std::memory_order_release);
+    }
+    return true;
+}
+
+uint64_t TickByTickStore::append(long tickerId, const TickPrint& print) {
+    if (!inRange(tickerId)) {
+        return 0;
+    }
+    Ring* ring = rings[tickerId].load(std::memory_order_acquire);
+    if (!ring) {
+        return 0;
+    }
+
+    uint64_t words[kWords];
+    std::memcpy(words, reinterpret_cast<const char*>(&print) + sizeof(uint64_t), sizeof(words));
+
+    uint64_t sequence = ring->published.load(std::memory_order_relaxed) + 1;
+    Slot& slot = ring->slots[(sequence - 1) & mask];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; ++i) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(sequence, std::memory_order_release);
+    ring->published.store(sequence, std::memory_order_release);
+    return sequence;
+}
+
+uint64_t TickByTickStore::lastSequence(long tickerId) const {
+    if (!inRange(tickerId)) {
+        return 0;
+    }
+    const Ring* ring = rings[tickerId].load(std::memory_order_acquire);
+    return ring ? ring->published.load(std::memory_order_acquire) : 0;
+}
+
+bool TickByTickStore::readSlot(const Ring& ring, uint64_t sequence, TickPrint& out) const {
+    const Slot& slot = ring.slots[(sequence - 1) & mask];
+    if (slot.sequence.load(std::memory_order_acquire) != sequence) {
+        return false;
+    }
+    uint64_t words[kWords];
+    for (size_t i = 0; i < kWords; ++i) {
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+        return false;       // overwritten while we copied it
+    }
+    out.sequence = sequence;
+    std::memcpy(reinterpret_cast<char*>(&out) + sizeof(uint64_t), words, sizeof(words));
+    return true;
+}
+
+size_t TickByTickStore::readSince(long tickerId, uint64_t afterSequence, TickPrint* out, size_t maxPrints) const {
+    if (!inRange(tickerId) || maxPrints == 0) {
+        return 0;
+    }
+    const Ring* ring = rings[tickerId].load(std::memory_order_acquire);
+    if (!ring) {
+        return 0;
+    }
+
+    uint64_t last = ring->published.load(std::memory_order_acquire);
+    uint64_t oldest = last > slotsPerRing ? last - slotsPerRing + 1 : 1;
+    size_t count = 0;
+    for (uint64_t sequence = std::max(afterSequence + 1, oldest); sequence <= last && count < maxPrints; ++sequence) {
+        if (readSlot(*ring, sequence, out[count])) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+size_t TickByTickStore::readLast(long tickerId, size_t count, TickPrint* out) const {
+    uint64_t last = lastSequence(tickerId);
+    return readSince(tickerId, last > count ? last - count : 0, out, count);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+// reqTickByTickData streams, numbered as IB numbers them.
+enum class TickByTickType : uint8_t {
+    Last = 1,           // trades
+    AllLast = 2,        // trades, including odd lots and trades outside the NBBO
+    BidAsk = 3,
+    MidPoint = 4
+};
+
+// The tickType string reqTickByTickData expects.
+const char* tickByTickTypeName(TickByTickType type);
+
+// One tick-by-tick print. Plain data: no strings and nothing to free, so
+// prints copy with memcpy and fit one cache line.
+struct TickPrint {
+    static constexpr uint8_t kPastLimit = 1 << 0;       // trade outside the limit price range
+    static constexpr uint8_t kUnreported = 1 << 1;      // trade not reported to the tape
+    static constexpr uint8_t kBidPastLow = 1 << 2;
+    static constexpr uint8_t kAskPastHigh = 1 << 3;
+
+    uint64_t sequence;          // per ticker, from 1, across all of its tick-by-tick streams
+    int64_t timeNs;             // exchange time; IB sends whole seconds
+    int64_t receivedNs;         // wall clock when the callback ran
+    double price;               // trade price, bid, or midpoint
+    double askPrice;            // BidAsk only
+    int32_t size;               // trade size or bid size
+    int32_t askSize;            // BidAsk only
+    char exchange[8];           // trades only; NUL-terminated, longer codes are cut short
+    TickByTickType type;
+    uint8_t flags;
+    char conditions[6];         // trades: special condition codes, NUL-terminated
+};
+
+static_assert(sizeof(TickPrint) == 64, "TickPrint must stay one cache line");
+static_assert(std::is_trivially_copyable<TickPrint>::value, "TickPrint must stay plain data");
+
+// Tick-by-tick prints for every ticker id, each in a fixed-size ring.
+//
+// The single writer (the message processing thread) appends a print with a
+// handful of stores into the ticker's ring: no locks and no allocation. Every
+// ring slot is a seqlock stamped with the sequence number of the print in it,
+// so readers copy prints out without blocking the writer and simply skip any
+// slot the writer overwrote while they were reading it. A ring is allocated the
+// first time its ticker is reserved and kept, with its sequence numbers, until
+// the store is destroyed.
+class TickByTickStore {
+public:
+    TickByTickStore(size_t capacity, size_t ringSize);
+    ~TickByTickStore();
+
+    TickByTickStore(const TickByTickStore&) = delete;
+    TickByTickStore& operator=(const TickByTickStore&) = delete;
+
+    size_t capacity() const { return ringCount; }
+    size_t ringSize() const { return slotsPerRing; }
+    bool inRange(long tickerId) const { return tickerId >= 0 && static_cast<size_t>(tickerId) < ringCount; }
+
+    // Allocates the ticker's ring; call before subscribing. Safe from any thread.
+    bool reserve(long tickerId);
+
+    // Writer side - one thread only. Assigns print.sequence and returns it, or
+    // 0 when the ticker has no ring.
+    uint64_t append(long tickerId, const TickPrint& print);
+
+    // Reader side - safe from any thread, never blocks the writer.
+    // Sequence of the ticker's newest print, 0 if none.
+    uint64_t lastSequence(long tickerId) const;
+    // Copies up to maxPrints prints newer than afterSequence, oldest first.
+    // Prints already overwritten are missing from the result; a gap in the
+    // sequence numbers shows how many.
+    size_t readSince(long tickerId, uint64_t afterSequence, TickPrint* out, size_t maxPrints) const;
+    // The newest count prints still in the ring, oldest first.
+    size_t readLast(long tickerId, size_t count, TickPrint* out) const;
+
+private:
+    // The print without its sequence, as relaxed atomic words
+    static constexpr size_t kWords = (sizeof(TickPrint) - sizeof(uint64_t)) / sizeof(uint64_t);
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence{0};              // 0 while being written
+        std::atomic<uint64_t> words[kWords];
+    };
+
+    struct Ring {
+        explicit Ring(size_t size);
+
+        std::atomic<uint64_t> published;                // newest complete print
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    size_t ringCount;
+    size_t slotsPerRing;                                // a power of two
+    uint64_t mask;
+    std::unique_ptr<std::atomic<Ring*>[]> rings;        // by ticker id, null until reserved
+    std::mutex reserveMutex;
+    std::vector<std::unique_ptr<Ring>> owned;           // guarded by reserveMutex
+
+    bool readSlot(const Ring& ring, uint64_t sequence, TickPrint& out) const;
+};
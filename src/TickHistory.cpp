@@ -0,0 +1,378 @@
+#include "TickHistory.h"
+#include "Logger.h"
+#include "Clock.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <unordered_set>
+
+namespace {
+const char kPartitionMagic[8] = {'F', 'T', 'T', 'I', 'C', 'K', '1', '\0'};
+const uint32_t kPartitionFormatVersion = 1;
+const int64_t kMinuteNs = 60LL * 1000000000LL;
+const int64_t kDayNs = 24LL * 60 * kMinuteNs;
+const uint64_t kGrowRows = 1 << 20;
+const size_t kMaxEventsPerDrain = 4096;
+const size_t kIndexBytes = sizeof(TickPartitionHeader) + TickPartitionHeader::kMinutesPerDay * sizeof(int64_t);
+
+int64_t dayStartOf(int64_t timestampNs) {
+    return timestampNs - timestampNs % kDayNs;
+}
+
+std::string partitionDirectory(const std::string& root, const std::string& symbol, const std::string& day) {
+    std::string safe;
+    for (char c : symbol) {
+        bool ok = std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '-' || c == '_';
+        safe += ok ? c : '_';
+    }
+    if (safe.empty()) {
+        safe = "UNKNOWN";
+    }
+    return root + "/" + day + "/" + safe;
+}
+}
+
+std::string tickHistoryDay(int64_t timestampNs) {
+    std::time_t seconds = static_cast<std::time_t>(timestampNs / 1000000000LL);
+    std::tm tm;
+    gmtime_r(&seconds, &tm);
+    char day[16];
+    std::strftime(day, sizeof(day), "%Y%m%d", &tm);
+    return day;
+}
+
+// PartitionWriter - owned and used by the writer thread only
+
+class TickHistory::PartitionWriter {
+public:
+    ~PartitionWriter() {
+        close();
+    }
+
+    bool open(const std::string& root, const std::string& symbol, int64_t dayStart) {
+        std::string dir = partitionDirectory(root, symbol, tickHistoryDay(dayStart));
+        if (!makeDirectories(dir) || !index.openWrite(dir + "/index.bin", kIndexBytes)) {
+            return false;
+        }
+
+        TickPartitionHeader* h = header();
+        if (std::memcmp(h->magic, kPartitionMagic, sizeof(kPartitionMagic)) != 0) {
+            std::memcpy(h->magic, kPartitionMagic, sizeof(kPartitionMagic));
+            h->formatVersion = kPartitionFormatVersion;
+            h->minuteCount = TickPartitionHeader::kMinutesPerDay;
+            h->dayStartNs = dayStart;
+            h->rowCount.store(0, std::memory_order_relaxed);
+            std::strncpy(h->symbol, symbol.c_str(), sizeof(h->symbol) - 1);
+            std::fill(minuteIndex(), minuteIndex() + TickPartitionHeader::kMinutesPerDay, -1);
+        } else if (h->formatVersion != kPartitionFormatVersion || h->dayStartNs != dayStart) {
+            LOG_ERROR("Tick history partition {} has an incompatible header", dir);
+            index.close();
+            return false;
+        }
+
+        // Reopening today's partition after a restart: append after the committed rows
+        uint64_t rows = h->rowCount.load(std::memory_order_relaxed);
+        uint64_t wanted = (rows / kGrowRows + 1) * kGrowRows;
+        if (!timestamps.openWrite(dir + "/ts.col", wanted * sizeof(int64_t)) ||
+            !fields.openWrite(dir + "/field.col", wanted * sizeof(uint8_t)) ||
+            !prices.openWrite(dir + "/price.col", wanted * sizeof(double)) ||
+            !sizes.openWrite(dir + "/size.col", wanted * sizeof(int64_t))) {
+            close();
+            return false;
+        }
+        capacity = std::min({timestamps.size() / sizeof(int64_t), fields.size(),
+                             prices.size() / sizeof(double), sizes.size() / sizeof(int64_t)});
+
+        dayStartNs = dayStart;
+        lastTimestamp = rows ? column<int64_t>(timestamps)[rows - 1] : dayStart;
+        lastMinute = -1;
+        while (lastMinute + 1 < TickPartitionHeader::kMinutesPerDay && minuteIndex()[lastMinute + 1] >= 0) {
+            ++lastMinute;
+        }
+        LOG_DEBUG("Opened tick history partition {} at row {}", dir, rows);
+        return true;
+    }
+
+    bool covers(int64_t timestampNs) const {
+        return index.isOpen() && timestampNs < dayStartNs + kDayNs;
+    }
+
+    bool append(const TickEvent& event) {
+        TickPartitionHeader* h = header();
+        uint64_t row = h->rowCount.load(std::memory_order_relaxed);
+        if (row == capacity && !grow(capacity + kGrowRows)) {
+            return false;
+        }
+
+        // Keep the column sorted even if the wall clock steps backwards
+        int64_t ts = std::max(event.timestampNs, lastTimestamp);
+        lastTimestamp = ts;
+
+        int minute = static_cast<int>(std::min<int64_t>((ts - dayStartNs) / kMinuteNs, TickPartitionHeader::kMinutesPerDay - 1));
+        while (lastMinute < minute) {
+            minuteIndex()[++lastMinute] = static_cast<int64_t>(row);
+        }
+
+        column<int64_t>(timestamps)[row] = ts;
+        column<uint8_t>(fields)[row] = event.field;
+        column<double>(prices)[row] = event.price;
+        column<int64_t>(sizes)[row] = event.size;
+
+        h->rowCount.store(row + 1, std::memory_order_release);
+        return true;
+    }
+
+    void close() {
+        if (!index.isOpen()) {
+            return;
+        }
+        uint64_t rows = header()->rowCount.load(std::memory_order_relaxed);
+        timestamps.close(rows * sizeof(int64_t));
+        fields.close(rows * sizeof(uint8_t));
+        prices.close(rows * sizeof(double));
+        sizes.close(rows * sizeof(int64_t));
+        index.close();
+    }
+
+private:
+    MappedFile index;
+    MappedFile timestamps;
+    MappedFile fields;
+    MappedFile prices;
+    MappedFile sizes;
+    uint64_t capacity = 0;
+    int64_t dayStartNs = 0;
+    int64_t lastTimestamp = 0;
+    int lastMinute = -1;
+
+    TickPartitionHeader* header() { return reinterpret_cast<TickPartitionHeader*>(index.data()); }
+    int64_t* minuteIndex() { return reinterpret_cast<int64_t*>(index.data() + sizeof(TickPartitionHeader)); }
+
+    template <typename T>
+    static T* column(MappedFile& file) { return reinterpret_cast<T*>(file.data()); }
+
+    bool grow(uint64_t rows) {
+        if (!timestamps.resize(rows * sizeof(int64_t)) || !fields.resize(rows * sizeof(uint8_t)) ||
+            !prices.resize(rows * sizeof(double)) || !sizes.resize(rows * sizeof(int64_t))) {
+            return false;
+        }
+        capacity = rows;
+        return true;
+    }
+};
+
+// TickHistory
+
+TickHistory::TickHistory(const std::string& rootDirectory, size_t queueCapacity)
+    : root(rootDirectory)
+    , queue(queueCapacity)
+    , running(false)
+    , written(0)
+    , dropped(0)
+    , registryVersion(0) {
+}
+
+TickHistory::~TickHistory() {
+    stop();
+}
+
+void TickHistory::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    worker = std::thread(&TickHistory::run, this);
+    LOG_INFO("Tick history writing to {}", root);
+}
+
+void TickHistory::stop() {
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void TickHistory::registerTicker(long tickerId, const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    symbols[tickerId] = symbol;
+    registryVersion.fetch_add(1, std::memory_order_release);
+}
+
+void TickHistory::recordPrice(long tickerId, int field, double price, int64_t timestampNs) {
+    push(tickerId, field, price, 0, timestampNs);
+}
+
+void TickHistory::recordSize(long tickerId, int field, int64_t size, int64_t timestampNs) {
+    push(tickerId, field, 0.0, size, timestampNs);
+}
+
+void TickHistory::push(long tickerId, int field, double price, int64_t size, int64_t timestampNs) {
+    bool ok = queue.tryPush([&](TickEvent& event) {
+        event.timestampNs = timestampNs;
+        event.price = price;
+        event.size = size;
+        event.tickerId = static_cast<int32_t>(tickerId);
+        event.field = static_cast<uint8_t>(field);
+    });
+    if (!ok) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TickHistory::run() {
+    std::unordered_map<std::string, std::unique_ptr<PartitionWriter>> partitions;    // current day, by symbol
+    std::unordered_map<long, PartitionWriter*> byTicker;
+    std::unordered_set<std::string> failedSymbols;
+    uint64_t seenVersion = ~0ull;
+    uint64_t reportedDropped = 0;
+    int64_t lastDropReportNs = 0;
+
+    auto partitionFor = [&](const TickEvent& event) -> PartitionWriter* {
+        auto cached = byTicker.find(event.tickerId);
+        if (cached != byTicker.end() && cached->second->covers(event.timestampNs)) {
+            return cached->second;
+        }
+
+        std::string symbol;
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            auto it = symbols.find(event.tickerId);
+            symbol = it != symbols.end() ? it->second : "T" + std::to_string(event.tickerId);
+        }
+        if (failedSymbols.count(symbol)) {
+            return nullptr;
+        }
+
+        std::unique_ptr<PartitionWriter>& slot = partitions[symbol];
+        if (!slot || !slot->covers(event.timestampNs)) {
+            // Day rollover (or first tick): other tickers may point at the old partition
+            byTicker.clear();
+            slot = std::make_unique<PartitionWriter>();
+            if (!slot->open(root, symbol, dayStartOf(event.timestampNs))) {
+                LOG_ERROR("Tick history disabled for {}", symbol);
+                failedSymbols.insert(symbol);
+                slot.reset();
+                return nullptr;
+            }
+        }
+        byTicker[event.tickerId] = slot.get();
+        return slot.get();
+    };
+
+    while (running.load(std::memory_order_relaxed) || queue.sizeApprox() != 0) {
+        uint64_t version = registryVersion.load(std::memory_order_acquire);
+        if (version != seenVersion) {
+            byTicker.clear();
+            seenVersion = version;
+        }
+
+        uint64_t appended = 0;
+        size_t count = queue.drain([&](TickEvent& event) {
+            PartitionWriter* partition = partitionFor(event);
+            if (partition && partition->append(event)) {
+                ++appended;
+            } else {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }, kMaxEventsPerDrain);
+        written.fetch_add(appended, std::memory_order_relaxed);
+
+        // Report drops at most once a second
+        uint64_t droppedNow = dropped.load(std::memory_order_relaxed);
+        if (droppedNow != reportedDropped && monotonicNanos() - lastDropReportNs > 1000000000LL) {
+            LOG_WARN("Tick history dropped {} ticks (writer behind or partition unavailable)", droppedNow - reportedDropped);
+            reportedDropped = droppedNow;
+            lastDropReportNs = monotonicNanos();
+        }
+
+        if (count == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    partitions.clear();
+    LOG_INFO("Tick history stopped: {} ticks written", written.load());
+}
+
+// TickHistoryReader
+
+bool TickHistoryReader::open(const std::string& rootDirectory, const std::string& symbol, const std::string& day) {
+    std::string dir = partitionDirectory(rootDirectory, symbol, day);
+    timestamps.close();
+    fields.close();
+    prices.close();
+    sizes.close();
+
+    if (!index.openRead(dir + "/index.bin")) {
+        return false;
+    }
+    if (index.size() < kIndexBytes || std::memcmp(header().magic, kPartitionMagic, sizeof(kPartitionMagic)) != 0 ||
+        header().formatVersion != kPartitionFormatVersion) {
+        LOG_ERROR("{} is not a tick history partition", dir);
+        index.close();
+        return false;
+    }
+
+    if (header().rowCount.load(std::memory_order_acquire) == 0) {
+        return true;
+    }
+    if (!timestamps.openRead(dir + "/ts.col") || !fields.openRead(dir + "/field.col") ||
+        !prices.openRead(dir + "/price.col") || !sizes.openRead(dir + "/size.col")) {
+        index.close();
+        return false;
+    }
+    return true;
+}
+
+size_t TickHistoryReader::rowCount() const {
+    if (!index.isOpen() || !timestamps.isOpen()) {
+        return 0;
+    }
+    // Never read past what this reader has mapped, even if the writer moved on
+    return std::min<size_t>({header().rowCount.load(std::memory_order_acquire),
+                             timestamps.size() / sizeof(int64_t), fields.size(),
+                             prices.size() / sizeof(double), sizes.size() / sizeof(int64_t)});
+}
+
+TickSpan TickHistoryReader::slice(size_t begin, size_t end) const {
+    TickSpan span;
+    if (begin >= end) {
+        return span;
+    }
+    span.timestampNs = reinterpret_cast<const int64_t*>(timestamps.data()) + begin;
+    span.fields = reinterpret_cast<const uint8_t*>(fields.data()) + begin;
+    span.prices = reinterpret_cast<const double*>(prices.data()) + begin;
+    span.sizes = reinterpret_cast<const int64_t*>(sizes.data()) + begin;
+    span.count = end - begin;
+    return span;
+}
+
+TickSpan TickHistoryReader::range(int64_t fromNs, int64_t toNs) const {
+    size_t rows = rowCount();
+    if (rows == 0 || fromNs >= toNs) {
+        return TickSpan();
+    }
+
+    // Narrow the binary search to whole minutes using the index
+    const int64_t dayStart = header().dayStartNs;
+    const int64_t* minutes = minuteIndex();
+    auto minuteRow = [&](int64_t ns) -> size_t {
+        if (ns <= dayStart) {
+            return 0;
+        }
+        int64_t minute = (ns - dayStart) / kMinuteNs;
+        if (minute >= TickPartitionHeader::kMinutesPerDay || minutes[minute] < 0) {
+            return rows;
+        }
+        return std::min<size_t>(static_cast<size_t>(minutes[minute]), rows);
+    };
+
+    size_t lo = minuteRow(fromNs);
+    size_t hi = toNs - dayStart < kDayNs - kMinuteNs ? minuteRow(toNs + kMinuteNs) : rows;
+
+    const int64_t* ts = reinterpret_cast<const int64_t*>(timestamps.data());
+    size_t begin = static_cast<size_t>(std::lower_bound(ts + lo, ts + hi, fromNs) - ts);
+    size_t end = static_cast<size_t>(std::lower_bound(ts + begin, ts + hi, toNs) - ts);
+    return slice(begin, end);
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "MpscQueue.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Columnar tick history, one partition per symbol per UTC day:
+//
+//   <root>/<YYYYMMDD>/<SYMBOL>/index.bin   header + first row of every minute
+//                              ts.col      int64  receive time, ns since epoch
+//                              field.col   uint8  IB tick type
+//                              price.col   double (0 for size ticks)
+//                              size.col    int64  (0 for price ticks)
+//
+// Columns are plain arrays, so readers map them and hand out pointers without
+// copying. Rows are append-only and timestamps never decrease within a partition.
+struct TickPartitionHeader {
+    static constexpr int kMinutesPerDay = 1440;
+
+    char magic[8];                      // "FTTICK1\0"
+    uint32_t formatVersion;
+    uint32_t minuteCount;
+    int64_t dayStartNs;                 // UTC midnight
+    std::atomic<uint64_t> rowCount;     // published after the row's columns are written
+    uint64_t reserved;
+    char symbol[24];
+    // followed by int64_t minuteIndex[kMinutesPerDay], -1 where no row has reached that minute yet
+};
+
+static_assert(sizeof(TickPartitionHeader) == 64, "partition header must stay 64 bytes");
+
+// A contiguous run of rows, pointing straight into the mapped columns.
+struct TickSpan {
+    const int64_t* timestampNs = nullptr;
+    const uint8_t* fields = nullptr;
+    const double* prices = nullptr;
+    const int64_t* sizes = nullptr;
+    size_t count = 0;
+};
+
+// Zero-copy reader for one symbol/day partition. Safe to use while the
+// writer is appending; rows beyond the mapping taken at open() are picked up
+// by calling open() again.
+class TickHistoryReader {
+public:
+    bool open(const std::string& rootDirectory, const std::string& symbol, const std::string& day);
+
+    size_t rowCount() const;
+    TickSpan all() const { return slice(0, rowCount()); }
+    // Rows with fromNs <= timestamp < toNs.
+    TickSpan range(int64_t fromNs, int64_t toNs) const;
+
+private:
+    MappedFile index;
+    MappedFile timestamps;
+    MappedFile fields;
+    MappedFile prices;
+    MappedFile sizes;
+
+    const TickPartitionHeader& header() const { return *reinterpret_cast<const TickPartitionHeader*>(index.data()); }
+    const int64_t* minuteIndex() const { return reinterpret_cast<const int64_t*>(index.data() + sizeof(TickPartitionHeader)); }
+    TickSpan slice(size_t begin, size_t end) const;
+};
+
+// "YYYYMMDD" of the UTC day containing timestampNs.
+std::string tickHistoryDay(int64_t timestampNs);
+
+// Append side. The callback path only pushes a 32-byte event into a lock-free
+// queue; a background thread owns every partition file and does the writes.
+class TickHistory {
+public:
+    TickHistory(const std::string& rootDirectory, size_t queueCapacity);
+    ~TickHistory();
+
+    TickHistory(const TickHistory&) = delete;
+    TickHistory& operator=(const TickHistory&) = delete;
+
+    void start();
+    void stop();
+
+    // Associates a market data ticker id with the symbol its ticks are filed under.
+    void registerTicker(long tickerId, const std::string& symbol);
+
+    // Never block; the tick is dropped (and counted) if the writer has fallen behind.
+    void recordPrice(long tickerId, int field, double price, int64_t timestampNs);
+    void recordSize(long tickerId, int field, int64_t size, int64_t timestampNs);
+
+    uint64_t writtenCount() const { return written.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct TickEvent {
+        int64_t timestampNs;
+        double price;
+        int64_t size;
+        int32_t tickerId;
+        uint8_t field;
+    };
+
+    class PartitionWriter;
+
+    std::string root;
+    MpscQueue<TickEvent> queue;
+    std::atomic<bool> running;
+    std::thread worker;
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> dropped;
+
+    std::mutex registryMutex;
+    std::unordered_map<long, std::string> symbols;
+    std::atomic<uint64_t> registryVersion;
+
+    void run();
+    void push(long tickerId, int field, double price, int64_t size, int64_t timestampNs);
+};
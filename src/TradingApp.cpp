@@ -1,7 +1,5 @@
 #include "TradingApp.h"
 #include <iostream>
-#include <thread>
-#include <chrono>
 
 TradingApp::TradingApp() 
     : running(false)
@@ -68,8 +66,7 @@ void TradingApp::handleUserInput() {
     
     switch (choice) {
     case 1:
-        connector->requestAccountSummary();
-        std::this_thread::sleep_for(std::chrono::seconds(2));
+        connector->requestAccountSummary().wait();
         {
             auto summary = connector->getAccountSummary();
             for (const auto& item : summary) {
@@ -79,8 +76,7 @@ void TradingApp::handleUserInput() {
         break;
         
     case 2:
-        connector->requestPositions();
-        std::this_thread::sleep_for(std::chrono::seconds(2));
+        connector->requestPositions().wait();
         {
             auto positions = connector->getPositions();
             for (const auto& pos : positions) {
@@ -0,0 +1,149 @@
+#include "ConnectionPool.h"
+#include "HistoricalDownloader.h"
+#include "Logger.h"
+#include "Settings.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+std::atomic<bool> stopRequested(false);
+
+void onSignal(int) {
+    stopRequested = true;
+}
+
+void printUsage(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " --from YYYYMMDD --to YYYYMMDD [options]\n"
+              << "  --symbols A,B,C        symbols to download (US stocks on SMART)\n"
+              << "  --symbols-file PATH    one symbol per line\n"
+              << "  --bar SIZE             IB bar size, e.g. \"1 min\", \"5 secs\", \"1 day\" (default \"1 min\")\n"
+              << "  --what TYPE            TRADES, MIDPOINT, BID_ASK, ... (default TRADES)\n"
+              << "  --all-hours            include bars outside regular trading hours\n"
+              << "  --chunk-seconds N      range per request (default: the largest IB serves for the bar size)\n"
+              << "  --settings PATH        connector settings (default settings.json)\n"
+              << "\nRun the same command again to resume an interrupted download.\n";
+}
+
+void addSymbols(const std::string& list, std::vector<std::string>& symbols) {
+    std::stringstream stream(list);
+    std::string symbol;
+    while (std::getline(stream, symbol, ',')) {
+        if (!symbol.empty()) {
+            symbols.push_back(symbol);
+        }
+    }
+}
+
+bool readSymbolsFile(const std::string& path, std::vector<std::string>& symbols) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Cannot read " << path << "\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() && line[0] != '#') {
+            symbols.push_back(line);
+        }
+    }
+    return true;
+}
+}
+
+int main(int argc, char* argv[]) {
+    std::string settingsPath = "settings.json";
+    std::vector<std::string> symbols;
+    HistoricalJob job;
+    std::string from;
+    std::string to;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--symbols") == 0 && i + 1 < argc) {
+            addSymbols(argv[++i], symbols);
+        } else if (std::strcmp(argv[i], "--symbols-file") == 0 && i + 1 < argc) {
+            if (!readSymbolsFile(argv[++i], symbols)) {
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+            from = argv[++i];
+        } else if (std::strcmp(argv[i], "--to") == 0 && i + 1 < argc) {
+            to = argv[++i];
+        } else if (std::strcmp(argv[i], "--bar") == 0 && i + 1 < argc) {
+            job.barSize = argv[++i];
+        } else if (std::strcmp(argv[i], "--what") == 0 && i + 1 < argc) {
+            job.whatToShow = argv[++i];
+        } else if (std::strcmp(argv[i], "--all-hours") == 0) {
+            job.useRth = false;
+        } else if (std::strcmp(argv[i], "--chunk-seconds") == 0 && i + 1 < argc) {
+            job.chunkSeconds = std::atoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "--settings") == 0 && i + 1 < argc) {
+            settingsPath = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // A fixed range, so that running the job again resumes it
+    if (symbols.empty() || from.size() != 8 || to.size() != 8 || !parseHistoricalBarTime(from, job.startNs) ||
+        !parseHistoricalBarTime(to, job.endNs) || job.endNs <= job.startNs) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    ConnectorSettings settings;
+    loadSettings(settingsPath, settings);
+    std::signal(SIGINT, onSignal);
+
+    ConnectionPool pool(settings);
+    if (!pool.connect(settings.host, settings.port, settings.clientId)) {
+        std::cerr << "Failed to connect to " << settings.host << ":" << settings.port << "\n";
+        return 1;
+    }
+
+    std::shared_ptr<IBConnector> orders = pool.orders();
+    orders->resolveContracts(symbols);
+    for (const std::string& symbol : symbols) {
+        Contract contract;
+        contract.symbol = symbol;
+        contract.secType = "STK";
+        contract.exchange = "SMART";
+        contract.currency = "USD";
+        if (!orders->contractRegistry().qualify(contract)) {
+            LOG_WARN("{} is not a known contract - skipped", symbol);
+            continue;
+        }
+        job.contracts.push_back(contract);
+    }
+
+    // Every connection of the pool takes requests
+    std::vector<std::shared_ptr<IBConnector>> connections = {orders};
+    for (size_t i = 0; i < pool.shardCount(); ++i) {
+        if (pool.shard(i) != orders) {
+            connections.push_back(pool.shard(i));
+        }
+    }
+
+    HistoricalDownloader downloader(connections, settings.historical);
+    HistoricalProgress progress = downloader.run(job, &stopRequested);
+    pool.disconnect();
+
+    std::printf("\nfatty_backfill: %zu/%zu series complete, %zu failed\n", progress.seriesComplete, progress.series,
+                progress.seriesFailed);
+    std::printf("  bars             %llu in %.1f s (%.0f bars/s)\n", static_cast<unsigned long long>(progress.bars),
+                progress.elapsedSeconds, progress.barsPerSecond);
+    std::printf("  requests         %llu (%llu retries, %llu pacing violations)\n",
+                static_cast<unsigned long long>(progress.requests), static_cast<unsigned long long>(progress.retries),
+                static_cast<unsigned long long>(progress.pacingViolations));
+
+    Logger::instance().flush();
+    return progress.seriesComplete == progress.series ? 0 : 2;
+}
@@ -0,0 +1,595 @@
+#include "ConnectionPool.h"
+#include "IBConnector.h"
+#include "MockGateway.h"
+#include "Logger.h"
+#include "Settings.h"
+#include "Clock.h"
+#include "PortfolioAnalytics.h"
+#include "BarEngine.h"
+#include "IndicatorEngine.h"
+#include "TickByTickStore.h"
+#include "SubscriptionRotator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+struct BenchOptions {
+    std::string settingsPath = "settings.json";
+    std::string externalHost;
+    int externalPort = 0;
+    int symbols = 50;
+    double ticksPerSecond = 100000.0;
+    int warmupSeconds = 2;
+    int seconds = 10;
+    double ordersPerSecond = 0.0;
+    std::string mode;
+    int portfolioPositions = 0;
+    int barSymbols = 0;
+    int indicatorSymbols = 0;
+    int tickByTickSymbols = 0;
+    int connections = -1;       // market data connections; -1 keeps settings.json
+    int rotateLines = 0;        // rotate the symbols through this many lines instead of subscribing all
+    int bounceAfterSeconds = 0; // drop the mock's sessions this far into the measurement
+};
+
+void printUsage(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [options]\n"
+              << "  --symbols N          market data subscriptions (default 50)\n"
+              << "  --rate N             mock ticks per second (default 100000)\n"
+              << "  --seconds N          measurement window (default 10)\n"
+              << "  --warmup N           seconds discarded before measuring (default 2)\n"
+              << "  --order-rate N       limit orders per second (default 0)\n"
+              << "  --mode M             blocking | spin | hybrid (default: settings.json)\n"
+              << "  --connections N      market data connections besides the order connection (default: settings.json)\n"
+              << "  --settings PATH      connector settings (default settings.json)\n"
+              << "  --external HOST:PORT benchmark against a running gateway instead of the in-process mock\n"
+              << "  --bounce-after N     drop all mock sessions N seconds in and report the reconnect\n"
+              << "  --rotate-lines N     rotate --symbols through N market data lines and report refresh ages\n"
+              << "  --portfolio N        time portfolio risk aggregation over N synthetic positions and exit\n"
+              << "  --bars N             time 1s/1m/5m bars over N symbols, --rate trades/s for --seconds simulated minutes, and exit\n"
+              << "  --indicators N       time indicator updates over N symbols, one at a time and in batches, and exit\n"
+              << "  --tick-by-tick N     time tick-by-tick ring writes over N symbols for --seconds with readers polling, and exit\n";
+}
+
+bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0 || i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (std::strcmp(arg, "--symbols") == 0) {
+            options.symbols = std::atoi(value);
+        } else if (std::strcmp(arg, "--rate") == 0) {
+            options.ticksPerSecond = std::atof(value);
+        } else if (std::strcmp(arg, "--seconds") == 0) {
+            options.seconds = std::atoi(value);
+        } else if (std::strcmp(arg, "--warmup") == 0) {
+            options.warmupSeconds = std::atoi(value);
+        } else if (std::strcmp(arg, "--order-rate") == 0) {
+            options.ordersPerSecond = std::atof(value);
+        } else if (std::strcmp(arg, "--mode") == 0) {
+            options.mode = value;
+        } else if (std::strcmp(arg, "--connections") == 0) {
+            options.connections = std::atoi(value);
+        } else if (std::strcmp(arg, "--rotate-lines") == 0) {
+            options.rotateLines = std::atoi(value);
+        } else if (std::strcmp(arg, "--bounce-after") == 0) {
+            options.bounceAfterSeconds = std::atoi(value);
+        } else if (std::strcmp(arg, "--portfolio") == 0) {
+            options.portfolioPositions = std::atoi(value);
+        } else if (std::strcmp(arg, "--bars") == 0) {
+            options.barSymbols = std::atoi(value);
+        } else if (std::strcmp(arg, "--indicators") == 0) {
+            options.indicatorSymbols = std::atoi(value);
+        } else if (std::strcmp(arg, "--tick-by-tick") == 0) {
+            options.tickByTickSymbols = std::atoi(value);
+        } else if (std::strcmp(arg, "--settings") == 0) {
+            options.settingsPath = value;
+        } else if (std::strcmp(arg, "--external") == 0) {
+            std::string target = value;
+            size_t colon = target.rfind(':');
+            if (colon == std::string::npos) {
+                return false;
+            }
+            options.externalHost = target.substr(0, colon);
+            options.externalPort = std::atoi(target.c_str() + colon + 1);
+        } else {
+            return false;
+        }
+    }
+    return options.symbols > 0 && options.seconds > 0;
+}
+
+double processCpuSeconds() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// CPU seconds consumed by the named thread of this process (Linux only).
+double threadCpuSeconds(const std::string& name) {
+    double total = 0.0;
+#if defined(__linux__)
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) {
+        return 0.0;
+    }
+    long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        std::string base = std::string("/proc/self/task/") + entry->d_name;
+        std::string comm;
+        std::ifstream(base + "/comm") >> comm;
+        if (comm != name) {
+            continue;
+        }
+
+        // Fields after the parenthesised command: state is field 3, utime 14, stime 15
+        std::ifstream statFile(base + "/stat");
+        std::string stat((std::istreambuf_iterator<char>(statFile)), std::istreambuf_iterator<char>());
+        size_t close = stat.rfind(')');
+        if (close == std::string::npos) {
+            continue;
+        }
+        std::istringstream fields(stat.substr(close + 2));
+        std::string field;
+        unsigned long utime = 0, stime = 0;
+        for (int index = 3; fields >> field; ++index) {
+            if (index == 14) {
+                utime = std::strtoul(field.c_str(), nullptr, 10);
+            } else if (index == 15) {
+                stime = std::strtoul(field.c_str(), nullptr, 10);
+                break;
+            }
+        }
+        total += static_cast<double>(utime + stime) / ticksPerSecond;
+    }
+    closedir(dir);
+#else
+    (void)name;
+#endif
+    return total;
+}
+
+Contract benchContract(int index) {
+    Contract contract;
+    contract.symbol = "SYM" + std::to_string(index);
+    contract.secType = "STK";
+    contract.exchange = "SMART";
+    contract.currency = "USD";
+    return contract;
+}
+
+// Full and incremental refresh cost of the portfolio aggregation, no gateway involved.
+void runPortfolioBench(int positions) {
+    static const char* sectors[] = {"Technology", "Financials", "Energy", "Health Care", "Industrials"};
+    PortfolioAnalytics portfolio;
+    for (int i = 0; i < positions; ++i) {
+        std::string symbol = "SYM" + std::to_string(i % 500);
+        bool isOption = i % 3 == 0;
+        portfolio.setPosition(i, i % 2 == 0 ? "DU000001" : "DU000002", symbol, isOption,
+                              (i % 7 - 3) * 10.0, isOption ? 100.0 : 1.0, 50.0);
+        portfolio.setPrice(i, 50.0 + i % 13);
+        if (isOption) {
+            portfolio.setGreeks(i, 0.5, 0.02, 0.1, -0.05, 52.0);
+        }
+    }
+    for (int i = 0; i < 500; ++i) {
+        portfolio.setRiskFactors("SYM" + std::to_string(i), 0.8 + (i % 5) * 0.1, sectors[i % 5]);
+    }
+    portfolio.refresh();
+
+    const int rounds = 200;
+    int64_t fullNs = 0;
+    int64_t incrementalNs = 0;
+    for (int round = 0; round < rounds; ++round) {
+        for (int i = 0; i < positions; ++i) {
+            portfolio.setPrice(i, 50.0 + (i + round) % 13);
+        }
+        int64_t start = monotonicNanos();
+        portfolio.refresh();
+        fullNs += monotonicNanos() - start;
+
+        // A typical tick batch touches a handful of positions
+        for (int i = 0; i < 16; ++i) {
+            portfolio.setPrice((round * 31 + i * 97) % positions, 50.0 + round % 7);
+        }
+        start = monotonicNanos();
+        portfolio.refresh();
+        incrementalNs += monotonicNanos() - start;
+    }
+
+    const PortfolioRisk& risk = portfolio.refresh();
+    std::printf("\nfatty_bench: portfolio aggregation over %d positions (%s kernels)\n", positions,
+                risk.vectorized ? "AVX2" : "scalar");
+    std::printf("  full refresh     %8.2fus\n", fullNs / 1e3 / rounds);
+    std::printf("  16 dirty lanes   %8.2fus\n", incrementalNs / 1e3 / rounds);
+    std::printf("  net value        %.0f, delta $ %.0f, beta $ %.0f\n", risk.total.marketValue,
+                risk.total.deltaDollars, risk.total.betaDollars);
+}
+
+// Bar building over simulated time: trades spread over the symbols, the wheel
+// advanced every millisecond as the processing thread would.
+void runBarBench(int symbols, double tradesPerSecond, int seconds) {
+    uint64_t bars = 0;
+    BarEngine engine(static_cast<size_t>(symbols), {1, 60, 300}, [&bars](const BarEvent&) { ++bars; });
+
+    const int64_t stepNs = 1000000;
+    const int64_t startNs = 1700000000LL * 1000000000LL;
+    const int64_t endNs = startNs + static_cast<int64_t>(seconds) * 1000000000LL;
+    const double tradesPerStep = tradesPerSecond * stepNs / 1e9;
+    double owed = 0.0;
+    uint64_t trades = 0;
+    uint32_t rng = 12345;
+
+    int64_t cpuStart = monotonicNanos();
+    for (int64_t nowNs = startNs; nowNs < endNs; nowNs += stepNs) {
+        for (owed += tradesPerStep; owed >= 1.0; owed -= 1.0) {
+            rng = rng * 1664525u + 1013904223u;
+            int symbol = static_cast<int>(rng % static_cast<uint32_t>(symbols));
+            engine.onTradePrice(symbol, 50.0 + (rng >> 24) * 0.01, nowNs);
+            engine.onTradeSize(symbol, 100.0, nowNs);
+            ++trades;
+        }
+        engine.advance(nowNs);
+    }
+    int64_t elapsedNs = monotonicNanos() - cpuStart;
+
+    std::printf("\nfatty_bench: bars over %d symbols x 3 intervals, %d simulated seconds\n", symbols, seconds);
+    std::printf("  trades           %llu (%.0f/s)\n", static_cast<unsigned long long>(trades), tradesPerSecond);
+    std::printf("  bars published   %llu\n", static_cast<unsigned long long>(bars));
+    std::printf("  cost per trade   %8.1fns (incl. closing)\n", trades ? static_cast<double>(elapsedNs) / trades : 0.0);
+    std::printf("  share of a core  %8.2f%%\n", 100.0 * elapsedNs / (endNs - startNs));
+}
+
+// Indicator update cost per symbol: single-lane updates as trades arrive, and
+// whole-universe batches as when bars close together.
+void runIndicatorBench(int symbols) {
+    const size_t lanes = static_cast<size_t>(symbols);
+    IndicatorEngine engine(lanes);
+    std::vector<double> prices(lanes);
+    std::vector<double> volumes(lanes, 100.0);
+    uint32_t rng = 12345;
+
+    const int rounds = 500;
+    int64_t start = monotonicNanos();
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < lanes; ++i) {
+            rng = rng * 1664525u + 1013904223u;
+            engine.update(rng % lanes, 50.0 + (rng >> 24) * 0.01, 100.0);
+        }
+    }
+    double singleNs = static_cast<double>(monotonicNanos() - start) / (static_cast<double>(rounds) * lanes);
+
+    double batchNs[2] = {0.0, 0.0};
+    for (int vectorized = 0; vectorized < 2; ++vectorized) {
+        engine.setVectorized(vectorized == 1);
+        if (vectorized == 1 && !engine.vectorized()) {
+            break;
+        }
+        int64_t elapsed = 0;
+        for (int round = 0; round < rounds; ++round) {
+            for (size_t i = 0; i < lanes; ++i) {
+                rng = rng * 1664525u + 1013904223u;
+                prices[i] = 50.0 + (rng >> 24) * 0.01;
+            }
+            start = monotonicNanos();
+            engine.updateBatch(prices.data(), volumes.data(), lanes);
+            elapsed += monotonicNanos() - start;
+        }
+        batchNs[vectorized] = static_cast<double>(elapsed) / (static_cast<double>(rounds) * lanes);
+    }
+
+    IndicatorValues sample = engine.values(0);
+    std::printf("\nfatty_bench: indicators over %d symbols (EMA x2, VWAP, rolling stddev/z-score)\n", symbols);
+    std::printf("  single update    %8.2fns per symbol\n", singleNs);
+    std::printf("  batch, scalar    %8.2fns per symbol\n", batchNs[0]);
+    if (batchNs[1] > 0.0) {
+        std::printf("  batch, AVX2      %8.2fns per symbol\n", batchNs[1]);
+    }
+    std::printf("  lane 0           ema %.3f/%.3f, z %.2f\n", sample.emaFast, sample.emaSlow, sample.zscore);
+}
+
+// Tick-by-tick prints written as fast as one thread can, round robin over the
+// symbols, while one reader follows every ring by sequence and another keeps
+// taking the last 64 prints of one symbol.
+void runTickByTickBench(int symbols, int seconds) {
+    TickByTickStore store(static_cast<size_t>(symbols), 8192);
+    for (int i = 0; i < symbols; ++i) {
+        store.reserve(i);
+    }
+    std::atomic<bool> running(true);
+    std::atomic<uint64_t> followed(0);
+    std::atomic<uint64_t> missed(0);
+    std::atomic<uint64_t> snapshots(0);
+
+    std::thread follower([&] {
+        std::vector<uint64_t> seen(static_cast<size_t>(symbols), 0);
+        std::vector<TickPrint> batch(256);
+        uint64_t read = 0;
+        uint64_t gaps = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            for (int i = 0; i < symbols; ++i) {
+                size_t n = store.readSince(i, seen[i], batch.data(), batch.size());
+                if (n > 0) {
+                    gaps += batch[0].sequence - seen[i] - 1;
+                    seen[i] = batch[n - 1].sequence;
+                    read += n;
+                }
+            }
+        }
+        followed = read;
+        missed = gaps;
+    });
+    std::thread sampler([&] {
+        TickPrint last[64];
+        uint64_t taken = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            taken += store.readLast(0, 64, last) > 0 ? 1 : 0;
+        }
+        snapshots = taken;
+    });
+
+    TickPrint print = {};
+    print.type = TickByTickType::AllLast;
+    print.size = 100;
+    std::memcpy(print.exchange, "ISLAND", 7);
+    uint64_t written = 0;
+    int64_t start = monotonicNanos();
+    const int64_t endNs = start + static_cast<int64_t>(seconds) * 1000000000LL;
+    for (int64_t now = start; now < endNs; now = monotonicNanos()) {
+        for (int k = 0; k < 1024; ++k) {
+            print.receivedNs = now;
+            print.price = 50.0 + (written & 255) * 0.01;
+            store.append(static_cast<long>(written % static_cast<uint64_t>(symbols)), print);
+            ++written;
+        }
+    }
+    int64_t elapsedNs = monotonicNanos() - start;
+    running = false;
+    follower.join();
+    sampler.join();
+
+    std::printf("\nfatty_bench: tick-by-tick rings over %d symbols (%zu prints each), %d s\n", symbols,
+                store.ringSize(), seconds);
+    std::printf("  written          %llu (%.1fM prints/s, %.1fns per print)\n", static_cast<unsigned long long>(written),
+                written / (elapsedNs / 1e9) / 1e6, static_cast<double>(elapsedNs) / written);
+    std::printf("  followed         %llu (%llu overwritten before they were read)\n",
+                static_cast<unsigned long long>(followed.load()), static_cast<unsigned long long>(missed.load()));
+    std::printf("  last-64 reads    %llu\n", static_cast<unsigned long long>(snapshots.load()));
+}
+
+void printLatency(const char* name, const LatencySummary& summary) {
+    std::printf("  %-16s n=%-10llu p50=%8.2fus  p99=%8.2fus  p99.9=%8.2fus  max=%8.2fus\n", name,
+                static_cast<unsigned long long>(summary.count), summary.p50Ns / 1e3, summary.p99Ns / 1e3,
+                summary.p999Ns / 1e3, summary.maxNs / 1e3);
+}
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (options.portfolioPositions > 0) {
+        runPortfolioBench(options.portfolioPositions);
+        return 0;
+    }
+    if (options.indicatorSymbols > 0) {
+        runIndicatorBench(options.indicatorSymbols);
+        return 0;
+    }
+    if (options.tickByTickSymbols > 0) {
+        runTickByTickBench(options.tickByTickSymbols, options.seconds);
+        return 0;
+    }
+    if (options.barSymbols > 0) {
+        runBarBench(options.barSymbols, options.ticksPerSecond, options.seconds * 60);
+        return 0;
+    }
+
+    ConnectorSettings settings;
+    loadSettings(options.settingsPath, settings);
+    settings.statsIntervalSeconds = 0;
+    if (options.mode == "spin") {
+        settings.processingMode = ProcessingMode::Spin;
+    } else if (options.mode == "hybrid") {
+        settings.processingMode = ProcessingMode::Hybrid;
+    } else if (options.mode == "blocking") {
+        settings.processingMode = ProcessingMode::Blocking;
+    }
+    if (options.connections >= 0) {
+        settings.pool.marketDataConnections = options.connections;
+    }
+
+    // Per-tick logging would dominate the measurement
+    Logger::instance().setLevel(LogLevel::Warn);
+
+    std::unique_ptr<MockGateway> mock;
+    std::string host = options.externalHost;
+    int port = options.externalPort;
+    if (host.empty()) {
+        MockGatewayConfig mockConfig;
+        mockConfig.port = 0;
+        mockConfig.ticksPerSecond = options.ticksPerSecond;
+        mock = std::make_unique<MockGateway>(mockConfig);
+        port = mock->start();
+        if (port < 0) {
+            return 1;
+        }
+        host = "127.0.0.1";
+    }
+
+    ConnectionPool pool(settings);
+    if (!pool.connect(host, port, settings.clientId)) {
+        std::cerr << "Could not connect to " << host << ":" << port << std::endl;
+        return 1;
+    }
+    IBConnector& connector = *pool.orders();
+
+    std::unique_ptr<SubscriptionRotator> rotator;
+    if (options.rotateLines > 0) {
+        std::vector<Contract> universe;
+        for (int i = 1; i <= options.symbols; ++i) {
+            universe.push_back(benchContract(i));
+        }
+        settings.rotation.lines = options.rotateLines;
+        settings.rotation.logIntervalSeconds = 0;
+        rotator = std::make_unique<SubscriptionRotator>(pool, std::move(universe), settings.rotation);
+        rotator->start();
+    } else {
+        for (int i = 1; i <= options.symbols; ++i) {
+            pool.requestMarketData(i, benchContract(i));
+        }
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(options.warmupSeconds));
+
+    std::vector<ConnectorStats> before = pool.stats();
+    double cpuBefore = processCpuSeconds();
+    double readerBefore = threadCpuSeconds("ib-reader");
+    double processBefore = threadCpuSeconds("ib-process");
+    int64_t startNs = monotonicNanos();
+    int64_t endNs = startNs + static_cast<int64_t>(options.seconds) * 1000000000LL;
+
+    // Orders go out on this thread at a fixed pace; with no orders just wait
+    uint64_t ordersSent = 0;
+    uint64_t ordersRejected = 0;
+    LatencyHistogram placeOrderCall;    // risk checks, encoding and the hand-off to the sender
+    int64_t orderIntervalNs = options.ordersPerSecond > 0.0 ? static_cast<int64_t>(1e9 / options.ordersPerSecond) : 0;
+    int64_t nextOrderNs = startNs;
+    int64_t bounceNs = mock && options.bounceAfterSeconds > 0
+        ? startNs + static_cast<int64_t>(options.bounceAfterSeconds) * 1000000000LL : 0;
+    while (monotonicNanos() < endNs) {
+        if (bounceNs != 0 && monotonicNanos() >= bounceNs) {
+            mock->dropSessions();
+            bounceNs = 0;
+        }
+        if (orderIntervalNs == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            continue;
+        }
+        int64_t now = monotonicNanos();
+        if (now >= nextOrderNs) {
+            Order order;
+            order.action = (ordersSent % 2 == 0) ? "BUY" : "SELL";
+            order.orderType = "LMT";
+            order.totalQuantity = 100;
+            order.lmtPrice = 100.0;
+            Contract contract = benchContract(1 + static_cast<int>(ordersSent % options.symbols));
+            int64_t callNs = monotonicNanos();
+            OrderReject reject = connector.placeOrder(static_cast<int>(connector.allocateOrderId()), contract, order);
+            placeOrderCall.record(monotonicNanos() - callNs);
+            if (reject != OrderReject::None) {
+                ++ordersRejected;
+            }
+            ++ordersSent;
+            nextOrderNs += orderIntervalNs;
+        } else {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(nextOrderNs - now));
+        }
+    }
+
+    double elapsed = (monotonicNanos() - startNs) / 1e9;
+    std::vector<ConnectorStats> after = pool.stats();
+    // Worst case over the pool: market data connections see the first tick
+    ReconnectStats reconnect = connector.reconnectStats();
+    for (size_t i = 0; i < pool.shardCount(); ++i) {
+        if (pool.shard(i).get() == &connector) {
+            continue;
+        }
+        ReconnectStats shard = pool.shard(i)->reconnectStats();
+        reconnect.connectionLosses += shard.connectionLosses;
+        reconnect.reconnects += shard.reconnects;
+        reconnect.lastOutageNs = std::max(reconnect.lastOutageNs, shard.lastOutageNs);
+        reconnect.lastTimeToFirstTickNs = std::max(reconnect.lastTimeToFirstTickNs, shard.lastTimeToFirstTickNs);
+    }
+    double cpu = processCpuSeconds() - cpuBefore;
+    double readerCpu = threadCpuSeconds("ib-reader") - readerBefore;
+    double processCpu = threadCpuSeconds("ib-process") - processBefore;
+    RotationStats rotation;
+    if (rotator) {
+        rotation = rotator->stats();
+        rotator.reset();
+    }
+
+    pool.disconnect();
+    if (mock) {
+        mock->stop();
+    }
+
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    size_t maxQueueDepth = 0;
+    for (size_t i = 0; i < after.size(); ++i) {
+        messages += after[i].messagesTotal - before[i].messagesTotal;
+        bytes += after[i].bytesTotal - before[i].bytesTotal;
+        maxQueueDepth = std::max(maxQueueDepth, after[i].maxQueueDepth);
+    }
+
+    std::printf("\nfatty_bench: %s mode, %d symbols, %zu connection(s), %.1f s against %s:%d\n",
+                processingModeName(settings.processingMode), options.symbols, after.size(), elapsed, host.c_str(), port);
+    std::printf("  messages         %llu (%.0f msgs/s, %.1f MB/s)\n", static_cast<unsigned long long>(messages),
+                messages / elapsed, bytes / elapsed / 1e6);
+    std::printf("  max queue depth  %zu frames\n", maxQueueDepth);
+    if (mock) {
+        std::printf("  mock throttled   %llu ticks\n", static_cast<unsigned long long>(mock->ticksThrottled()));
+    }
+    if (ordersSent > 0) {
+        std::printf("  orders sent      %llu\n", static_cast<unsigned long long>(ordersSent));
+        std::printf("  orders rejected  %llu\n", static_cast<unsigned long long>(ordersRejected));
+        printLatency("placeOrder call", summarize(placeOrderCall));
+    }
+    if (reconnect.connectionLosses > 0) {
+        std::printf("  reconnect        %llu lost, %llu restored, outage %.1f ms, first tick after %.1f ms\n",
+                    static_cast<unsigned long long>(reconnect.connectionLosses),
+                    static_cast<unsigned long long>(reconnect.reconnects), reconnect.lastOutageNs / 1e6,
+                    reconnect.lastTimeToFirstTickNs / 1e6);
+    }
+    if (options.rotateLines > 0) {
+        std::printf("  rotation         %zu of %zu symbols live, %llu subscribes, %llu cancels, %llu slices short of budget\n",
+                    rotation.live, rotation.universe, static_cast<unsigned long long>(rotation.subscribes),
+                    static_cast<unsigned long long>(rotation.cancels),
+                    static_cast<unsigned long long>(rotation.deferredSlices));
+        std::printf("  refresh age      median %.1f s, p90 %.1f s, max %.1f s, %zu never quoted\n",
+                    rotation.medianAgeSeconds, rotation.p90AgeSeconds, rotation.maxAgeSeconds, rotation.neverRefreshed);
+    }
+    std::printf("  cpu              process %.1f%%, ib-reader %.1f%%, ib-process %.1f%%\n",
+                100.0 * cpu / elapsed, 100.0 * readerCpu / elapsed, 100.0 * processCpu / elapsed);
+    for (size_t i = 0; i < after.size(); ++i) {
+        if (after.size() == 1) {
+            std::printf("Latency (cumulative since connect):\n");
+        } else {
+            std::printf("Latency, %s connection%s (cumulative since connect):\n",
+                        i == 0 ? "order" : "market data", i == 0 ? "" : (" " + std::to_string(i)).c_str());
+        }
+        printLatency("queue wait", after[i].queueWait);
+        printLatency("tickPrice", after[i].callbacks[static_cast<size_t>(CallbackType::TickPrice)]);
+        printLatency("tickSize", after[i].callbacks[static_cast<size_t>(CallbackType::TickSize)]);
+        printLatency("orderStatus", after[i].callbacks[static_cast<size_t>(CallbackType::OrderStatus)]);
+        printLatency("send order", after[i].outbound.queueDelay[static_cast<size_t>(OutboundPriority::Order)]);
+        printLatency("send subscribe", after[i].outbound.queueDelay[static_cast<size_t>(OutboundPriority::Subscription)]);
+    }
+
+    Logger::instance().flush();
+    return 0;
+}
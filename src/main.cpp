@@ -1,11 +1,23 @@
 #include "IBConnector.h"
+#include "Settings.h"
 #include "Contract.h"
 #include "Order.h"
 #include <iostream>
-#include <thread>
-#include <chrono>
 #include <string>
 
+// Blocks until the request's end callback, error or timeout
+bool waitForRequest(const RequestFuture& future, const char* what) {
+    const RequestResult& result = future.get();
+    if (!result.ok()) {
+        std::cout << "⚠️  " << what << " did not complete: " << requestStatusName(result.status);
+        if (result.errorCode != 0) {
+            std::cout << " (error " << result.errorCode << ": " << result.errorMessage << ")";
+        }
+        std::cout << std::endl;
+    }
+    return result.ok();
+}
+
 void printMenu() {
     std::cout << "\n=== FattyTraders IB Connector ===" << std::endl;
     std::cout << "1. Connect to IB" << std::endl;
@@ -49,7 +61,10 @@ int main() {
     std::cout << "FattyTraders - Interactive Brokers C++ Connector" << std::endl;
     std::cout << "=================================================" << std::endl;
     
-    IBConnector connector;
+    ConnectorSettings settings;
+    loadSettings("settings.json", settings);
+    
+    IBConnector connector(settings);
     bool connected = false;
     int marketDataId = 1001;
     
@@ -85,8 +100,9 @@ int main() {
             
             if (connected) {
                 std::cout << "✅ Connected successfully!" << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(2)); // Allow time for account data
                 
+                // The gateway sends managedAccounts ahead of nextValidId, which connect() waits for
+
                 auto accounts = connector.getManagedAccounts();
                 std::cout << "Managed accounts: ";
                 for (const auto& account : accounts) {
@@ -106,9 +122,7 @@ int main() {
             }
             
             std::cout << "Requesting account summary..." << std::endl;
-            connector.requestAccountSummary();
-            
-            std::this_thread::sleep_for(std::chrono::seconds(2)); // Wait for data
+            waitForRequest(connector.requestAccountSummary(), "Account summary");
             
             auto summary = connector.getAccountSummary();
             std::cout << "\nAccount Summary:" << std::endl;
@@ -132,9 +146,7 @@ int main() {
             }
             
             std::cout << "Requesting positions..." << std::endl;
-            connector.requestPositions();
-            
-            std::this_thread::sleep_for(std::chrono::seconds(2)); // Wait for data
+            waitForRequest(connector.requestPositions(), "Positions request");
             
             auto positions = connector.getPositions();
             std::cout << "\nPositions:" << std::endl;
@@ -143,11 +155,17 @@ int main() {
             for (const auto& pos : positions) {
                 std::cout << pos.account << " | " << pos.contract.symbol 
                          << " (" << pos.contract.secType << "): " 
-                         << pos.position << " @ $" << pos.avgCost << std::endl;
+                         << pos.position << " @ $" << pos.avgCost
+                         << "  unrealized: $" << pos.unrealizedPnl
+                         << "  realized: $" << pos.realizedPnl << std::endl;
             }
             
             if (positions.empty()) {
                 std::cout << "No positions found." << std::endl;
+            } else {
+                PnlTotals pnl = connector.getPnlTotals();
+                std::cout << "Total unrealized: $" << pnl.unrealized << "  realized: $" << pnl.realized
+                          << "  daily: $" << pnl.daily << std::endl;
             }
             break;
         }
@@ -185,12 +203,16 @@ int main() {
                 Contract contract = createStockContract("AAPL");
                 Order order = createLimitOrder("BUY", 1, 100.0); // Buy 1 share at $100
                 
-                int orderId = connector.getNextValidOrderId();
+                int orderId = static_cast<int>(connector.allocateOrderId());
                 
                 std::cout << "Placing test order: BUY 1 AAPL @ $100.00 (Order ID: " << orderId << ")" << std::endl;
-                connector.placeOrder(orderId, contract, order);
+                OrderReject reject = connector.placeOrder(orderId, contract, order);
                 
-                std::cout << "Order placed! Check TWS/Gateway for confirmation." << std::endl;
+                if (reject == OrderReject::None) {
+                    std::cout << "Order placed! Check TWS/Gateway for confirmation." << std::endl;
+                } else {
+                    std::cout << "Order rejected: " << orderRejectName(reject) << std::endl;
+                }
             } else {
                 std::cout << "Order cancelled." << std::endl;
             }
@@ -204,9 +226,7 @@ int main() {
             }
             
             std::cout << "Requesting open orders..." << std::endl;
-            connector.requestAllOpenOrders();
-            
-            std::this_thread::sleep_for(std::chrono::seconds(2)); // Wait for data
+            waitForRequest(connector.requestAllOpenOrders(), "Open orders request");
             
             auto orders = connector.getOpenOrders();
             std::cout << "\nOpen Orders:" << std::endl;
@@ -214,9 +234,9 @@ int main() {
             
             for (const auto& orderInfo : orders) {
                 std::cout << "Order " << orderInfo.orderId << ": " 
-                         << orderInfo.order.action << " " << orderInfo.order.totalQuantity 
-                         << " " << orderInfo.contract.symbol 
-                         << " @ " << orderInfo.order.lmtPrice 
+                         << orderInfo.order().action << " " << orderInfo.order().totalQuantity 
+                         << " " << orderInfo.contract().symbol 
+                         << " @ " << orderInfo.order().lmtPrice 
                          << " (" << orderInfo.status << ")" << std::endl;
             }
             
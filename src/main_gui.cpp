@@ -3,6 +3,7 @@
 #include <iostream>
 #include "ConnectionStatusGUI.h"
 #include "IBConnector.h"
+#include "Settings.h"
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
@@ -11,7 +12,9 @@ int main(int argc, char *argv[]) {
     app.setStyle("Fusion");
     
     // Create IB connector instance
-    auto ibConnector = std::make_shared<IBConnector>();
+    ConnectorSettings settings;
+    loadSettings("settings.json", settings);
+    auto ibConnector = std::make_shared<IBConnector>(settings);
     
     // Create and show GUI
     ConnectionStatusGUI window;
@@ -0,0 +1,84 @@
+#include "MockGateway.h"
+#include "Logger.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace {
+std::atomic<bool> stopRequested(false);
+
+void onSignal(int) {
+    stopRequested = true;
+}
+
+void printUsage(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [options]\n"
+              << "  --port N             listen port (default 7500, 0 = ephemeral)\n"
+              << "  --rate N             ticks per second per session (default 10000)\n"
+              << "  --fill-delay-ms N    delay between order ack and fill (default 5)\n"
+              << "  --server-version N   highest server version to negotiate (default 151)\n"
+              << "  --accounts LIST      comma separated managed accounts (default DU1000001)\n";
+}
+}
+
+int main(int argc, char* argv[]) {
+    MockGatewayConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (!value) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (std::strcmp(arg, "--port") == 0) {
+            config.port = std::atoi(value);
+        } else if (std::strcmp(arg, "--rate") == 0) {
+            config.ticksPerSecond = std::atof(value);
+        } else if (std::strcmp(arg, "--fill-delay-ms") == 0) {
+            config.fillDelayMs = std::atoi(value);
+        } else if (std::strcmp(arg, "--server-version") == 0) {
+            config.maxServerVersion = std::atoi(value);
+        } else if (std::strcmp(arg, "--accounts") == 0) {
+            config.accounts = value;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+        ++i;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    MockGateway gateway(config);
+    if (gateway.start() < 0) {
+        return 1;
+    }
+
+    uint64_t lastTicks = 0;
+    int seconds = 0;
+    while (!stopRequested) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        if (++seconds % 5 != 0) {
+            continue;
+        }
+        uint64_t total = gateway.ticksSent();
+        LOG_INFO("Mock gateway: {} sessions, {} ticks/s, {} ticks throttled, {} orders",
+                 gateway.sessionCount(), (total - lastTicks) / 5, gateway.ticksThrottled(),
+                 gateway.ordersReceived());
+        lastTicks = total;
+    }
+
+    gateway.stop();
+    Logger::instance().flush();
+    return 0;
+}
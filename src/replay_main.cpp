@@ -0,0 +1,95 @@
+#include "CaptureReplay.h"
+#include "IBConnector.h"
+#include "Logger.h"
+#include "Settings.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+std::atomic<bool> stopRequested(false);
+
+void onSignal(int) {
+    stopRequested = true;
+}
+
+void printUsage(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " <capture.ftcap> [options]\n"
+              << "  --speed X          1 = recorded pace, 10 = ten times faster, 0 = as fast as possible (default 0)\n"
+              << "  --settings PATH    connector settings (default settings.json)\n"
+              << "  --verbose          keep info-level callback logging on\n";
+}
+
+void printLatency(const char* name, const LatencySummary& summary) {
+    if (summary.count == 0) {
+        return;
+    }
+    std::printf("  %-16s n=%-10llu p50=%8.2fus  p99=%8.2fus  p99.9=%8.2fus  max=%8.2fus\n", name,
+                static_cast<unsigned long long>(summary.count), summary.p50Ns / 1e3, summary.p99Ns / 1e3,
+                summary.p999Ns / 1e3, summary.maxNs / 1e3);
+}
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argv[1][0] == '-') {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::string capturePath = argv[1];
+    std::string settingsPath = "settings.json";
+    double speed = 0.0;
+    bool verbose = false;
+
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--settings") == 0 && i + 1 < argc) {
+            settingsPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    ConnectorSettings settings;
+    loadSettings(settingsPath, settings);
+    settings.captureDirectory.clear();
+
+    CaptureReplay replay;
+    if (!replay.open(capturePath)) {
+        return 1;
+    }
+
+    if (!verbose) {
+        Logger::instance().setLevel(LogLevel::Warn);
+    }
+    std::signal(SIGINT, onSignal);
+
+    // The connector is never connected; replayed frames drive its callbacks directly
+    IBConnector connector(settings);
+    ReplayResult result = replay.run(connector, speed, &stopRequested);
+    ConnectorStats stats = connector.stats();
+
+    std::printf("\nfatty_replay: %llu frames (%.1f MB) in %.3f s, recorded span %.3f s\n",
+                static_cast<unsigned long long>(result.messages), result.bytes / 1e6, result.elapsedSeconds,
+                result.recordedSeconds);
+    if (result.elapsedSeconds > 0.0) {
+        std::printf("  throughput       %.0f msgs/s\n", result.messages / result.elapsedSeconds);
+    }
+    if (speed > 0.0) {
+        std::printf("  max pacing lag   %.2f us\n", result.maxLagNs / 1e3);
+    }
+    std::printf("Callback latency:\n");
+    for (size_t i = 0; i < stats.callbacks.size(); ++i) {
+        printLatency(callbackTypeName(static_cast<CallbackType>(i)), stats.callbacks[i]);
+    }
+
+    Logger::instance().flush();
+    return 0;
+}